@@ -42,6 +42,7 @@
 #include "graphfab/sbml/autolayoutSBML.h"
 #include "graphfab/sbml/layout.h"
 #include "graphfab/layout/fr.h"
+#include "graphfab/layout/energy.h"
 
 #endif
 
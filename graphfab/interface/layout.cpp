@@ -33,6 +33,10 @@
 #include "graphfab/interface/layout.h"
 #include "graphfab/diag/error.h"
 #include "graphfab/network/network.h"
+#include "graphfab/network/import.h"
+#include "graphfab/network/patch.h"
+#include "graphfab/io/file.h"
+#include "graphfab/sbml/stream.h"
 #include "graphfab/layout/canvas.h"
 #include "graphfab/layout/box.h"
 #include "graphfab/layout/point.h"
@@ -46,6 +50,7 @@
 
 #include <exception>
 #include <typeinfo>
+#include <algorithm>
 
 #include <stdlib.h> // free SBML strings
 
@@ -64,7 +69,6 @@ void gf_freeLayoutInfoHierarch(gf_layoutInfo* l) {
     AN(l, "gf_freeLayoutInfo: unexpected null ptr");
 
     Network* net = (Network*)l->net;
-    net->hierarchRelease();
     delete net;
     Canvas *canv = (Canvas*)l->canv;
     if(canv)
@@ -226,6 +230,89 @@ gf_layoutInfo* gf_processLayout(gf_SBMLModel* lo) {
     return l;
 }
 
+/// Layout info for a network read by the streaming importer
+static gf_layoutInfo* layoutInfoFromImport(const ImportData& d) {
+    Network* net = networkFromImport(d);
+    AN(net, "Failed to construct network");
+
+    Canvas* canv = new Canvas();
+    canv->setWidth(d.haslayout ? d.width : 1024);
+    canv->setHeight(d.haslayout ? d.height : 1024);
+
+    gf_layoutInfo* l = (gf_layoutInfo*)malloc(sizeof(gf_layoutInfo));
+    gf_initLayoutInfo(l);
+    l->level = d.level;
+    l->version = d.version;
+    l->net = net;
+    l->canv = canv;
+    return l;
+}
+
+/// Build through a libSBML document (the streaming importer gave up)
+static gf_layoutInfo* layoutInfoFromSBML(gf_SBMLModel* mod) {
+    if(!mod)
+        return NULL;
+    gf_layoutInfo* l = NULL;
+    try {
+        l = gf_processLayout(mod);
+    } catch(const Exception& e) {
+        std::string msg = "gf_loadLayout: " + e.getDescription() + "\n";
+        gf_emitError(msg.c_str());
+    }
+    gf_freeSBMLModel(mod);
+    return l;
+}
+
+gf_layoutInfo* gf_loadLayoutbuf(const char* buf) {
+    try {
+        ImportData d;
+        if(readImportData(buf, d))
+            return layoutInfoFromImport(d);
+    } catch(const Exception&) {
+        // inconsistent model; let libSBML report it
+    }
+    return layoutInfoFromSBML(gf_loadSBMLbuf(buf));
+}
+
+gf_layoutInfo* gf_loadLayoutfile(const char* path) {
+    try {
+        FileContents contents;
+        if(!contents.load(path)) {
+            gf_emitError("gf_loadLayoutfile: Failed to open file\n");
+            return NULL;
+        }
+        ImportData d;
+        if(readImportData(contents.getData(), d))
+            return layoutInfoFromImport(d);
+    } catch(const Exception&) {
+        // inconsistent model; let libSBML report it
+    }
+    return layoutInfoFromSBML(gf_loadSBMLfile(path));
+}
+
+int gf_updateLayout(gf_layoutInfo* l, gf_SBMLModel* lo) {
+    Network* net = (Network*)l->net;
+    AN(net, "No network");
+    SBMLDocument* doc = (SBMLDocument*)lo->pdoc;
+    AN(doc, "No document");
+    Model* mod = doc->getModel();
+    if(!mod) {
+        gf_emitError("gf_updateLayout: no model in document\n");
+        return -1;
+    }
+
+    try {
+        uint64 n = patchNetworkFromModel(*net, *mod);
+        l->level = doc->getLevel();
+        l->version = doc->getVersion();
+        return (int)n;
+    } catch(const Exception& e) {
+        std::string msg = "gf_updateLayout: " + e.getDescription() + "\n";
+        gf_emitError(msg.c_str());
+        return -1;
+    }
+}
+
 void gf_getNodeCentroid(gf_layoutInfo* l, const char* id, CPoint* p) {
     Network* net = (Network*)l->net;
     AN(net, "No network");
@@ -272,141 +359,131 @@ int gf_aliasNode(gf_layoutInfo* l, const char* id) {
     if(!n)
         return 1;
     n->setAlias(true);
-    for(Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+    Network::AttachedRxnList rxns = net->getConnectedReactions(n);
+    for(Network::AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
         Graphfab::Reaction* r = *i;
-        if(r->hasSpecies(n)) {
-            Node* w = new Node(*n);
-            w->setGlyph(w->getGlyph() + "_" + r->getId());
-            w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
-            net->addNode(w);
-            r->substituteSpecies(n, w);
-        }
+        Node* w = new (net->getArena()) Node(*n);
+        w->setGlyph(w->getGlyph() + "_" + r->getId());
+        w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
+        net->addNode(w);
+        r->substituteSpecies(n, w);
     }
     return 0;
 }
 
+/*
+ * Each (node, reaction) pair is aliased unless detaching the node from the
+ * reaction would leave it with fewer connected species, i.e. unless the
+ * species-reaction edge is a bridge whose node-side still holds other species.
+ *
+ * Pairs are decided in node order, so aliasing an earlier node opens the
+ * cycles running through it: once a node is processed all its remaining
+ * edges are bridges and no path between two reactions of a later node can
+ * use it. The reactions of node n therefore fall into the components
+ * ("lobes") of the graph without n and without the eligible nodes before it.
+ * Sweeping the nodes in reverse and adding each one back to a disjoint-set
+ * forest yields the lobes every node sees at its turn, after which a reaction
+ * edge is a bridge exactly when it is the last remaining edge into its lobe.
+ */
 void gf_aliasNodebyDegree(gf_layoutInfo* l, int minDegree) {
     Network* net = (Network*)l->net;
     AN(net, "No network");
 
-    int a, b, nodecount1, nodecount2, size = net->getTotalNumNodes(), i = 0, aliasCount = 0;
+    const int size = (int)net->getTotalNumNodes();
+    const int nrxn = (int)net->getTotalNumRxns();
+    int aliasCount = 0;
     char aliasCountString[33];
     sprintf(aliasCountString, "%d", aliasCount);
-    std::vector<Node *> foundNodes;
-    std::vector<Graphfab::Reaction *> Rxns;
-
-    //Iterator does not work because nodes are added to the list, had to use while loop instead
-    //for(Network::NodeIt i = net->NodesBegin(); i < net->NodesEnd(); ++i) {
-    while(i < size) {
-        Graphfab::Node* n = net->getNodeAtIndex(i);
-
-        //If the node is the required minimum degree or greater and is not an alias
-        if(n->degree() >= minDegree && !n->isCentroidSet() && !n->isAlias()) {
-
-            for(Network::RxnIt c=net->RxnsBegin(); c!=net->RxnsEnd(); ++c) {
-                Graphfab::Reaction* r = *c;
-
-                if(r->hasSpecies(n)) {
-                    if(n->degree() > 1) {
-
-                        //Create a temp copy of all reactions
-                        for(Network::RxnIt d=net->RxnsBegin(); d!=net->RxnsEnd(); ++d) {
-                            Graphfab::Reaction* react = *d;
-                            Rxns.push_back(react);
-                        }
-
-                        foundNodes.push_back(n);
-
-                        //Find all nodes that are in the subgraph with node n
-                        a = 0;
-                        while(a < foundNodes.size()) {
-                            b = 0;
-                            while(b < Rxns.size()) {
-                                if(Rxns[b]->hasSpecies(foundNodes[a])) {
-                                    for(Graphfab::Reaction::NodeIt j=Rxns[b]->NodesBegin(); j!=Rxns[b]->NodesEnd(); ++j) {
-                                        Graphfab::Node* node = j->first;
-                                        for(int m = 0; m < foundNodes.size(); ++m) {
-                                            if(node == foundNodes[m]) break;
-                                            else if(m == foundNodes.size() - 1) foundNodes.push_back(node);
-                                        }
-                                    }
-                                    Rxns.erase(Rxns.begin() + b);
-                                }
-                                else {
-                                    b++;
-                                }
-                            }
-                            a++;
-                        }
-
-                        nodecount1 = foundNodes.size();
-
-                        //Create the alias node
-                        Node* w = new Node(*n);
-                        w->setGlyph(w->getGlyph() + "_" + r->getId() + "_alias_" + aliasCountString);
-                        w->set_degree(1);
-                        w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
-                        w->setAlias(true);
-                        //Substitute the alias into the current reaction, but don't add to the network
-                        r->substituteSpecies(n, w);
-                        n->set_degree(n->degree() - 1);
-
-                        Rxns.clear();
-                        foundNodes.clear();
-
-                        //Create a temp copy of all reactions
-                        for(Network::RxnIt d=net->RxnsBegin(); d!=net->RxnsEnd(); ++d) {
-                            Graphfab::Reaction* react = *d;
-                            Rxns.push_back(react);
-                        }
-
-                        foundNodes.push_back(w);
-
-                        //Find all nodes that are in the subgraph with the alias node
-                        a = 0;
-                        while(a < foundNodes.size()) {
-                            b = 0;
-                            while(b < Rxns.size()) {
-                                if(Rxns[b]->hasSpecies(foundNodes[a])) {
-                                    for(Graphfab::Reaction::NodeIt j=Rxns[b]->NodesBegin(); j!=Rxns[b]->NodesEnd(); ++j) {
-                                        Graphfab::Node* node = j->first;
-                                        for(int m = 0; m < foundNodes.size(); ++m) {
-                                            if(node == foundNodes[m]) break;
-                                            else if(m == foundNodes.size() - 1) foundNodes.push_back(node);
-                                        }
-                                    }
-                                    Rxns.erase(Rxns.begin() + b);
-                                }
-                                else {
-                                    b++;
-                                }
-                            }
-                            a++;
-                        }
-
-                        nodecount2 = foundNodes.size();
-
-
-                        if(nodecount1 > nodecount2) {
-
-                            //If we lost a node(s), reset the connection to the original
-
-                            r->substituteSpecies(w, n);
-                            n->set_degree(n->degree() + 1);
-                            delete(w);
-
-                        } else {
-                            //The node counts are equal. The alias can be kept
-                            net->addNode(w);
-                            aliasCount++;
-                            sprintf(aliasCountString, "%d", aliasCount);
-                        }
-                    }
 
-                }
+    const NetworkIncidence& snap = net->getIncidence();
+
+    // whether each reaction has more than one distinct species
+    std::vector<char> multi(nrxn, 0);
+    for(int j=0; j<nrxn; ++j) {
+        Graphfab::Reaction* r = net->getRxnAt(j);
+        for(Graphfab::Reaction::NodeIt i=r->NodesBegin(); i!=r->NodesEnd(); ++i)
+            if(i->first != r->NodesBegin()->first) {
+                multi[j] = 1;
+                break;
             }
+    }
+
+    // distinct reactions of each species in network order (entries for one
+    // reaction are adjacent in the snapshot)
+    std::vector<int> ninc(size+1, 0), inc;
+    for(int k=0; k<size; ++k) {
+        for(uint64 p=snap.nodeBegin(k); p<snap.nodeEnd(k); ++p)
+            if(p == snap.nodeBegin(k) || snap.nodeRxn(p) != snap.nodeRxn(p-1))
+                inc.push_back((int)snap.nodeRxn(p));
+        ninc[k+1] = (int)inc.size();
+    }
+
+    std::vector<char> eligible(size, 0);
+    for(int k=0; k<size; ++k) {
+        Node* n = net->getNodeAtIndex(k);
+        eligible[k] = n->degree() >= (uint64)minDegree && !n->isCentroidSet() && !n->isAlias();
+    }
+
+    // lobes: species are 0..size-1, reactions follow
+    Graphfab::DisjointSets sets;
+    sets.reset(size + nrxn);
+    for(int j=0; j<nrxn; ++j)
+        for(uint64 p=snap.rxnBegin(j); p<snap.rxnEnd(j); ++p)
+            if(!eligible[snap.rxnNode(p)])
+                sets.unite(size+j, (int)snap.rxnNode(p));
+
+    std::vector<int> lobe(inc.size());
+    for(int k=size-1; k>=0; --k) {
+        if(!eligible[k])
+            continue;
+        for(int p=ninc[k]; p<ninc[k+1]; ++p)
+            lobe[p] = (int)sets.find(size+inc[p]);
+        for(int p=ninc[k]; p<ninc[k+1]; ++p)
+            sets.unite(k, size+inc[p]);
+    }
+
+    std::vector<int> remaining(size + nrxn, 0);
+    for(int k=0; k<size; ++k) {
+        if(!eligible[k])
+            continue;
+        Graphfab::Node* n = net->getNodeAtIndex(k);
+
+        // edges of n into each lobe, and edges leading to other species
+        int nontrivial = 0;
+        for(int p=ninc[k]; p<ninc[k+1]; ++p) {
+            ++remaining[lobe[p]];
+            if(multi[inc[p]])
+                ++nontrivial;
+        }
+
+        for(int p=ninc[k]; p<ninc[k+1]; ++p) {
+            Graphfab::Reaction* r = net->getRxnAt(inc[p]);
+            if(n->degree() <= 1)
+                continue;
+
+            // a bridge may only be cut if no other species hang off n
+            bool keep = remaining[lobe[p]] > 1 || nontrivial - multi[inc[p]] == 0;
+            if(!keep)
+                continue;
+
+            //Create the alias node
+            Node* w = new (net->getArena()) Node(*n);
+            w->setGlyph(w->getGlyph() + "_" + r->getId() + "_alias_" + aliasCountString);
+            w->set_degree(1);
+            w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
+            w->setAlias(true);
+            r->substituteSpecies(n, w);
+            n->set_degree(n->degree() - 1);
+            net->addNode(w);
+            aliasCount++;
+            sprintf(aliasCountString, "%d", aliasCount);
+
+            --remaining[lobe[p]];
+            nontrivial -= multi[inc[p]];
         }
-        i++;
+
+        for(int p=ninc[k]; p<ninc[k+1]; ++p)
+            remaining[lobe[p]] = 0;
     }
     //printf("Aliases created: %d\n", aliasCount);
 }
@@ -491,8 +568,8 @@ SBMLDocument* populateSBMLdoc(gf_SBMLModel* m, gf_layoutInfo* l) {
         if(net->isSetId())
             model->setId(net->getId());
 
-        // rebuild the curves as we will need them shortly
-        net->rebuildCurves();
+        // bring the curves up to date as we will need them shortly
+        net->refreshCurves();
 
         // add compartments
         for(Network::ConstCompIt i=net->CompsBegin(); i!=net->CompsEnd(); ++i) {
@@ -934,6 +1011,22 @@ void gf_releaseNetwork(gf_network* n) {
     delete net;
 }
 
+gf_network gf_nw_clone(gf_network* n) {
+    Network* net = CastToNetwork(n->n);
+    AN(net, "No network");
+
+    gf_network r;
+    r.n = net->clone();
+    return r;
+}
+
+void gf_releaseNetworkHierarch(gf_network* n) {
+    Network* net = CastToNetwork(n->n);
+    AN(net, "No network");
+
+    delete net;
+}
+
 char* gf_nw_getId(gf_network* n) {
     Network* net = CastToNetwork(n->n);
     AN(net, "No network");
@@ -1105,10 +1198,10 @@ gf_compartment gf_nw_newCompartment(gf_network* nw, const char* id, const char*
     cd.c = NULL;
     AN(net, "No network");
 
-    std::cout << "gf_nw_newCompartment started\n";
-    Graphfab::Compartment* c = new Graphfab::Compartment();
+//     std::cout << "gf_nw_newCompartment started\n";
+    Graphfab::Compartment* c = new (net->getArena()) Graphfab::Compartment();
 
-    std::cout << "gf_nw_newCompartment setting id\n";
+//     std::cout << "gf_nw_newCompartment setting id\n";
     c->setName(name);
     if(id) {
         if(!net->findCompById(id))
@@ -1141,7 +1234,7 @@ gf_node gf_nw_newNode(gf_network* nw, const char* id, const char* name, gf_compa
     AN(net, "No network");
 
 //     std::cout << "gf_nw_newNode started\n";
-    Node* n = new Node();
+    Node* n = new (net->getArena()) Node();
 
 //     std::cout << "gf_nw_newNode setting id\n";
     n->setName(name);
@@ -1185,7 +1278,7 @@ gf_node gf_nw_aliasOf(gf_network* nw, gf_node* srcnode) {
     AN(net, "No network");
 
 //     std::cout << "gf_nw_newNode started\n";
-    Node* n = new Node();
+    Node* n = new (net->getArena()) Node();
 
 //     std::cout << "gf_nw_newNode setting id\n";
     n->setName(src->getName());
@@ -1281,6 +1374,89 @@ int gf_nw_connectNodeRoleStr(gf_network* nw, gf_node* n, gf_reaction* r, const c
     return gf_nw_connectNode(nw, n, r, role);
 }
 
+int gf_nw_build(gf_network* nw,
+                uint64_t nspecies, const char* const* species_ids, const int64_t* species_comps,
+                uint64_t ncomps, const char* const* comp_ids,
+                uint64_t nrxns, const char* const* rxn_ids,
+                uint64_t nrefs, const uint64_t* ref_rxns, const uint64_t* ref_species, const gf_specRole* ref_roles) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+
+    std::vector<RxnRoleType> roles(nrefs);
+    for(uint64_t k=0; k<nrefs; ++k) {
+        if(ref_roles[k] < GF_ROLE_SUBSTRATE || ref_roles[k] > GF_ROLE_INHIBITOR) {
+            gf_emitError("gf_nw_build: unknown role type\n");
+            return -1;
+        }
+        roles[k] = gf_specRole2RxnRoleType(ref_roles[k]);
+    }
+
+    try {
+        net->build(nspecies, species_ids, species_comps, ncomps, comp_ids, nrxns, rxn_ids,
+                   nrefs, ref_rxns, ref_species, nrefs ? &roles[0] : NULL);
+    } catch(const Exception& e) {
+        std::string msg = "gf_nw_build: " + e.getDescription() + "\n";
+        gf_emitError(msg.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+void gf_nw_setJournalEnabled(gf_network* nw, int enable) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    net->getJournal().setEnabled(enable ? true : false);
+}
+
+void gf_nw_setJournalMemoryLimit(gf_network* nw, uint64_t bytes) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    net->getJournal().setMemoryLimit(bytes);
+}
+
+void gf_nw_beginEdit(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    net->getJournal().beginGroup();
+}
+
+void gf_nw_endEdit(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    net->getJournal().endGroup();
+}
+
+void gf_nw_sealEdit(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    net->getJournal().seal();
+}
+
+int gf_nw_undo(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    return net->getJournal().undo() ? 1 : 0;
+}
+
+int gf_nw_redo(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    return net->getJournal().redo() ? 1 : 0;
+}
+
+int gf_nw_canUndo(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    return net->getJournal().canUndo() ? 1 : 0;
+}
+
+int gf_nw_canRedo(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net, "No network");
+    return net->getJournal().canRedo() ? 1 : 0;
+}
+
 int gf_nw_isNodeConnected(gf_network* nw, gf_node* n, gf_reaction* r) {
     Network* net = CastToNetwork(nw->n);
     Node* node = CastToNode(n->n);
@@ -1303,6 +1479,36 @@ int gf_nw_isLayoutSpecified(gf_network* nw) {
         return 0;
 }
 
+int gf_nw_getNumSubgraphs(gf_network* nw) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net && net->doByteCheck(), "Not a network");
+
+    return net->getNumConnectedSubgraphs();
+}
+
+uint64_t gf_nw_getSubgraphSize(gf_network* nw, int i) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net && net->doByteCheck(), "Not a network");
+
+    if (i < 0 || i >= net->getNumConnectedSubgraphs()) {
+        gf_emitError("gf_nw_getSubgraphSize: No such subgraph");
+        return 0;
+    }
+    return net->getConnectedSubgraphSize(i);
+}
+
+int gf_node_getSubgraph(gf_network* nw, gf_node* n) {
+    Network* net = CastToNetwork(nw->n);
+    AN(net && net->doByteCheck(), "Not a network");
+    Node* node = CastToNode(n->n);
+    AN(node && node->doByteCheck(), "Not a node");
+
+    int k = net->getConnectedSubgraph(node);
+    if (k < 0)
+        gf_emitError("gf_node_getSubgraph: Node is not in network");
+    return k;
+}
+
 int gf_nw_getNumInstances(gf_network* nw, gf_node* n) {
     Network* net = CastToNetwork(nw->n);
     AN(net && net->doByteCheck(), "Not a network");
@@ -1477,11 +1683,11 @@ void gf_node_setHeight(gf_node* n, double height) {
     node->affectGlobalHeight(height);
 }
 
-char* gf_node_getID(gf_node* n) {
+const char* gf_node_getID(gf_node* n) {
     Node* node = CastToNode(n->n);
     AN(node && node->doByteCheck(), "Not a node");
 
-    return gf_strclone(node->getId().c_str());
+    return node->getId().c_str();
 }
 
 void gf_node_setID(gf_node* n, const char* id) {
@@ -1611,10 +1817,10 @@ gf_reaction gf_nw_newReaction(gf_network* nw, const char* id, const char* name)
     rxn.r = NULL;
     AN(net, "No network");
 
-    std::cout << "gf_nw_newReaction started\n";
-    Graphfab::Reaction* r = new Graphfab::Reaction();
+//     std::cout << "gf_nw_newReaction started\n";
+    Graphfab::Reaction* r = new (net->getArena()) Graphfab::Reaction();
 
-    std::cout << "gf_nw_newReaction setting id\n";
+//     std::cout << "gf_nw_newReaction setting id\n";
     r->setName(name);
     if(id) {
         if(!net->findReactionById(id))
@@ -1640,12 +1846,12 @@ gf_reaction* gf_nw_newReactionp(gf_network* nw, const char* id, const char* name
     return r;
 }
 
-char* gf_reaction_getID(gf_reaction* r) {
+const char* gf_reaction_getID(gf_reaction* r) {
     Graphfab::Reaction* rxn = (Graphfab::Reaction*) r->r;
     AN(rxn, "No rxn");
     AT(rxn->doByteCheck(), "Type verification failed");
 
-    return gf_strclone(rxn->getId().c_str());
+    return rxn->getId().c_str();
 }
 
 // reaction.centroid
@@ -2001,8 +2207,7 @@ int gf_compartment_containsNode(gf_compartment* c, gf_node* n) {
         return -1;
     }
 
-    comp->contains(node);
-    return 0;
+    return comp->contains(node) ? 1 : 0;
 }
 
 int gf_compartment_containsReaction(gf_compartment* c, gf_reaction* r) {
@@ -2016,8 +2221,7 @@ int gf_compartment_containsReaction(gf_compartment* c, gf_reaction* r) {
         return -1;
     }
 
-    comp->contains(rxn);
-    return 0;
+    return comp->contains(rxn) ? 1 : 0;
 }
 
 void gf_fit_to_window(gf_layoutInfo* l, double left, double top, double right, double bottom) {
@@ -2075,7 +2279,7 @@ void gf_moveNetworkToFirstQuad(gf_layoutInfo* l, double x_disp, double y_disp) {
     Graphfab::Box bbox = net->getBoundingBox();
 
     net->applyDisplacement(-bbox.getMin() + Graphfab::Point(x_disp, y_disp));
-    net->rebuildCurves();
+    net->refreshCurves();
 }
 
 CPoint gf_tf_apply_to_point(gf_transform* tf, CPoint p) {
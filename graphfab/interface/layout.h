@@ -292,6 +292,46 @@ _GraphfabExport gf_layoutInfo* gf_layoutInfo_newp(uint64_t level, uint64_t versi
  */
 _GraphfabExport gf_layoutInfo* gf_processLayout(gf_SBMLModel* lo);
 
+/**
+ *  @brief Load SBML from a memory buffer and process the layout info in one step
+ *  @details Equivalent to @ref gf_loadSBMLbuf followed by @ref gf_processLayout, but
+ *  reads only the compartments, species, reactions and layout glyphs straight from
+ *  the text, without building a libSBML document. Documents this cannot handle
+ *  (level 1, undefined glyph roles etc.) are passed to libSBML instead. Unlike
+ *  libSBML, the document is not validated.
+ *  @param[in] buf The buffer containing the SBML file
+ *  @return The layout info, or NULL on error
+ *  @warning Call @ref gf_freeLayoutInfo to free the returned pointer.
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_layoutInfo* gf_loadLayoutbuf(const char* buf);
+
+/**
+ *  @brief Same as @ref gf_loadLayoutbuf but read the SBML from a file
+ *  @param[in] path The SBML file
+ *  @return The layout info, or NULL on error
+ *  @warning Call @ref gf_freeLayoutInfo to free the returned pointer.
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_layoutInfo* gf_loadLayoutfile(const char* path);
+
+/**
+ *  @brief Update layout info after the model was edited
+ *  @details Matches the species, reactions and compartments of @a lo against the
+ *  network of @a l by id and applies only the differences (additions, removals,
+ *  role and compartment changes). Unchanged elements keep their positions, so
+ *  re-importing a slightly edited model does not discard the layout. New
+ *  elements are placed next to the elements they are attached to. Handles to
+ *  removed elements become invalid.
+ *  @note The update cannot be undone: it clears the undo history of the network
+ *  (see @ref gf_nw_setJournalEnabled).
+ *  @param[in,out] l The layout info, e.g. from an earlier call to @ref gf_processLayout
+ *  @param[in] lo The updated SBML model
+ *  @return The number of changes applied, or -1 on error
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_updateLayout(gf_layoutInfo* l, gf_SBMLModel* lo);
+
 /**
  *  @deprecated DEPRECATED
  *  @brief [DEPRECATED] Load SBML document from memory buffer and process
@@ -355,11 +395,31 @@ _GraphfabExport gf_network* gf_getNetworkp(gf_layoutInfo* l);
 _GraphfabExport void gf_clearNetwork(gf_network* n);
 
 /** @brief Release the network
+ *  @details Frees the nodes, reactions and compartments in the network along with it,
+ *  so handles to them are no longer valid afterwards. Elements removed from the network
+ *  beforehand are not freed; release them with @ref gf_releaseNode etc.
  *  @param[in] n The network object
  *  \ingroup C_API
  */
 _GraphfabExport void gf_releaseNetwork(gf_network* n);
 
+/** @brief Deep copy of a network
+ *  @details The copy shares nothing with the original, so both can be laid out
+ *  or edited independently (e.g. to try alternative layouts in parallel, or to
+ *  keep a snapshot before a destructive operation).
+ *  @note Release with @ref gf_releaseNetworkHierarch
+ *  @param[in] n The network object
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_network gf_nw_clone(gf_network* n);
+
+/** @brief Release the network and all contained elements
+ *  @details Same as @ref gf_releaseNetwork.
+ *  @param[in] n The network object
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_releaseNetworkHierarch(gf_network* n);
+
 /** @brief Get the id of the network (i.e. the SBML model)
  *  @details The id of the network is determined by the SBML model object
  *  @note Memory must be freed by caller
@@ -582,6 +642,91 @@ _GraphfabExport int gf_nw_connectNode(gf_network* nw, gf_node* node, gf_reaction
  */
 _GraphfabExport int gf_nw_connectNodeRoleStr(gf_network* nw, gf_node* n, gf_reaction* r, const char* role_str);
 
+/** @brief Build the contents of an empty network from flat arrays
+ *  @details Equivalent to creating the compartments, species and reactions one
+ *  at a time with @ref gf_nw_newCompartment, @ref gf_nw_newNode and
+ *  @ref gf_nw_newReaction and connecting them with @ref gf_nw_connectNode, but
+ *  validates the input in one pass, reserves storage up front and allocates no
+ *  handles, so it runs in time linear in the size of the input. Names are set
+ *  to the ids. On invalid input nothing is added to the network.
+ *  @param[in] nw The network object (must be empty)
+ *  @param[in] nspecies Number of species
+ *  @param[in] species_ids Unique ids of the species
+ *  @param[in] species_comps For each species the index in @a comp_ids of its compartment, or -1 for none (may be NULL)
+ *  @param[in] ncomps Number of compartments
+ *  @param[in] comp_ids Unique ids of the compartments
+ *  @param[in] nrxns Number of reactions
+ *  @param[in] rxn_ids Unique ids of the reactions
+ *  @param[in] nrefs Number of species references
+ *  @param[in] ref_rxns For each species reference the index of the reaction
+ *  @param[in] ref_species For each species reference the index of the species
+ *  @param[in] ref_roles For each species reference the role
+ *  @return Zero on success, nonzero on error
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_nw_build(gf_network* nw,
+                                uint64_t nspecies, const char* const* species_ids, const int64_t* species_comps,
+                                uint64_t ncomps, const char* const* comp_ids,
+                                uint64_t nrxns, const char* const* rxn_ids,
+                                uint64_t nrefs, const uint64_t* ref_rxns, const uint64_t* ref_species, const gf_specRole* ref_roles);
+
+/** @brief Start or stop recording edits for undo/redo
+ *  @details While enabled, moves and resizes, added and removed nodes and
+ *  reactions, connections and alias flag changes are recorded as small deltas.
+ *  Consecutive moves of the same elements are merged into one step. Stopping
+ *  discards the history. Removed elements must not be freed while the history
+ *  may refer to them.
+ *  @param[in] nw The network object
+ *  @param[in] enable Nonzero to enable
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_nw_setJournalEnabled(gf_network* nw, int enable);
+
+/** @brief Limit the memory used by the undo history
+ *  @details The oldest steps are dropped once the limit is exceeded.
+ *  @param[in] nw The network object
+ *  @param[in] bytes The limit in bytes
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_nw_setJournalMemoryLimit(gf_network* nw, uint64_t bytes);
+
+/** @brief Begin a group of edits that are undone as one step (groups may nest)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_nw_beginEdit(gf_network* nw);
+
+/** @brief End a group started with @ref gf_nw_beginEdit
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_nw_endEdit(gf_network* nw);
+
+/** @brief Stop merging further moves into the last step (e.g. at the end of a drag)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_nw_sealEdit(gf_network* nw);
+
+/** @brief Undo the last step
+ *  @return 1 if a step was undone, 0 if there was none
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_nw_undo(gf_network* nw);
+
+/** @brief Redo the last undone step
+ *  @return 1 if a step was redone, 0 if there was none
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_nw_redo(gf_network* nw);
+
+/** @brief Nonzero if there is a step to undo
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_nw_canUndo(gf_network* nw);
+
+/** @brief Nonzero if there is a step to redo
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_nw_canRedo(gf_network* nw);
+
 /** @brief Return whether the given node is connected to the given reaction
  *  @param[in] nw The network object
  *  @param[in] node The node to connect
@@ -598,6 +743,32 @@ _GraphfabExport int gf_nw_isNodeConnected(gf_network* nw, gf_node* node, gf_reac
  */
 _GraphfabExport int gf_nw_isLayoutSpecified(gf_network* nw);
 
+/** @brief Get the number of connected subgraphs in the network
+ *  @details Two nodes belong to the same subgraph if they are linked by a chain
+ *  of reactions. Subgraphs are numbered from zero in the order their first node
+ *  appears in the network.
+ *  @param[in] nw The network object
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_nw_getNumSubgraphs(gf_network* nw);
+
+/** @brief Get the number of nodes in a subgraph
+ *  @param[in] nw The network object
+ *  @param[in] i The subgraph index
+ *  @return The number of nodes, or 0 if there is no such subgraph
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_nw_getSubgraphSize(gf_network* nw, int i);
+
+/** @brief Get the index of the subgraph a node belongs to
+ *  @details See @ref gf_nw_getNumSubgraphs.
+ *  @param[in] nw The network object
+ *  @param[in] n The node object
+ *  @return The subgraph index, or -1 if the node is not in the network
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_node_getSubgraph(gf_network* nw, gf_node* n);
+
 /** @brief Get the number of instances of the node
  *  @param[in] nw The network object
  *  @param[in] n The node object
@@ -750,11 +921,15 @@ _GraphfabExport double gf_node_getHeight(gf_node* n);
  */
 _GraphfabExport void gf_node_setHeight(gf_node* n, double height);
 
-/** @brief Get the id, user frees memory
+/** @brief Get the id
+ *  @details The string is owned by the network the node belongs to and stays
+ *  valid as long as the network does, even if the id is changed later. For a
+ *  node that is not part of a network it is valid until the id changes.
+ *  Do not free.
  *  @param[in] n The node object
  *  \ingroup C_API
  */
-_GraphfabExport char* gf_node_getID(gf_node* n);
+_GraphfabExport const char* gf_node_getID(gf_node* n);
 
 /** @brief Get the id, user frees memory
  *  @param[in] n The node object
@@ -839,11 +1014,12 @@ _GraphfabExport gf_reaction gf_nw_newReaction(gf_network* nw, const char* id, co
  */
 _GraphfabExport gf_reaction* gf_nw_newReactionp(gf_network* nw, const char* id, const char* name);
 
-/** @brief Get the id, user frees memory
+/** @brief Get the id
+ *  @details Owned by the network, see @ref gf_node_getID. Do not free.
  *  @param[in] r The reaction object
  *  \ingroup C_API
  */
-_GraphfabExport char* gf_reaction_getID(gf_reaction* r);
+_GraphfabExport const char* gf_reaction_getID(gf_reaction* r);
 
 /** @brief Get the centroid of the reaction
  *  @param[in] r The reaction object
@@ -0,0 +1,139 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/io/file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if SAGITTARIUS_PLATFORM == SAGITTARIUS_PLATFORM_LINUX || SAGITTARIUS_PLATFORM == SAGITTARIUS_PLATFORM_APPLE
+    #define SBNW_HAVE_MMAP 1
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace Graphfab {
+
+    bool FileContents::load(const char* path) {
+        if(map(path))
+            return true;
+        return read(path);
+    }
+
+    void FileContents::release() {
+        #ifdef SBNW_HAVE_MMAP
+        if(map_)
+            munmap(map_, maplen_);
+        map_ = NULL;
+        #endif
+        if(data_ && !maplen_)
+            free(data_);
+        data_ = NULL;
+        maplen_ = 0;
+    }
+
+    bool FileContents::map(const char* path) {
+        #ifdef SBNW_HAVE_MMAP
+        int fd = open(path, O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        size_t size = (size_t)st.st_size;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t len = (size/page + 1)*page;
+
+        void* base = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if(base == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        void* p = mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        close(fd);
+        if(p == MAP_FAILED) {
+            munmap(base, len);
+            return false;
+        }
+        madvise(base, size, MADV_SEQUENTIAL);
+
+        map_ = base;
+        maplen_ = len;
+        data_ = (char*)base;
+        return true;
+        #else
+        return false;
+        #endif
+    }
+
+    bool FileContents::read(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if(!file)
+            return false;
+        // size is a hint only; grow as needed for streams
+        size_t cap = 1 << 16, size = 0;
+        if(!fseek(file, 0, SEEK_END)) {
+            long end = ftell(file);
+            if(end > 0)
+                cap = (size_t)end + 1;
+            rewind(file);
+        }
+        char* buf = (char*)malloc(cap);
+        while(buf) {
+            size += fread(buf + size, 1, cap - size, file);
+            if(size < cap)
+                break;
+            char* grown = (char*)realloc(buf, 2*cap);
+            if(!grown) {
+                free(buf);
+                buf = NULL;
+            } else {
+                buf = grown;
+                cap *= 2;
+            }
+        }
+        bool ok = buf && !ferror(file);
+        fclose(file);
+        if(!ok) {
+            free(buf);
+            return false;
+        }
+        buf[size] = '\0'; //terminating null char
+        data_ = buf;
+        return true;
+    }
+
+}
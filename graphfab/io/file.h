@@ -0,0 +1,87 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file file.h
+ * @brief Loading whole files into memory
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_IO_FILE_H_
+#define __SBNW_IO_FILE_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stddef.h>
+
+//-- C++ code --
+#ifdef __cplusplus
+
+namespace Graphfab {
+
+    /** @brief Contents of a file followed by a null char
+     * @details Regular files are mapped read-only over a zeroed anonymous
+     * region one page longer than needed, so the byte after the contents is
+     * zero without touching the file. Anything that cannot be mapped (pipes,
+     * empty files, platforms without mmap) is read into a heap buffer.
+     */
+    class FileContents {
+        public:
+            FileContents() : data_(NULL), map_(NULL), maplen_(0) {}
+
+            ~FileContents() { release(); }
+
+            /// Load @a path; returns false if it cannot be opened or read
+            bool load(const char* path);
+
+            const char* getData() const { return data_; }
+
+            void release();
+
+        protected:
+            bool map(const char* path);
+
+            bool read(const char* path);
+
+            char* data_;
+            void* map_;
+            size_t maplen_;
+
+        private:
+            FileContents(const FileContents&);
+            FileContents& operator=(const FileContents&);
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,358 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/io/xml.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+namespace Graphfab {
+
+    namespace {
+
+        inline bool isSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        inline bool isNameStart(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || (unsigned char)c >= 0x80;
+        }
+
+        inline bool isNameChar(char c) {
+            return isNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+        }
+
+        /// Returns true if any whitespace was skipped
+        inline bool skipSpace(const char*& c) {
+            const char* b = c;
+            while(isSpace(*c))
+                ++c;
+            return c != b;
+        }
+
+        inline bool readName(const char*& c, XMLString& name) {
+            if(!isNameStart(*c))
+                return false;
+            const char* b = c;
+            while(isNameChar(*c))
+                ++c;
+            name = XMLString(b, c - b);
+            return true;
+        }
+
+        void appendUTF8(std::string& s, unsigned long u) {
+            if(u < 0x80)
+                s += (char)u;
+            else if(u < 0x800) {
+                s += (char)(0xC0 | (u >> 6));
+                s += (char)(0x80 | (u & 0x3F));
+            } else if(u < 0x10000) {
+                s += (char)(0xE0 | (u >> 12));
+                s += (char)(0x80 | ((u >> 6) & 0x3F));
+                s += (char)(0x80 | (u & 0x3F));
+            } else {
+                s += (char)(0xF0 | (u >> 18));
+                s += (char)(0x80 | ((u >> 12) & 0x3F));
+                s += (char)(0x80 | ((u >> 6) & 0x3F));
+                s += (char)(0x80 | (u & 0x3F));
+            }
+        }
+
+        bool equalsNoCase(const XMLString& s, const char* t) {
+            size_t k=0;
+            for(; k<s.n && t[k]; ++k) {
+                char c = s.p[k];
+                if(c >= 'A' && c <= 'Z')
+                    c += 'a' - 'A';
+                if(c != t[k])
+                    return false;
+            }
+            return k == s.n && !t[k];
+        }
+
+    }
+
+    // CLASS XMLString:
+
+    bool XMLString::operator==(const char* s) const {
+        return !strncmp(p, s, n) && !s[n];
+    }
+
+    bool XMLString::operator==(const XMLString& o) const {
+        return n == o.n && !memcmp(p, o.p, n);
+    }
+
+    XMLString XMLString::local() const {
+        const char* c = (const char*)memchr(p, ':', n);
+        if(!c)
+            return *this;
+        return XMLString(c + 1, n - (c + 1 - p));
+    }
+
+    // CLASS XMLAttributes:
+
+    const XMLString* XMLAttributes::find(const char* name) const {
+        for(std::vector<XMLAttribute>::const_iterator i=a_.begin(); i!=a_.end(); ++i)
+            if(i->name.local() == name)
+                return &i->value;
+        return NULL;
+    }
+
+    // CLASS XMLSaxReader:
+
+    bool XMLSaxReader::fail(const char* msg) {
+        err_ = msg;
+        return false;
+    }
+
+    bool XMLSaxReader::parse(const char* text, XMLSaxHandler& h) {
+        const char* c = text;
+        bool root = false;
+        stack_.clear();
+        err_.clear();
+
+        // byte order mark
+        if((unsigned char)c[0] == 0xEF && (unsigned char)c[1] == 0xBB && (unsigned char)c[2] == 0xBF)
+            c += 3;
+
+        while(*c) {
+            if(*c != '<') {
+                // character data is not reported
+                const char* b = c;
+                c = strchr(c, '<');
+                if(stack_.empty()) {
+                    for(; *b && b != c; ++b)
+                        if(!isSpace(*b))
+                            return fail("Text outside the root element");
+                }
+                if(!c)
+                    break;
+                continue;
+            }
+
+            if(c[1] == '?') {
+                const char* e = strstr(c + 2, "?>");
+                if(!e)
+                    return fail("Unterminated processing instruction");
+                if(!strncmp(c + 2, "xml", 3) && isSpace(c[5]) && !parseDecl(c + 5, e))
+                    return false;
+                c = e + 2;
+            } else if(!strncmp(c, "<!--", 4)) {
+                const char* e = strstr(c + 4, "-->");
+                if(!e)
+                    return fail("Unterminated comment");
+                c = e + 3;
+            } else if(!strncmp(c, "<![CDATA[", 9)) {
+                if(stack_.empty())
+                    return fail("CDATA outside the root element");
+                const char* e = strstr(c + 9, "]]>");
+                if(!e)
+                    return fail("Unterminated CDATA section");
+                c = e + 3;
+            } else if(c[1] == '!') {
+                return fail("Document type declarations are not supported");
+            } else if(c[1] == '/') {
+                c += 2;
+                XMLString name;
+                if(!readName(c, name))
+                    return fail("Malformed end tag");
+                skipSpace(c);
+                if(*c != '>')
+                    return fail("Malformed end tag");
+                ++c;
+                if(stack_.empty() || !(stack_.back() == name))
+                    return fail("Mismatched end tag");
+                stack_.pop_back();
+                if(!h.endElement(name))
+                    return fail("Stopped by handler");
+            } else {
+                if(root && stack_.empty())
+                    return fail("More than one root element");
+                ++c;
+                bool empty;
+                if(!parseStartTag(c, empty))
+                    return false;
+                root = true;
+                const XMLString name = stack_.back();
+                if(!h.startElement(name, attrs_))
+                    return fail("Stopped by handler");
+                if(empty) {
+                    stack_.pop_back();
+                    if(!h.endElement(name))
+                        return fail("Stopped by handler");
+                }
+            }
+        }
+
+        if(!root)
+            return fail("No root element");
+        if(!stack_.empty())
+            return fail("Unexpected end of document");
+        return true;
+    }
+
+    bool XMLSaxReader::parseDecl(const char* b, const char* e) {
+        // only the encoding matters; the text is assumed to be UTF-8
+        const char* c = b;
+        while(c < e) {
+            skipSpace(c);
+            XMLString name;
+            if(c >= e || !readName(c, name))
+                break;
+            skipSpace(c);
+            if(*c != '=')
+                return fail("Malformed XML declaration");
+            ++c;
+            skipSpace(c);
+            char q = *c;
+            if(q != '"' && q != '\'')
+                return fail("Malformed XML declaration");
+            const char* v = ++c;
+            while(c < e && *c != q)
+                ++c;
+            if(c >= e)
+                return fail("Malformed XML declaration");
+            XMLString value(v, c - v);
+            ++c;
+            if(name == "encoding" && !equalsNoCase(value, "utf-8") && !equalsNoCase(value, "utf8") &&
+              !equalsNoCase(value, "us-ascii") && !equalsNoCase(value, "ascii"))
+                return fail("Unsupported encoding");
+        }
+        return true;
+    }
+
+    bool XMLSaxReader::parseStartTag(const char*& c, bool& empty) {
+        XMLString name;
+        if(!readName(c, name))
+            return fail("Malformed start tag");
+
+        attrs_.a_.clear();
+        decoded_.clear();
+        buf_.clear();
+
+        for(;;) {
+            bool ws = skipSpace(c);
+            if(*c == '/' && c[1] == '>') {
+                c += 2;
+                empty = true;
+                break;
+            }
+            if(*c == '>') {
+                ++c;
+                empty = false;
+                break;
+            }
+            XMLAttribute a;
+            if(!ws || !readName(c, a.name))
+                return fail("Malformed attribute");
+            skipSpace(c);
+            if(*c != '=')
+                return fail("Malformed attribute");
+            ++c;
+            skipSpace(c);
+            char q = *c;
+            if(q != '"' && q != '\'')
+                return fail("Malformed attribute");
+            const char* v = ++c;
+            bool plain = true;
+            for(; *c != q; ++c) {
+                if(!*c || *c == '<')
+                    return fail("Malformed attribute");
+                if(*c == '&' || *c == '\t' || *c == '\n' || *c == '\r')
+                    plain = false;
+            }
+            if(plain)
+                a.value = XMLString(v, c - v);
+            else {
+                // patched to point into buf_ once all attributes are read
+                size_t start = buf_.size();
+                if(!decode(v, c))
+                    return false;
+                decoded_.push_back(start);
+                a.value = XMLString(NULL, buf_.size() - start);
+            }
+            ++c;
+            attrs_.a_.push_back(a);
+        }
+
+        std::vector<size_t>::const_iterator d = decoded_.begin();
+        for(std::vector<XMLAttribute>::iterator i=attrs_.a_.begin(); i!=attrs_.a_.end(); ++i)
+            if(!i->value.p)
+                i->value.p = buf_.data() + *d++;
+
+        stack_.push_back(name);
+        return true;
+    }
+
+    bool XMLSaxReader::decode(const char* b, const char* e) {
+        for(const char* c=b; c<e; ++c) {
+            if(*c == '\r') {
+                // \r\n is a single line break
+                if(c + 1 < e && c[1] == '\n')
+                    ++c;
+                buf_ += ' ';
+            } else if(isSpace(*c))
+                buf_ += ' ';
+            else if(*c != '&')
+                buf_ += *c;
+            else {
+                const char* s = (const char*)memchr(c, ';', e - c);
+                if(!s)
+                    return fail("Malformed reference");
+                XMLString ref(c + 1, s - c - 1);
+                if(ref == "lt")
+                    buf_ += '<';
+                else if(ref == "gt")
+                    buf_ += '>';
+                else if(ref == "amp")
+                    buf_ += '&';
+                else if(ref == "quot")
+                    buf_ += '"';
+                else if(ref == "apos")
+                    buf_ += '\'';
+                else if(ref.n > 1 && ref.p[0] == '#') {
+                    bool hex = ref.p[1] == 'x';
+                    const char* digits = ref.p + (hex ? 2 : 1);
+                    char* end;
+                    unsigned long u = strtoul(digits, &end, hex ? 16 : 10);
+                    if(end != s || end == digits || !isNameChar(*digits) || !u || u > 0x10FFFF)
+                        return fail("Malformed character reference");
+                    appendUTF8(buf_, u);
+                } else
+                    return fail("Undefined entity");
+                c = s;
+            }
+        }
+        return true;
+    }
+
+}
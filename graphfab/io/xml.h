@@ -0,0 +1,142 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file xml.h
+ * @brief Minimal streaming (SAX-style) XML reader
+ * @details Reports start and end tags of a document held in memory. Names
+ * and attribute values refer to the document text where possible, so
+ * elements the handler is not interested in cost no allocation. Character
+ * data, comments and processing instructions are skipped. Documents with
+ * a DOCTYPE, an encoding other than UTF-8/ASCII or undefined entities are
+ * rejected rather than misread.
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_IO_XML_H_
+#define __SBNW_IO_XML_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+//-- C++ code --
+#ifdef __cplusplus
+
+namespace Graphfab {
+
+    /// A slice of text; not null-terminated
+    struct XMLString {
+        XMLString() : p(NULL), n(0) {}
+        XMLString(const char* p_, size_t n_) : p(p_), n(n_) {}
+
+        /// Compare to a null-terminated string
+        bool operator==(const char* s) const;
+
+        bool operator==(const XMLString& o) const;
+
+        bool empty() const { return !n; }
+
+        std::string str() const { return std::string(p, n); }
+
+        /// Name with the namespace prefix removed
+        XMLString local() const;
+
+        const char* p;
+        size_t n;
+    };
+
+    struct XMLAttribute {
+        XMLString name, value;
+    };
+
+    /// Attributes of a start tag (values already decoded)
+    class XMLAttributes {
+        public:
+            uint64 size() const { return a_.size(); }
+
+            const XMLAttribute& operator[](uint64 k) const { return a_.at(k); }
+
+            /// Value of the attribute whose local name is @a name; NULL if none
+            const XMLString* find(const char* name) const;
+
+        protected:
+            friend class XMLSaxReader;
+            std::vector<XMLAttribute> a_;
+    };
+
+    /// Receives the elements of a document from @ref XMLSaxReader
+    class XMLSaxHandler {
+        public:
+            virtual ~XMLSaxHandler() {}
+
+            /// Return false to stop parsing
+            virtual bool startElement(const XMLString& name, const XMLAttributes& attrs) = 0;
+
+            /// Return false to stop parsing
+            virtual bool endElement(const XMLString& name) = 0;
+    };
+
+    class XMLSaxReader {
+        public:
+            /** @brief Parse a null-terminated document
+             * @return False if the document is malformed or unsupported, or
+             * the handler stopped early (see @ref getError)
+             */
+            bool parse(const char* text, XMLSaxHandler& h);
+
+            /// Why the last @ref parse failed
+            const std::string& getError() const { return err_; }
+
+        protected:
+            bool fail(const char* msg);
+
+            bool parseDecl(const char* b, const char* e);
+
+            bool parseStartTag(const char*& c, bool& empty);
+
+            /// Decode references and normalize whitespace, appending to @ref buf_
+            bool decode(const char* b, const char* e);
+
+            std::vector<XMLString> stack_;
+            XMLAttributes attrs_;
+            std::vector<size_t> decoded_;
+            std::string buf_;
+            std::string err_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/chain.h"
+
+#include <algorithm>
+
+namespace Graphfab {
+
+    static const uint64 npos = (uint64)-1;
+
+    static bool isSubstrateRole(RxnRoleType r) {
+        return r == RXN_ROLE_SUBSTRATE || r == RXN_ROLE_SIDESUBSTRATE;
+    }
+
+    static bool isProductRole(RxnRoleType r) {
+        return r == RXN_ROLE_PRODUCT || r == RXN_ROLE_SIDEPRODUCT;
+    }
+
+    // CLASS ChainContraction:
+
+    void ChainContraction::clear() {
+        interior_.clear();
+        off_.clear();
+        ends_.clear();
+        sorted_.clear();
+    }
+
+    uint64 ChainContraction::find(const NetworkElement* e) const {
+        std::vector<IndexElt>::const_iterator i =
+            std::lower_bound(index_.begin(), index_.end(), IndexElt(e, 0));
+        if(i == index_.end() || i->first != e)
+            return npos;
+        return i->second;
+    }
+
+    bool ChainContraction::isContracted(const NetworkElement* e) const {
+        return std::binary_search(sorted_.begin(), sorted_.end(), e);
+    }
+
+    void ChainContraction::contract(Network& net) {
+        clear();
+        off_.push_back(0);
+
+        elt_.clear();
+        index_.clear();
+        for(Network::NodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i)
+            elt_.push_back(*i);
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i)
+            elt_.push_back(*i);
+        const uint64 n = elt_.size();
+        for(uint64 i=0; i<n; ++i)
+            index_.push_back(IndexElt(elt_[i], i));
+        std::sort(index_.begin(), index_.end());
+
+        nbr_.assign(2*n, (NetworkElement*)NULL);
+        nnbr_.assign(n, 0);
+        eligible_.assign(n, 0);
+        visited_.assign(n, 0);
+
+        // species-reaction incidence, keeping at most two neighbors per element
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+            Reaction* r = *i;
+            uint64 ir = find(r);
+            uint64 nsub = 0, nprd = 0;
+            for(Reaction::ConstNodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                uint64 is = find(j->first);
+                if(is == npos)
+                    continue;
+                if(nnbr_[ir] < 2)
+                    nbr_[2*ir + nnbr_[ir]] = j->first;
+                ++nnbr_[ir];
+                if(nnbr_[is] < 2)
+                    nbr_[2*is + nnbr_[is]] = r;
+                ++nnbr_[is];
+                if(isSubstrateRole(j->second))
+                    ++nsub;
+                else if(isProductRole(j->second))
+                    ++nprd;
+            }
+            // uni-uni
+            eligible_[ir] = (nsub == 1 && nprd == 1);
+        }
+
+        for(uint64 i=0; i<n; ++i) {
+            if(elt_[i]->getType() == NET_ELT_TYPE_SPEC)
+                eligible_[i] = 1;
+            eligible_[i] = eligible_[i] && nnbr_[i] == 2 && nbr_[2*i] != nbr_[2*i+1] && !elt_[i]->isLocked();
+        }
+
+        for(uint64 i=0; i<n; ++i) {
+            if(!eligible_[i] || visited_[i])
+                continue;
+
+            // walk away from elt_[i] in both directions until an ineligible element is hit
+            NetworkElement* end[2];
+            bool cycle = false;
+            path_.clear();
+            for(int side=0; side<2 && !cycle; ++side) {
+                NetworkElement* prev = elt_[i];
+                NetworkElement* cur = nbr_[2*i+side];
+                uint64 ic = find(cur);
+                while(eligible_[ic]) {
+                    if(cur == elt_[i]) {
+                        cycle = true;
+                        break;
+                    }
+                    visited_[ic] = 1;
+                    path_.push_back(cur);
+                    NetworkElement* next = nbr_[2*ic] == prev ? nbr_[2*ic+1] : nbr_[2*ic];
+                    prev = cur;
+                    cur = next;
+                    ic = find(cur);
+                }
+                end[side] = cur;
+                if(!side) {
+                    // first side is collected outward; reverse & append the seed
+                    std::reverse(path_.begin(), path_.end());
+                    path_.push_back(elt_[i]);
+                }
+            }
+            visited_[i] = 1;
+
+            if(cycle || end[0] == end[1])
+                continue;
+
+            bool hasSpecies = false;
+            for(uint64 k=0; k<path_.size(); ++k)
+                if(path_[k]->getType() == NET_ELT_TYPE_SPEC)
+                    hasSpecies = true;
+            if(!hasSpecies)
+                continue;
+
+            for(uint64 k=0; k<path_.size(); ++k)
+                interior_.push_back(path_[k]);
+            off_.push_back(interior_.size());
+            ends_.push_back(end[0]);
+            ends_.push_back(end[1]);
+        }
+
+        sorted_.assign(interior_.begin(), interior_.end());
+        std::sort(sorted_.begin(), sorted_.end());
+    }
+
+    void ChainContraction::expand() {
+        for(uint64 c=0; c<getNumChains(); ++c) {
+            Point a = ends_[2*c]->getCentroid();
+            Point b = ends_[2*c+1]->getCentroid();
+            uint64 m = off_[c+1] - off_[c];
+            for(uint64 k=0; k<m; ++k) {
+                NetworkElement* e = interior_[off_[c]+k];
+                e->_p() = a + (b - a)*((Real)(k+1)/(m+1));
+                e->recalcExtents();
+            }
+        }
+    }
+
+}
@@ -0,0 +1,117 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file chain.h
+ * @brief Contraction of linear chains prior to layout
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_CHAIN_H_
+#define __SBNW_LAYOUT_CHAIN_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/network.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+#include <utility>
+
+namespace Graphfab {
+
+    /** @brief Finds maximal linear chains (cascades) in a network
+     * @details A chain is a maximal path A -> r1 -> B -> r2 -> ... -> Z in the
+     * species-reaction graph whose interior consists of species used by exactly
+     * two reactions and uni-uni reactions. Only chains with at least one interior
+     * species and two distinct endpoints are contracted. The interior can then be
+     * omitted from the layout and replaced by a single super-edge between the
+     * endpoints; @ref expand places the interior evenly along that edge afterwards.
+     * Locked elements are never contracted.
+     */
+    class _GraphfabExport ChainContraction {
+        public:
+            /// Find the chains in @a net (replaces any previous result)
+            void contract(Network& net);
+
+            /// Forget all chains
+            void clear();
+
+            /// Number of contracted chains
+            uint64 getNumChains() const { return ends_.size()/2; }
+
+            /// Start / end (retained) element of chain @a i
+            NetworkElement* getChainStart(uint64 i) const { return ends_.at(2*i); }
+            NetworkElement* getChainEnd(uint64 i) const { return ends_.at(2*i+1); }
+
+            /// Number of edges along chain @a i (weight of the super-edge)
+            uint64 getChainLength(uint64 i) const { return off_.at(i+1) - off_.at(i) + 1; }
+
+            /// Number of elements removed from the layout
+            uint64 getNumContracted() const { return interior_.size(); }
+
+            /// True if @a e is in the interior of a chain
+            bool isContracted(const NetworkElement* e) const;
+
+            /// Place the interior of each chain evenly between its endpoints
+            void expand();
+
+        protected:
+            typedef std::pair<const NetworkElement*, uint64> IndexElt;
+
+            /// Index of @a e in the sorted element index
+            uint64 find(const NetworkElement* e) const;
+
+            /// Interior elements, chain by chain in path order
+            std::vector<NetworkElement*> interior_;
+            /// Offsets of each chain in interior_ (getNumChains()+1 entries)
+            std::vector<uint64> off_;
+            /// Endpoints, two per chain
+            std::vector<NetworkElement*> ends_;
+            /// Sorted interior, for lookup
+            std::vector<const NetworkElement*> sorted_;
+
+            // scratch
+            std::vector<IndexElt> index_;
+            std::vector<NetworkElement*> elt_;
+            /// Up to two neighbors per element (NULL if absent) & the neighbor count
+            std::vector<NetworkElement*> nbr_;
+            std::vector<uint64> nnbr_;
+            std::vector<int> eligible_, visited_;
+            std::vector<NetworkElement*> path_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -42,6 +42,7 @@
 #include "graphfab/layout/point.h"
 #include "graphfab/math/transform.h"
 #include "graphfab/layout/arrowhead.h"
+#include "graphfab/network/arena.h"
 
 //-- C++ code --
 #ifdef __cplusplus
@@ -69,7 +70,7 @@ namespace Graphfab {
      * activators, inhibitors etc.
      */
 
-    class RxnBezier {
+    class RxnBezier : public ArenaAllocated {
         public:
             RxnBezier() {
               ns = ne = NULL;
@@ -109,10 +110,10 @@ namespace Graphfab {
             /// Start & end point resp., control points
             Point s, e, c1, c2;
             
-            Point getTransformedS() const { return tf_*s; }
-            Point getTransformedE() const { return tf_*e; }
-            Point getTransformedC1() const { return tf_*c1; }
-            Point getTransformedC2() const { return tf_*c2; }
+            Point getTransformedS() const { return view_.tf()*s; }
+            Point getTransformedE() const { return view_.tf()*e; }
+            Point getTransformedC1() const { return view_.tf()*c1; }
+            Point getTransformedC2() const { return view_.tf()*c2; }
 
             virtual Point getCentroidCP() const = 0;
 
@@ -172,7 +173,7 @@ namespace Graphfab {
                 v = (e - c2).normed() * 5.;
               Point u = v.dextro();
 
-              a.setTransform(tf_*Affine2d::fromBasis(u, v, e));
+              a.setTransform(view_.tf()*Affine2d::fromBasis(u, v, e));
               a.setInverseTransform(a.getTransform().inv());
             }
 
@@ -192,21 +193,15 @@ namespace Graphfab {
               return result;
             }
             
-            Affine2d getTransform() const { return tf_; }
+            Affine2d getTransform() const { return view_.tf(); }
             
-            void setTransform(const Affine2d& tf, bool recurse = true) { tf_ = tf; }
-            
-            Affine2d getInverseTransform() const { return itf_; }
-            
-            void setInverseTransform(const Affine2d& itf, bool recurse = true) { itf_ = itf; }
+            Affine2d getInverseTransform() const { return view_.itf(); }
 
             virtual ArrowheadStyle getArrowheadStyle() const = 0;
             
             
-            /// Transform
-            Affine2d tf_;
-            /// Inverse transform
-            Affine2d itf_;
+            /// View transform (of the network the curve's reaction belongs to)
+            ViewTransformRef view_;
         protected:
     };
     
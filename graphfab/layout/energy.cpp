@@ -0,0 +1,331 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/energy.h"
+#include "graphfab/layout/canvas.h"
+#include "graphfab/math/rand_unif.h"
+#include "graphfab/math/min_max.h"
+
+#include <math.h>
+#include <map>
+
+void gf_doLayoutAlgorithmLBFGS(fr_options opt, gf_layoutInfo* l) {
+    using namespace Graphfab;
+
+    Network* net = (Network*)l->net;
+    AN(net, "No network");
+    Canvas* can = (Canvas*)l->canv;
+    AN(can, "No canvas");
+
+    if(opt.prerandomize)
+        //TODO: use canvas width, height
+        net->randomizePositions(Graphfab::Box(Graphfab::Point(0.,0.), Graphfab::Point(1024., 1024.)));
+
+    LBFGSOptimizer optim;
+    optim.setMaxStep(opt.k);
+    EnergyLayout(opt, *net, can, optim);
+}
+
+gf_layoutEnergy gf_layoutEnergy_new(fr_options opt, gf_network* n) {
+    using namespace Graphfab;
+
+    AN(n, "No network");
+    Network* net = (Network*)n->n;
+    AN(net, "No network");
+
+    net->updateExtents();
+
+    gf_layoutEnergy e;
+    e.e = (void*)new LayoutEnergy(*net, opt);
+    return e;
+}
+
+void gf_releaseLayoutEnergy(gf_layoutEnergy* e) {
+    delete (Graphfab::LayoutEnergy*)e->e;
+    e->e = NULL;
+}
+
+uint64_t gf_layoutEnergy_getDimension(gf_layoutEnergy* e) {
+    Graphfab::LayoutEnergy* en = (Graphfab::LayoutEnergy*)e->e;
+    AN(en, "No energy");
+    return en->getDimension();
+}
+
+void gf_layoutEnergy_getCoords(gf_layoutEnergy* e, double* x) {
+    Graphfab::LayoutEnergy* en = (Graphfab::LayoutEnergy*)e->e;
+    AN(en, "No energy");
+    en->getCoords(x);
+}
+
+void gf_layoutEnergy_setCoords(gf_layoutEnergy* e, const double* x) {
+    Graphfab::LayoutEnergy* en = (Graphfab::LayoutEnergy*)e->e;
+    AN(en, "No energy");
+    en->setCoords(x);
+    en->getNetwork().refreshCurves();
+}
+
+double gf_layoutEnergy_evaluate(gf_layoutEnergy* e, const double* x, double* grad) {
+    Graphfab::LayoutEnergy* en = (Graphfab::LayoutEnergy*)e->e;
+    AN(en, "No energy");
+    return en->evaluate(x, grad);
+}
+
+namespace Graphfab {
+
+    // softening for the repulsion log term (same scale as the 0.1 distance floor in fr.cpp)
+    static const Real rep_eps2 = 0.01;
+    // compartment wall thickness (see do_internalForce in fr.cpp)
+    static const Real wall_t = 10.;
+    // beyond this the wall potential is continued linearly to avoid overflow
+    static const Real wall_amax = 50.;
+
+    // exp(a), continued linearly past wall_amax; stores the derivative in da
+    static Real wallExp(Real a, Real& da) {
+        if(a > wall_amax) {
+            da = exp(wall_amax);
+            return da*(1. + a - wall_amax);
+        }
+        da = exp(a);
+        return da;
+    }
+
+    // CLASS LayoutEnergy:
+
+    LayoutEnergy::LayoutEnergy(Network& net, const fr_options& opt)
+        : net_(net), opt_(opt) {
+        std::map<NetworkElement*, uint64> index;
+
+        for(uint64 i=0; i<net.getNElts(); ++i) {
+            NetworkElement* e = net.getElt(i);
+            if(e->getType() == NET_ELT_TYPE_COMP)
+                continue;
+            index[e] = elt_.size();
+            elt_.push_back(e);
+            type_.push_back(e->getType());
+            deg_.push_back((Real)e->degree());
+            size_.push_back(max(e->getWidth(), e->getHeight()));
+            hw_.push_back(0.5*e->getWidth());
+            hh_.push_back(0.5*e->getHeight());
+            lock_.push_back(e->isLocked());
+        }
+
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+            Reaction* r = *i;
+            std::map<NetworkElement*, uint64>::iterator ri = index.find(r);
+            if(ri == index.end())
+                continue;
+            for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                std::map<NetworkElement*, uint64>::iterator si = index.find(j->first);
+                if(si == index.end())
+                    continue;
+                att_.push_back(ri->second);
+                att_.push_back(si->second);
+            }
+        }
+
+        if(opt.enable_comps) {
+            for(Network::CompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i)
+                comp_.push_back(*i);
+            // reactions & compartments do not interact
+            for(uint64 i=0; i<elt_.size(); ++i) {
+                if(type_[i] != NET_ELT_TYPE_SPEC)
+                    continue;
+                for(uint64 c=0; c<comp_.size(); ++c) {
+                    std::vector<uint64>& pairs = comp_[c]->contains(elt_[i]) ? inside_ : outside_;
+                    pairs.push_back(i);
+                    pairs.push_back(c);
+                }
+            }
+        }
+    }
+
+    Real LayoutEnergy::wallEnergy(uint64 i, uint64 c, const Real* x, Real* grad) const {
+        const Box b = comp_[c]->getExtents();
+        const Real f = opt_.k*opt_.k;
+        const Real invt = 1./wall_t;
+        const Real px = x[2*i], py = x[2*i+1];
+        Real dx1, dx2, dy1, dy2;
+
+        Real E = f*wall_t*(
+            wallExp((b.getMin().x - (px - hw_[i]))*invt, dx1) +
+            wallExp((px + hw_[i] - b.getMax().x)*invt, dx2) +
+            wallExp((b.getMin().y - (py - hh_[i]))*invt, dy1) +
+            wallExp((py + hh_[i] - b.getMax().y)*invt, dy2));
+
+        if(grad) {
+            grad[2*i]   += f*(dx2 - dx1);
+            grad[2*i+1] += f*(dy2 - dy1);
+        }
+        return E;
+    }
+
+    Real LayoutEnergy::evaluate(const Real* x, Real* grad) {
+        const uint64 n = elt_.size();
+        const Real k = opt_.k;
+        Real E = 0.;
+
+        if(grad)
+            for(uint64 i=0; i<2*n; ++i)
+                grad[i] = 0.;
+
+        // repulsion
+        for(uint64 i=0; i<n; ++i) {
+            for(uint64 j=i+1; j<n; ++j) {
+                Real dx = x[2*i] - x[2*j], dy = x[2*i+1] - x[2*j+1];
+                Real d2 = dx*dx + dy*dy + rep_eps2;
+                Real a = k*log(deg_[i]+deg_[j]+2) + (size_[i]+size_[j])/4;
+                E -= 0.5*a*a*log(d2);
+                if(grad) {
+                    Real c = a*a/d2;
+                    grad[2*i]   -= c*dx;
+                    grad[2*i+1] -= c*dy;
+                    grad[2*j]   += c*dx;
+                    grad[2*j+1] += c*dy;
+                }
+            }
+        }
+
+        // attraction along reactions
+        for(uint64 z=0; z<att_.size(); z+=2) {
+            uint64 i = att_[z], j = att_[z+1];
+            Real dx = x[2*i] - x[2*j], dy = x[2*i+1] - x[2*j+1];
+            Real d = sqrt(dx*dx + dy*dy);
+            Real a = k*log(deg_[i]+deg_[j]+2) + (size_[i]+size_[j])/4;
+            E += d*d*d/(3.*a);
+            if(grad) {
+                Real c = d/a;
+                grad[2*i]   += c*dx;
+                grad[2*i+1] += c*dy;
+                grad[2*j]   -= c*dx;
+                grad[2*j+1] -= c*dy;
+            }
+        }
+
+        // gravity
+        if(opt_.grav >= 5.) {
+            Real c = opt_.grav/k;
+            for(uint64 i=0; i<n; ++i) {
+                if(type_[i] != NET_ELT_TYPE_SPEC)
+                    continue;
+                Real dx = x[2*i] - opt_.baryx, dy = x[2*i+1] - opt_.baryy;
+                E += 0.5*c*(dx*dx + dy*dy);
+                if(grad) {
+                    grad[2*i]   += c*dx;
+                    grad[2*i+1] += c*dy;
+                }
+            }
+        }
+
+        // compartments
+        for(uint64 z=0; z<inside_.size(); z+=2)
+            E += wallEnergy(inside_[z], inside_[z+1], x, grad);
+
+        for(uint64 z=0; z<outside_.size(); z+=2) {
+            uint64 i = outside_[z];
+            Compartment* c = comp_[outside_[z+1]];
+            Point p = c->getCentroid();
+            Real dx = x[2*i] - p.x, dy = x[2*i+1] - p.y;
+            Real d2 = dx*dx + dy*dy + rep_eps2;
+            Real a = k*log(deg_[i]+c->degree()+2) + (size_[i]+max(c->getWidth(), c->getHeight()))/4;
+            E -= 0.5*a*a*log(d2);
+            if(grad) {
+                grad[2*i]   -= a*a/d2*dx;
+                grad[2*i+1] -= a*a/d2*dy;
+            }
+        }
+
+        if(grad)
+            for(uint64 i=0; i<n; ++i)
+                if(lock_[i])
+                    grad[2*i] = grad[2*i+1] = 0.;
+
+        return E;
+    }
+
+    void LayoutEnergy::getCoords(Real* x) const {
+        for(uint64 i=0; i<elt_.size(); ++i) {
+            x[2*i]   = elt_[i]->_p().x;
+            x[2*i+1] = elt_[i]->_p().y;
+        }
+    }
+
+    void LayoutEnergy::setCoords(const Real* x) {
+        for(uint64 i=0; i<elt_.size(); ++i) {
+            if(lock_[i])
+                continue;
+            elt_[i]->_p() = Point(x[2*i], x[2*i+1]);
+            elt_[i]->recalcExtents();
+        }
+    }
+
+    void LayoutEnergy::separate(Real* x, Real spread) const {
+        const uint64 n = elt_.size();
+        for(uint64 i=0; i<n; ++i) {
+            for(uint64 j=i+1; j<n; ++j) {
+                if(lock_[j])
+                    continue;
+                Real dx = x[2*i] - x[2*j], dy = x[2*i+1] - x[2*j+1];
+                if(dx*dx + dy*dy < 1e-6) {
+                    x[2*j]   += rand_range(-spread, spread);
+                    x[2*j+1] += rand_range(-spread, spread);
+                }
+            }
+        }
+    }
+
+    void EnergyLayout(fr_options opt, Network& net, Canvas* can, Optimizer& optim) {
+        if(opt.boundary && opt.autobary) {
+            AN(can, "Boundary specified but no canvas");
+            opt.baryx = can->getWidth() *0.5;
+            opt.baryy = can->getHeight()*0.5;
+        }
+
+        net.updateExtents();
+
+        LayoutEnergy energy(net, opt);
+        std::vector<Real> x(energy.getDimension());
+
+        if(!x.empty()) {
+            energy.getCoords(&x[0]);
+            // the energy is flat for coincident elements; break the symmetry first
+            energy.separate(&x[0], opt.k);
+            optim.minimize(energy, &x[0]);
+            energy.setCoords(&x[0]);
+        }
+
+        if(!opt.enable_comps)
+            net.resizeCompsEnclose(opt.padding);
+
+        net.refreshCurves();
+    }
+
+}
@@ -0,0 +1,194 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file energy.h
+ * @brief Layout energy with analytic gradient; gradient-based layout engine
+ * @details The energy is the potential whose negative gradient gives the forces
+ * used by the Fruchterman-Reingold implementation in fr.cpp, so that a
+ * quasi-Newton optimizer can be used in place of the cooling schedule.
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_ENERGY_H_
+#define __SBNW_LAYOUT_ENERGY_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/fr.h"
+#include "graphfab/interface/layout.h"
+
+//-- C code --
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  @author JKM
+ *  @brief The layout energy of a network
+ *  @details Exposes the layout objective and its gradient over a flat
+ *  coordinate vector (x0, y0, x1, y1, ...) so that client code can
+ *  minimize it with an optimizer of its choice.
+ *  \ingroup C_API
+ */
+typedef struct {
+    /// @private
+    void* e;
+} gf_layoutEnergy;
+
+/**
+ *  @brief Run the autolayout algorithm using L-BFGS minimization of the layout energy
+ *  @details Alternative to @ref gf_doLayoutAlgorithm which uses curvature
+ *  information instead of a cooling schedule. Compartments are held fixed
+ *  during minimization.
+ *  @param[in] opt The options controlling the layout algorithm
+ *  @param[in/out] l The layout info
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_doLayoutAlgorithmLBFGS(fr_options opt, gf_layoutInfo* l);
+
+/** @brief Create the layout energy for a network
+ *  @details The energy captures the network structure and element sizes at the
+ *  time of the call; create a new one after modifying the network.
+ *  @param[in] opt The layout options (stiffness, gravity, compartments)
+ *  @param[in] n The network
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_layoutEnergy gf_layoutEnergy_new(fr_options opt, gf_network* n);
+
+/** @brief Release the layout energy
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_releaseLayoutEnergy(gf_layoutEnergy* e);
+
+/** @brief Get the number of coordinates (twice the number of movable elements)
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_layoutEnergy_getDimension(gf_layoutEnergy* e);
+
+/** @brief Copy the current element positions into @a x
+ *  @param[out] x Array of length @ref gf_layoutEnergy_getDimension
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layoutEnergy_getCoords(gf_layoutEnergy* e, double* x);
+
+/** @brief Write the positions in @a x back to the network and rebuild the curves
+ *  @param[in] x Array of length @ref gf_layoutEnergy_getDimension
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layoutEnergy_setCoords(gf_layoutEnergy* e, const double* x);
+
+/** @brief Evaluate the energy and its gradient
+ *  @param[in] x The coordinates
+ *  @param[out] grad Receives the gradient (may be NULL)
+ *  @return The energy at @a x
+ *  \ingroup C_API
+ */
+_GraphfabExport double gf_layoutEnergy_evaluate(gf_layoutEnergy* e, const double* x, double* grad);
+
+#ifdef __cplusplus
+}//extern "C"
+#endif
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include "graphfab/math/optim.h"
+
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief Layout energy of a network
+     * @details Variables are the centroids of all species and reaction
+     * elements. Terms (each the potential of the corresponding force in fr.cpp):
+     * - repulsion  -a^2/2*log(d^2 + eps^2), with a = k*log(deg_u+deg_v+2) + (size_u+size_v)/4
+     * - attraction d^3/(3a) between a reaction and each of its species
+     * - gravity    grav/(2k)*|p - bary|^2 on species (when grav >= 5)
+     * - compartment walls k^2*t*exp(overlap/t) keeping elements inside their
+     *   compartment (when enable_comps); compartments themselves are fixed
+     *
+     * Locked elements contribute to the energy but receive zero gradient.
+     */
+    class _GraphfabExport LayoutEnergy : public ObjectiveFunction {
+        public:
+            LayoutEnergy(Network& net, const fr_options& opt);
+
+            uint64 getDimension() const { return 2*elt_.size(); }
+
+            Real evaluate(const Real* x, Real* grad);
+
+            /// Copy the element centroids into @a x
+            void getCoords(Real* x) const;
+
+            /// Move the elements to the centroids in @a x
+            void setCoords(const Real* x);
+
+            /// Randomly displace elements that coincide in @a x by up to @a spread
+            void separate(Real* x, Real spread) const;
+
+            Network& getNetwork() { return net_; }
+
+        protected:
+            /// Compartment wall term between element i and compartment c
+            Real wallEnergy(uint64 i, uint64 c, const Real* x, Real* grad) const;
+
+            Network& net_;
+            fr_options opt_;
+
+            /// Movable elements (species & reactions)
+            std::vector<NetworkElement*> elt_;
+            std::vector<NetworkEltType> type_;
+            std::vector<Real> deg_, size_, hw_, hh_;
+            std::vector<int> lock_;
+
+            /// Attraction pairs (reaction index, species index)
+            std::vector<uint64> att_;
+
+            /// Compartments (fixed during minimization)
+            std::vector<Compartment*> comp_;
+            /// Containment pairs (element index, compartment index)
+            std::vector<uint64> inside_;
+            /// Repulsion pairs between elements & compartments they are outside of
+            std::vector<uint64> outside_;
+    };
+
+    /** @brief Minimize the layout energy of @a net with @a optim
+     * @details Post-processing (compartment resizing, curves) matches
+     * @ref FruchtermanReingold.
+     */
+    _GraphfabExport void EnergyLayout(fr_options opt, Network& net, Canvas* can, Optimizer& optim);
+
+}
+
+#endif
+
+#endif
@@ -51,6 +51,22 @@
 
 static bool dumpForces_ = false;
 
+gf_layoutWorkspace gf_layoutWorkspace_new() {
+    gf_layoutWorkspace ws;
+    ws.w = (void*)new Graphfab::LayoutWorkspace();
+    return ws;
+}
+
+void gf_releaseLayoutWorkspace(gf_layoutWorkspace* ws) {
+    delete (Graphfab::LayoutWorkspace*)ws->w;
+    ws->w = NULL;
+}
+
+void gf_layoutWorkspace_setChainContraction(gf_layoutWorkspace* ws, int enable) {
+    AN(ws && ws->w, "No workspace");
+    ((Graphfab::LayoutWorkspace*)ws->w)->setChainContraction(enable ? true : false);
+}
+
 void gf_getLayoutOptDefaults(fr_options* opt) {
     opt->k = 50.;
     opt->boundary = 0;
@@ -102,18 +118,44 @@ void gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c) {
     FruchtermanReingold(opt, *net, can, NULL);
 }
 
-namespace Graphfab {
-    
-    bool eltTypesInteract(const NetworkEltType a, const NetworkEltType b, fr_options* opt) {
-//         if (a == b && b == NET_ELT_TYPE_SPEC)
-//           return false;
-        if(!opt->enable_comps && typeMatchEither(a,b,NET_ELT_TYPE_COMP))
-            return false;
-        if(typeMatchEither(a,b,NET_ELT_TYPE_RXN) && typeMatchEither(a,b,NET_ELT_TYPE_COMP))
-            //reactions & comps don't interact
-            return false;
-        return true;
+void gf_doLayoutAlgorithmWorkspace(fr_options opt, gf_layoutInfo* l, gf_layoutWorkspace* ws) {
+    using namespace Graphfab;
+
+    Network* net = (Network*)l->net;
+    AN(net, "No network");
+    Canvas* can = (Canvas*)l->canv;
+    AN(can, "No canvas");
+    AN(ws && ws->w, "No workspace");
+
+    if(opt.prerandomize)
+        //TODO: use canvas width, height
+        net->randomizePositions(Graphfab::Box(Graphfab::Point(0.,0.), Graphfab::Point(1024., 1024.)));
+
+    FruchtermanReingold(opt, *net, can, l, *(LayoutWorkspace*)ws->w);
+}
+
+void gf_doLayoutAlgorithm2Workspace(fr_options opt, gf_network* n, gf_canvas* c, gf_layoutWorkspace* ws) {
+    using namespace Graphfab;
+
+    AN(n, "No network");
+    Network* net = (Network*)n->n;
+    AN(net, "No network");
+    AN(ws && ws->w, "No workspace");
+
+    Canvas* can = NULL;
+    if(c) {
+        can = (Canvas*)c->canv;
+        AN(can, "No canvas");
     }
+
+    if(opt.prerandomize)
+        //TODO: use canvas width, height
+        net->randomizePositions(Graphfab::Box(Graphfab::Point(0.,0.), Graphfab::Point(1024., 1024.)));
+
+    FruchtermanReingold(opt, *net, can, NULL, *(LayoutWorkspace*)ws->w);
+}
+
+namespace Graphfab {
     
     Real calc_fr(const Real k, const Real d) {
         return k*k/d;
@@ -123,171 +165,218 @@ namespace Graphfab {
         return d*d/k;
     }
     
-    // compute the internal force between a compartment & its node
-    void do_internalForce(NetworkElement* u, Compartment& c, Real k) {
-        c.doInternalForce(u, k*k, 10.);
-    }
-    
-    // compute the repulsion force between two elements & apply it
-    void do_repulForce(NetworkElement& u, NetworkElement& v, Real k, uint64 num) {
-//         if(typeMatchEither(u.getType(),v.getType(),NET_ELT_TYPE_RXN))
-          // reaction centroids to not repel
-//           return;
-//         if(typeMatchEither(u.getType(),v.getType(),NET_ELT_TYPE_RXN) && typeMatchEither(u.getType(),v.getType(),NET_ELT_TYPE_SPEC))
-          // species and reaction centroids to not repel
-//           return;
-
-        Point delta(u.centroidDisplacementFrom(v).normed());
+    // repulsion on the first element of a pair with centroid displacement disp
+    // (the second element receives the negative)
+    static inline Point repulForce(const Point& disp, Real degsum, Real sizesum, Real k, uint64 num) {
+        Point delta(disp.normed());
         Point f(0,0);
-        
-        // needs to be large because force is no longer calculated on the
-        // basis of centroids
-        Real ep = 1e-6;
-        
-        Real d = max(u.centroidDisplacementFrom(v).mag(), 0.1);
-        
-        if(u.centroidDisplacementFrom(v).mag2() < ep) {
-            // repel nodes very close together with a large force of unspecified magnitude
+
+        Real d = max(disp.mag(), 0.1);
+
+        if(disp.mag2() < 1e-6) {
+            // repel elements very close together with a large force of unspecified magnitude
             Real extreme = 100.*sqrt((Real)num);
             f = Point(rand_range(-extreme, extreme), rand_range(-extreme, extreme));
-            
         } else {
-            Real adjk = (k*log((Real)u.degree()+v.degree()+2) + (max(v.getWidth(), v.getHeight()) + max(u.getWidth(), u.getHeight()))/4);
-//             std::cerr << "max(v.getWidth(), v.getHeight()) = " << max(v.getWidth(), v.getHeight()) << ", max(u.getWidth(), u.getHeight()) = " << max(u.getWidth(), u.getHeight()) << "\n";
+            Real adjk = (k*log(degsum+2) + sizesum/4);
             f = Point(delta * calc_fr(adjk, d));
+        }
+        return f;
+    }
 
-            // compartment repulsion
-            if(u.getType() == NET_ELT_TYPE_COMP && v.getType() == NET_ELT_TYPE_COMP) {
-                f = 0.01*f;
-                if(d > 25.)
-                    f = Point(0,0);
+    // reset deltas & recalc extents (same arithmetic as Node/Reaction::recalcExtents)
+    static void packedPrepare(LayoutWorkspace& ws) {
+        const uint64 n = ws.size();
+        for(uint64 i=0; i<n; ++i) {
+            ws.vx_[i] = ws.vy_[i] = 0.;
+            Real* b = &ws.ext_[4*i];
+            Real x = ws.x_[i], y = ws.y_[i];
+            if(ws.type_[i] == NET_ELT_TYPE_RXN) {
+                b[0] = x - 10.;
+                b[1] = y - 10.;
+                b[2] = x + 10.;
+                b[3] = y + 10.;
+                // Reaction::getLocalExtents
+                ws.w_[i] = (x + 5) - (x - 5);
+                ws.h_[i] = (y + 5) - (y - 5);
+            } else {
+                Real dx = 0.5*(b[2] - b[0]), dy = 0.5*(b[3] - b[1]);
+                b[0] = x - dx;
+                b[1] = y - dy;
+                b[2] = x + dx;
+                b[3] = y + dy;
+                ws.w_[i] = b[2] - b[0];
+                ws.h_[i] = b[3] - b[1];
             }
         }
-        
-        if (dumpForces_)
-          std::cout << "Repulsion force between " << eltTypeToStr(u.getType()) << " and " << eltTypeToStr(v.getType()) << ": " << f.mag()/d << "\n";
-        
-        u.addDelta(f);
-        
-        v.addDelta(-f);
     }
-    
-    // apply the attraction force
-    void do_attForce(NetworkElement& u, NetworkElement& v, Real k) {
-        Point delta(u.centroidDisplacementFrom(v).normed());
-        //std::cout << "delta: " << delta << "\n";
 
-//         std::cerr << "attr bet " << eltTypeToStr(u.getType()) << " & " << eltTypeToStr(v.getType()) << "\n";
+    // species/reaction repulsion (all pairs interact)
+    static void packedRepulsion(LayoutWorkspace& ws, Real k, uint64 num) {
+        const uint64 n = ws.size();
+        Real* x = n ? &ws.x_[0] : NULL;
+        Real* y = n ? &ws.y_[0] : NULL;
+        Real* vx = n ? &ws.vx_[0] : NULL;
+        Real* vy = n ? &ws.vy_[0] : NULL;
+        const Real* w = n ? &ws.w_[0] : NULL;
+        const Real* h = n ? &ws.h_[0] : NULL;
+        const Real* deg = n ? &ws.deg_[0] : NULL;
 
-        Real ep = 1.e-6;
-        
-        Real d = u.centroidDisplacementFrom(v).mag();
-        
-        if(d > ep) {
-            //Real invd = 1./d;
-            
-            //Real adjk = k*log((Real)u.degree()+v.degree()+2);
-            Real adjk = (k*log((Real)u.degree()+v.degree()+2) + (max(v.getWidth(), v.getHeight()) + max(u.getWidth(), u.getHeight()))/4);
-            u.addDelta(-delta * calc_fa(u.getType() == NET_ELT_TYPE_RXN ? k : adjk, d));
-            if (dumpForces_)
-              std::cerr << "attr force bet "<< eltTypeToStr(u.getType()) << " & " << eltTypeToStr(v.getType()) << ": " << (delta * calc_fa(u.getType() == NET_ELT_TYPE_RXN ? k : adjk, d)).mag()/d << "\n";
+        for(uint64 i=0; i<n; ++i) {
+            for(uint64 j=i+1; j<n; ++j) {
+                Point f(repulForce(Point(x[i] - x[j], y[i] - y[j]), deg[i]+deg[j],
+                                   max(w[j], h[j]) + max(w[i], h[i]), k, num));
+                vx[i] += f.x;
+                vy[i] += f.y;
+                vx[j] -= f.x;
+                vy[j] -= f.y;
+            }
+        }
+    }
+
+    // reaction-species attraction
+    static void packedAttraction(LayoutWorkspace& ws, Real k) {
+        for(uint64 z=0; z<ws.att_.size(); z+=2) {
+            uint64 u = ws.att_[z], v = ws.att_[z+1];
+            Point disp(ws.x_[u] - ws.x_[v], ws.y_[u] - ws.y_[v]);
+            Point delta(disp.normed());
+            Real d = disp.mag();
+            if(d > 1.e-6) {
+                Real adjk = (k*log(ws.deg_[u]+ws.deg_[v]+2) + (max(ws.w_[v], ws.h_[v]) + max(ws.w_[u], ws.h_[u]))/4);
+                Real wt = ws.attw_[z/2];
+                Point fu(-delta * calc_fa((ws.type_[u] == NET_ELT_TYPE_RXN ? k : adjk)*wt, d));
+                Point fv( delta * calc_fa((ws.type_[v] == NET_ELT_TYPE_RXN ? k : adjk)*wt, d));
+                ws.vx_[u] += fu.x;
+                ws.vy_[u] += fu.y;
+                ws.vx_[v] += fv.x;
+                ws.vy_[v] += fv.y;
+            }
+        }
+    }
+
+    // "gravitational" force on the species batch
+    static void packedGravity(fr_options& opt, LayoutWorkspace& ws, Real k) {
+        if (opt.grav < 5.)
+            return;
+        Point bary(opt.baryx, opt.baryy);
+        Real adjk = opt.grav / k;
+        for(uint64 z=0; z<ws.spec_.size(); ++z) {
+            uint64 i = ws.spec_[z];
+            Point delta = Point(ws.x_[i], ws.y_[i]) - bary;
+            if (delta.mag() < 1e-2)
+                continue;
+            Point f(-delta * adjk);
+            ws.vx_[i] += f.x;
+            ws.vy_[i] += f.y;
+        }
+    }
 
-            v.addDelta( delta * calc_fa(v.getType() == NET_ELT_TYPE_RXN ? k : adjk, d));
+    // cap deltas & move species and reactions
+    static void packedMove(LayoutWorkspace& ws, Real T) {
+        const uint64 n = ws.size();
+        for(uint64 i=0; i<n; ++i) {
+            Point v(ws.vx_[i], ws.vy_[i]);
+            v.capMag2_(T*T);
+            ws.vx_[i] = v.x;
+            ws.vy_[i] = v.y;
+            if(ws.lock_[i])
+                continue;
+            if (v.mag2() > 1e-6) {
+                Point p = Point(ws.x_[i], ws.y_[i]) + v.normed()*T;
+                ws.x_[i] = p.x;
+                ws.y_[i] = p.y;
+            }
         }
     }
 
-    // apply "gravitational" force
-    void do_gravity(NetworkElement& u, Point bary, Real strength, Real k) {
-      Point delta = u.getCentroid() - bary;
+    // The compartment batch is homogeneous, so the calls below are bound statically
 
-      if (delta.mag() < 1e-2)
-        return;
+    static void compsPrepare(LayoutWorkspace& ws) {
+        for(uint64 c=0; c<ws.comp_.size(); ++c) {
+            ws.comp_[c]->Compartment::resetActivity();
+            ws.comp_[c]->Compartment::recalcExtents();
+        }
+    }
 
-      Real adjk = strength / k;
-      u.addDelta( -delta * adjk );
+    static void compsMove(LayoutWorkspace& ws, Real T) {
+        for(uint64 c=0; c<ws.comp_.size(); ++c) {
+            ws.comp_[c]->Compartment::capDelta2(T*T);
+            ws.comp_[c]->Compartment::doMotion(T);
+        }
     }
     
-    // single interation
-    void FRSingle(fr_options& opt, Network& net, Box bound, Real T, Real k, uint64 num) {
-        net.resetActivity();
-        
-        net.updateExtents();
-        
-        // repulsive forces
-        for(uint64 i=0; i<net.getNElts(); ++i) {
-            //NetworkElement* u = *i;
-            NetworkElement* u = net.getElt(i);;
-            
-            // is the network element a container?
-            Graphfab::Compartment* comp=NULL;
-            if(u->getType() == NET_ELT_TYPE_COMP)
-                comp = dynamic_cast<Compartment*>(u); //get the associated compartment
-            
-            for(uint64 j=i+1; j<net.getNElts(); ++j) {
-                //NetworkElement* v = *j;
-                NetworkElement* v = net.getElt(j);
-                AT(u != v, "Cannot apply to self");
-                if(!eltTypesInteract(u->getType(), v->getType(), &opt))
-                    continue; // elements do not interact
-                
-                if(opt.enable_comps) {
-                    if(u->getType() == NET_ELT_TYPE_COMP && v->getType() == NET_ELT_TYPE_COMP) {
-                        // comp-comp interaction
-                        //AN(0);
-                        do_repulForce(*u, *v, k, num);
-                        continue;
-                    }
-                    
-                    if(!comp && v->getType() == NET_ELT_TYPE_COMP) {
-                        comp = dynamic_cast<Compartment*>(v); //get the associated compartment
-                        v = u;
-                    }
-                    
-                    if(comp) {
-                        if(v->getType() != NET_ELT_TYPE_COMP) {
-                            if(comp->contains(v)) {
-                                // node inside a compartment
-                                do_internalForce(v, *comp, k);
-                                continue;
-                            }
-                        }
-                    }
+    // single iteration with compartment interaction
+    void FRSingle(fr_options& opt, LayoutWorkspace& ws, Real T, Real k, uint64 num) {
+        compsPrepare(ws);
+        ws.packComps();
+        packedPrepare(ws);
+
+        packedRepulsion(ws, k, num);
+
+        // compartment-compartment repulsion (weak & short-ranged)
+        const uint64 nc = ws.comp_.size();
+        for(uint64 a=0; a<nc; ++a) {
+            for(uint64 b=a+1; b<nc; ++b) {
+                Point disp(ws.cx_[a] - ws.cx_[b], ws.cy_[a] - ws.cy_[b]);
+                Point f(repulForce(disp, ws.cdeg_[a]+ws.cdeg_[b], ws.csize_[b] + ws.csize_[a], k, num));
+                if(disp.mag2() >= 1e-6) {
+                    f = 0.01*f;
+                    if(max(disp.mag(), 0.1) > 25.)
+                        f = Point(0,0);
                 }
-                do_repulForce(*u, *v, k, num);
-            }
-        }
-        
-        // attractive forces
-        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
-            Reaction* u = *i;
-            for(Reaction::NodeIt j=u->NodesBegin(); j!=u->NodesEnd(); ++j) {
-                Node* v = j->first;
-                do_attForce(*u, *v, k);
+                ws.comp_[a]->addDelta(f);
+                ws.comp_[b]->addDelta(-f);
             }
         }
 
-        if (opt.grav >= 5.) {
-          for(uint64 i=0; i<net.getNElts(); ++i) {
-            NetworkElement* u = net.getElt(i);;
-            if (u->getType() == NET_ELT_TYPE_SPEC) {
-              do_gravity(*u, Point(opt.baryx, opt.baryy), opt.grav, k);
+        // compartment-species: contact force from the containing compartment,
+        // repulsion from the others (reactions & compartments do not interact)
+        for(uint64 c=0; c<nc; ++c) {
+            Compartment* comp = ws.comp_[c];
+            for(uint64 z=0; z<ws.spec_.size(); ++z) {
+                uint64 i = ws.spec_[z];
+                Point f;
+                if(ws.cont_[i] == c) {
+                    const Real* b = &ws.ext_[4*i];
+                    f = comp->internalForce(Box(Point(b[0], b[1]), Point(b[2], b[3])), k*k, 10.);
+                } else {
+                    Point g(repulForce(Point(ws.cx_[c] - ws.x_[i], ws.cy_[c] - ws.y_[i]), ws.cdeg_[c]+ws.deg_[i],
+                                       max(ws.w_[i], ws.h_[i]) + ws.csize_[c], k, num));
+                    comp->addDelta(g);
+                    f = -g;
+                }
+                ws.vx_[i] += f.x;
+                ws.vy_[i] += f.y;
             }
-          }
         }
-        
-        net.capDeltas(T);
-        
-        //net.updatePositions(0.000025*T);
-//         net.updatePositions(0.0001*T);
-        net.updatePositions(T);
-        
-        //boundary
-        /*if(opt.boundary) {
-            net.doNodeBoxContactForce(bound, T, 10.);
-        }*/
+
+        packedAttraction(ws, k);
+        packedGravity(opt, ws, k);
+
+        compsMove(ws, T);
+        packedMove(ws, T);
     }
     
+    // single iteration over the packed state (compartment interaction disabled)
+    void FRSinglePacked(fr_options& opt, LayoutWorkspace& ws, Real T, Real k, uint64 num) {
+        // compartments do not interact, but still relax toward their rest area
+        compsPrepare(ws);
+        packedPrepare(ws);
+
+        packedRepulsion(ws, k, num);
+        packedAttraction(ws, k);
+        packedGravity(opt, ws, k);
+
+        compsMove(ws, T);
+        packedMove(ws, T);
+    }
+
     void FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l) {
+        LayoutWorkspace ws;
+        FruchtermanReingold(opt, net, can, l, ws);
+    }
+
+    void FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l, LayoutWorkspace& ws) {
         //AT(feenableexcept(FE_DIVBYZERO) != -1);
         Box bound;
         if(opt.boundary) {
@@ -302,7 +391,12 @@ namespace Graphfab {
             }
         }
         
+        ws.bind(net, opt.enable_comps ? true : false);
+
         uint64 num = net.getTotalNumPts();
+        // contracted chains reduce the number of elements to settle
+        if(ws.getChains().getNumContracted())
+            num = ws.size();
         uint64 m = 100.*log((Real)num+2);
         
 //         std::cerr << "m = " << m << "\n";
@@ -334,7 +428,14 @@ namespace Graphfab {
 //             if (z == m-1)
 //               dumpForces_ = true;
             
-            FRSingle(opt, net, bound, T, k, num);
+            if(opt.enable_comps)
+                FRSingle(opt, ws, T, k, num);
+            else
+                FRSinglePacked(opt, ws, T, k, num);
+
+            // intermediate state for readers on other threads (the final one is published below)
+            if(ws.getPublishStride() && !((z+1) % ws.getPublishStride()) && z+1 < m)
+                ws.publish();
             
 //             std::cout << "Network:\n";
 //             net.dump(std::cout, 0);
@@ -365,10 +466,15 @@ namespace Graphfab {
             #endif
         }
         
+        ws.commit();
+        
         if(!opt.enable_comps)
             net.resizeCompsEnclose(opt.padding);
         
-        net.rebuildCurves();
+        net.refreshCurves();
+
+        if(ws.getPublishStride())
+            ws.getSnapshots().publish(net);
     }
 
 }
@@ -84,6 +84,31 @@ typedef struct __fr_options {
     Real padding;
 } fr_options;
 
+/**
+ *  @brief Scratch storage for the layout algorithm
+ *  @details A workspace owns the packed positions, deltas and per-element
+ *  constants used by the layout algorithm. Reusing one workspace across
+ *  repeated layouts of the same (or a growing) network avoids heap allocation
+ *  once the buffers have reached their working size.
+ *  \ingroup C_API
+ */
+typedef struct {
+    /// @private
+    void* w;
+} gf_layoutWorkspace;
+
+/**
+ *  @brief Positions and curves of a network published by a running layout
+ *  @details Obtained from @ref gf_layoutWorkspace_acquireSnapshot and
+ *  unchanged until released with @ref gf_layoutWorkspace_releaseSnapshot.
+ *  Elements are in network element order; coordinates are global.
+ *  \ingroup C_API
+ */
+typedef struct {
+    /// @private
+    void* s;
+} gf_layoutSnapshot;
+
 /**
  *  @author JKM
  *  @brief Run the autolayout (Fruchterman-Reingold) algorithm on a given layout structure
@@ -103,6 +128,101 @@ _GraphfabExport void gf_doLayoutAlgorithm(fr_options opt, gf_layoutInfo* l);
  */
 _GraphfabExport void gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c);
 
+/** @brief Create a layout workspace
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_layoutWorkspace gf_layoutWorkspace_new();
+
+/** @brief Release a layout workspace
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_releaseLayoutWorkspace(gf_layoutWorkspace* ws);
+
+/** @brief Contract linear chains before layout
+ *  @details When enabled, maximal chains of species used by exactly two
+ *  reactions and uni-uni reactions (cascades A -> B -> C ...) are replaced by a
+ *  single weighted edge between their ends during layout, then placed evenly
+ *  along that edge. Has no effect when compartment interaction is enabled.
+ *  @param[in] ws The workspace
+ *  @param[in] enable Nonzero to enable
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layoutWorkspace_setChainContraction(gf_layoutWorkspace* ws, int enable);
+
+/** @brief Publish snapshots of the layout while it runs
+ *  @details When @a stride is nonzero, a layout run with @a ws publishes the
+ *  positions and curves after every @a stride iterations and once at the end.
+ *  Another thread can then draw the intermediate states with
+ *  @ref gf_layoutWorkspace_acquireSnapshot without blocking the layout; it must
+ *  not access the network itself while the layout runs.
+ *  @param[in] ws The workspace
+ *  @param[in] stride Number of iterations between snapshots (0 disables)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layoutWorkspace_setPublishStride(gf_layoutWorkspace* ws, uint64_t stride);
+
+/** @brief Get the latest snapshot published by a layout using @a ws
+ *  @details Safe to call from any thread; never waits for the layout.
+ *  @param[in] ws The workspace
+ *  @return The snapshot (its @c s field is NULL if nothing was published yet)
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_layoutSnapshot gf_layoutWorkspace_acquireSnapshot(gf_layoutWorkspace* ws);
+
+/** @brief Release a snapshot obtained from @ref gf_layoutWorkspace_acquireSnapshot
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layoutWorkspace_releaseSnapshot(gf_layoutWorkspace* ws, gf_layoutSnapshot* s);
+
+/** @brief Sequence number of a snapshot (higher is newer)
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_layoutSnapshot_getEpoch(const gf_layoutSnapshot* s);
+
+/** @brief Number of elements in a snapshot
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_layoutSnapshot_getNumElts(const gf_layoutSnapshot* s);
+
+/** @brief The element the @a k-th entry was taken from
+ *  @details Compare with the handle field of @ref gf_node, @ref gf_reaction or
+ *  @ref gf_compartment to identify the entry.
+ *  \ingroup C_API
+ */
+_GraphfabExport void* gf_layoutSnapshot_getElt(const gf_layoutSnapshot* s, uint64_t k);
+
+/** @brief Centroid of the @a k-th element
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_point gf_layoutSnapshot_getCentroid(const gf_layoutSnapshot* s, uint64_t k);
+
+/** @brief Number of curves of the @a k-th element (zero unless a reaction)
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_layoutSnapshot_getNumCurves(const gf_layoutSnapshot* s, uint64_t k);
+
+/** @brief Control points of the @a i-th curve of the @a k-th element
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_curveCP gf_layoutSnapshot_getCurveCPs(const gf_layoutSnapshot* s, uint64_t k, uint64_t i);
+
+/** @brief Same as @ref gf_doLayoutAlgorithm but use the buffers in @a ws
+ *  @param[in] opt The options controlling the layout algorithm
+ *  @param[in/out] l The layout info
+ *  @param[in] ws The workspace
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_doLayoutAlgorithmWorkspace(fr_options opt, gf_layoutInfo* l, gf_layoutWorkspace* ws);
+
+/** @brief Same as @ref gf_doLayoutAlgorithm2 but use the buffers in @a ws
+ *  @param[in] opt The options controlling the layout algorithm
+ *  @param[in/out] n The network
+ *  @param[in] c The canvas (may be NULL)
+ *  @param[in] ws The workspace
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_doLayoutAlgorithm2Workspace(fr_options opt, gf_network* n, gf_canvas* c, gf_layoutWorkspace* ws);
+
 /** @brief Generate default values for the layout options
  *  @param[out] l The layout info in which to store the options
  *  \ingroup C_API
@@ -125,12 +245,17 @@ _GraphfabExport void gf_layout_setStiffness(fr_options* opt, double k);
 
 // #include <string>
 
+#include "graphfab/layout/workspace.h"
+
 #include <iostream>
 
 namespace Graphfab {
 
     /// Software Practice & Experience '91
     void FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l);
+
+    /// Same as above but reuse the buffers in @a ws
+    void FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l, LayoutWorkspace& ws);
     
 }
 
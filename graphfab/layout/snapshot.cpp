@@ -0,0 +1,213 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/snapshot.h"
+#include "graphfab/layout/fr.h"
+
+namespace Graphfab {
+
+    // CLASS LayoutSnapshot:
+
+    Point LayoutSnapshot::getCentroid(uint64 k, NetworkElement::COORD_SYSTEM coord) const {
+        if(coord == NetworkElement::COORD_SYSTEM_GLOBAL)
+            return tf_*p_[k];
+        return p_[k];
+    }
+
+    Box LayoutSnapshot::getExtents(uint64 k, NetworkElement::COORD_SYSTEM coord) const {
+        if(coord == NetworkElement::COORD_SYSTEM_GLOBAL)
+            return tf_*ext_[k];
+        return ext_[k];
+    }
+
+    LayoutSnapshot::Curve LayoutSnapshot::getCurve(uint64 c, NetworkElement::COORD_SYSTEM coord) const {
+        Curve r = curves_[c];
+        if(coord == NetworkElement::COORD_SYSTEM_GLOBAL) {
+            r.s  = tf_*r.s;
+            r.c1 = tf_*r.c1;
+            r.c2 = tf_*r.c2;
+            r.e  = tf_*r.e;
+        }
+        return r;
+    }
+
+    void LayoutSnapshot::capture(Network& net, uint64 epoch) {
+        epoch_ = epoch;
+        tf_ = net.getTransform();
+
+        // clear & push_back keep the capacity, so a recycled snapshot does not allocate
+        elt_.clear();
+        type_.clear();
+        p_.clear();
+        ext_.clear();
+        curveoff_.clear();
+        curves_.clear();
+
+        for(Network::EltIt i=net.EltsBegin(); i!=net.EltsEnd(); ++i) {
+            NetworkElement* e = *i;
+            elt_.push_back(e);
+            type_.push_back(e->getType());
+            p_.push_back(e->getCentroid());
+            ext_.push_back(e->getExtents());
+            curveoff_.push_back(curves_.size());
+            if(e->getType() == NET_ELT_TYPE_RXN) {
+                Graphfab::Reaction* r = static_cast<Graphfab::Reaction*>(e);
+                for(uint64 c=0; c<r->getNumCurves(); ++c) {
+                    RxnBezier* b = r->getCurve(c);
+                    Curve x;
+                    x.s = b->s;
+                    x.c1 = b->c1;
+                    x.c2 = b->c2;
+                    x.e = b->e;
+                    x.role = b->getRole();
+                    curves_.push_back(x);
+                }
+            }
+        }
+        curveoff_.push_back(curves_.size());
+    }
+
+    // CLASS LayoutSnapshotBuffer:
+
+    LayoutSnapshotBuffer::~LayoutSnapshotBuffer() {
+        for(std::vector<LayoutSnapshot*>::iterator i=pool_.begin(); i!=pool_.end(); ++i) {
+            AT(!(*i)->readers_.load(), "Snapshot still held by a reader");
+            delete *i;
+        }
+    }
+
+    void LayoutSnapshotBuffer::publish(Network& net) {
+        LayoutSnapshot* cur = cur_.load();
+        LayoutSnapshot* s = NULL;
+        // a reader that pins a snapshot after this check re-reads cur_ and backs
+        // off, since s only becomes current again once it has been filled
+        for(std::vector<LayoutSnapshot*>::iterator i=pool_.begin(); i!=pool_.end(); ++i) {
+            if(*i != cur && !(*i)->readers_.load()) {
+                s = *i;
+                break;
+            }
+        }
+        if(!s) {
+            s = new LayoutSnapshot();
+            pool_.push_back(s);
+        }
+        s->capture(net, epoch_.load() + 1);
+        cur_.store(s);
+        epoch_.store(s->getEpoch());
+    }
+
+    const LayoutSnapshot* LayoutSnapshotBuffer::acquire() const {
+        for(;;) {
+            LayoutSnapshot* s = cur_.load();
+            if(!s)
+                return NULL;
+            s->readers_.fetch_add(1);
+            // still current, so the writer will not pick it until released
+            if(cur_.load() == s)
+                return s;
+            s->readers_.fetch_sub(1);
+        }
+    }
+
+    void LayoutSnapshotBuffer::release(const LayoutSnapshot* s) const {
+        AN(s, "No snapshot");
+        s->readers_.fetch_sub(1);
+    }
+
+}
+
+void gf_layoutWorkspace_setPublishStride(gf_layoutWorkspace* ws, uint64_t stride) {
+    AN(ws && ws->w, "No workspace");
+    ((Graphfab::LayoutWorkspace*)ws->w)->setPublishStride(stride);
+}
+
+gf_layoutSnapshot gf_layoutWorkspace_acquireSnapshot(gf_layoutWorkspace* ws) {
+    AN(ws && ws->w, "No workspace");
+    gf_layoutSnapshot s;
+    s.s = (void*)((Graphfab::LayoutWorkspace*)ws->w)->getSnapshots().acquire();
+    return s;
+}
+
+void gf_layoutWorkspace_releaseSnapshot(gf_layoutWorkspace* ws, gf_layoutSnapshot* s) {
+    AN(ws && ws->w, "No workspace");
+    if(!s->s)
+        return;
+    ((Graphfab::LayoutWorkspace*)ws->w)->getSnapshots().release((const Graphfab::LayoutSnapshot*)s->s);
+    s->s = NULL;
+}
+
+uint64_t gf_layoutSnapshot_getEpoch(const gf_layoutSnapshot* s) {
+    AN(s && s->s, "No snapshot");
+    return ((const Graphfab::LayoutSnapshot*)s->s)->getEpoch();
+}
+
+uint64_t gf_layoutSnapshot_getNumElts(const gf_layoutSnapshot* s) {
+    AN(s && s->s, "No snapshot");
+    return ((const Graphfab::LayoutSnapshot*)s->s)->getNumElts();
+}
+
+void* gf_layoutSnapshot_getElt(const gf_layoutSnapshot* s, uint64_t k) {
+    AN(s && s->s, "No snapshot");
+    return (void*)((const Graphfab::LayoutSnapshot*)s->s)->getElt(k);
+}
+
+gf_point gf_layoutSnapshot_getCentroid(const gf_layoutSnapshot* s, uint64_t k) {
+    AN(s && s->s, "No snapshot");
+    Graphfab::Point p = ((const Graphfab::LayoutSnapshot*)s->s)->getCentroid(k, Graphfab::NetworkElement::COORD_SYSTEM_GLOBAL);
+    gf_point r;
+    r.x = p.x;
+    r.y = p.y;
+    return r;
+}
+
+uint64_t gf_layoutSnapshot_getNumCurves(const gf_layoutSnapshot* s, uint64_t k) {
+    AN(s && s->s, "No snapshot");
+    const Graphfab::LayoutSnapshot* x = (const Graphfab::LayoutSnapshot*)s->s;
+    return x->curvesEnd(k) - x->curvesBegin(k);
+}
+
+gf_curveCP gf_layoutSnapshot_getCurveCPs(const gf_layoutSnapshot* s, uint64_t k, uint64_t i) {
+    AN(s && s->s, "No snapshot");
+    const Graphfab::LayoutSnapshot* x = (const Graphfab::LayoutSnapshot*)s->s;
+    AT(x->curvesBegin(k) + i < x->curvesEnd(k), "No such curve");
+    Graphfab::LayoutSnapshot::Curve c = x->getCurve(x->curvesBegin(k) + i, Graphfab::NetworkElement::COORD_SYSTEM_GLOBAL);
+    gf_curveCP cp;
+    cp.s.x = c.s.x;
+    cp.s.y = c.s.y;
+    cp.c1.x = c.c1.x;
+    cp.c1.y = c.c1.y;
+    cp.c2.x = c.c2.x;
+    cp.c2.y = c.c2.y;
+    cp.e.x = c.e.x;
+    cp.e.y = c.e.y;
+    return cp;
+}
@@ -0,0 +1,162 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file snapshot.h
+ * @brief Consistent views of the layout for concurrent readers
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_SNAPSHOT_H_
+#define __SBNW_LAYOUT_SNAPSHOT_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/network.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+#include <atomic>
+
+namespace Graphfab {
+
+    /** @brief Positions and curve control points of a network at one point in time
+     * @details Holds the centroid and extents of every element (in network
+     * element order) and the control points of the curves of every reaction,
+     * in local coordinates together with the view transform. A snapshot is
+     * never modified while a reader holds it. Obtain one with
+     * @ref LayoutSnapshotBuffer::acquire.
+     */
+    class _GraphfabExport LayoutSnapshot {
+        public:
+            /// Control points of one curve
+            struct Curve {
+                Point s, c1, c2, e;
+                RxnCurveType role;
+            };
+
+            LayoutSnapshot() : epoch_(0), readers_(0) {}
+
+            /// Sequence number of the snapshot; higher is newer
+            uint64 getEpoch() const { return epoch_; }
+
+            uint64 getNumElts() const { return elt_.size(); }
+
+            /** @brief The element the @a k-th entry was taken from
+             * @details For identification only: the element itself may be modified
+             * by the thread that published the snapshot.
+             */
+            const NetworkElement* getElt(uint64 k) const { return elt_[k]; }
+
+            NetworkEltType getEltType(uint64 k) const { return type_[k]; }
+
+            Point getCentroid(uint64 k, NetworkElement::COORD_SYSTEM coord = NetworkElement::COORD_SYSTEM_LOCAL) const;
+
+            Box getExtents(uint64 k, NetworkElement::COORD_SYSTEM coord = NetworkElement::COORD_SYSTEM_LOCAL) const;
+
+            /// Curves of element @a k are [@ref curvesBegin(k), @ref curvesEnd(k)) (empty unless a reaction)
+            uint64 curvesBegin(uint64 k) const { return curveoff_[k]; }
+            uint64 curvesEnd(uint64 k) const { return curveoff_[k+1]; }
+
+            uint64 getNumCurves() const { return curves_.size(); }
+
+            Curve getCurve(uint64 c, NetworkElement::COORD_SYSTEM coord = NetworkElement::COORD_SYSTEM_LOCAL) const;
+
+            /// View transform of the network when the snapshot was taken
+            const Affine2d& getTransform() const { return tf_; }
+
+        protected:
+            friend class LayoutSnapshotBuffer;
+
+            /// Copy the state of @a net (reuses the buffers)
+            void capture(Network& net, uint64 epoch);
+
+            uint64 epoch_;
+            Affine2d tf_;
+
+            std::vector<const NetworkElement*> elt_;
+            std::vector<NetworkEltType> type_;
+            std::vector<Point> p_;
+            std::vector<Box> ext_;
+            std::vector<uint64> curveoff_;
+            std::vector<Curve> curves_;
+
+            /// Number of readers holding the snapshot
+            mutable std::atomic<uint64> readers_;
+
+        private:
+            LayoutSnapshot(const LayoutSnapshot&);
+            LayoutSnapshot& operator=(const LayoutSnapshot&);
+    };
+
+    /** @brief Publishes snapshots from one writer thread to any number of readers
+     * @details The writer (the layout thread) fills a snapshot nobody is reading
+     * and makes it current with one atomic store; readers pin the current
+     * snapshot with a counter and never block or wait on the writer. Buffers
+     * are recycled once released, so in the steady state there are two (one
+     * current, one being filled) and publishing does not allocate. Readers must
+     * release every snapshot before the buffer is destroyed.
+     */
+    class _GraphfabExport LayoutSnapshotBuffer {
+        public:
+            LayoutSnapshotBuffer() : cur_(NULL), epoch_(0) {}
+
+            ~LayoutSnapshotBuffer();
+
+            /// Capture @a net and make it the current snapshot (writer thread only)
+            void publish(Network& net);
+
+            /// Pin the current snapshot; NULL if nothing was published yet (any thread)
+            const LayoutSnapshot* acquire() const;
+
+            /// Unpin a snapshot returned by @ref acquire (any thread)
+            void release(const LayoutSnapshot* s) const;
+
+            /// Number of snapshots published so far
+            uint64 getEpoch() const { return epoch_.load(); }
+
+        protected:
+            std::atomic<LayoutSnapshot*> cur_;
+            std::atomic<uint64> epoch_;
+            /// All buffers (writer only)
+            std::vector<LayoutSnapshot*> pool_;
+
+        private:
+            LayoutSnapshotBuffer(const LayoutSnapshotBuffer&);
+            LayoutSnapshotBuffer& operator=(const LayoutSnapshotBuffer&);
+    };
+
+}
+
+#endif
+
+#endif
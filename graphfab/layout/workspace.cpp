@@ -0,0 +1,185 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/workspace.h"
+#include "graphfab/math/min_max.h"
+
+#include <algorithm>
+
+namespace Graphfab {
+
+    static const uint64 npos = (uint64)-1;
+
+    // CLASS LayoutWorkspace:
+
+    uint64 LayoutWorkspace::find(NetworkElement* e) const {
+        std::vector< std::pair<NetworkElement*, uint64> >::const_iterator i =
+            std::lower_bound(index_.begin(), index_.end(), std::make_pair(e, (uint64)0));
+        if(i == index_.end() || i->first != e)
+            return npos;
+        return i->second;
+    }
+
+    void LayoutWorkspace::bind(Network& net, bool comps) {
+        net_ = &net;
+
+        elt_.clear();
+        type_.clear();
+        lock_.clear();
+        deg_.clear();
+        x_.clear();
+        y_.clear();
+        vx_.clear();
+        vy_.clear();
+        ext_.clear();
+        w_.clear();
+        h_.clear();
+        att_.clear();
+        attw_.clear();
+        comp_.clear();
+        spec_.clear();
+        cont_.clear();
+        index_.clear();
+
+        const bool contract = contract_ && !comps;
+        if(contract)
+            chains_.contract(net);
+        else
+            chains_.clear();
+
+        for(uint64 i=0; i<net.getNElts(); ++i) {
+            NetworkElement* e = net.getElt(i);
+            if(e->getType() == NET_ELT_TYPE_COMP)
+                continue;
+            if(contract && chains_.isContracted(e))
+                continue;
+            if(e->getType() == NET_ELT_TYPE_SPEC)
+                spec_.push_back(elt_.size());
+            index_.push_back(std::make_pair(e, (uint64)elt_.size()));
+            elt_.push_back(e);
+            type_.push_back(e->getType());
+            lock_.push_back(e->isLocked());
+            deg_.push_back((Real)e->degree());
+            x_.push_back(e->_p().x);
+            y_.push_back(e->_p().y);
+            vx_.push_back(0.);
+            vy_.push_back(0.);
+            ext_.push_back(e->_ext().getMin().x);
+            ext_.push_back(e->_ext().getMin().y);
+            ext_.push_back(e->_ext().getMax().x);
+            ext_.push_back(e->_ext().getMax().y);
+            w_.push_back(0.);
+            h_.push_back(0.);
+        }
+
+        std::sort(index_.begin(), index_.end());
+
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+            Reaction* r = *i;
+            uint64 ri = find(r);
+            if(ri == npos)
+                continue;
+            for(Reaction::ConstNodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                uint64 si = find(j->first);
+                if(si == npos)
+                    continue;
+                att_.push_back(ri);
+                att_.push_back(si);
+                attw_.push_back(1.);
+            }
+        }
+
+        // a chain of L edges under tension F stretches to L*sqrt(F*k), so the
+        // equivalent single spring is L^2 times softer
+        for(uint64 c=0; c<chains_.getNumChains(); ++c) {
+            uint64 a = find(chains_.getChainStart(c));
+            uint64 b = find(chains_.getChainEnd(c));
+            AT(a != npos && b != npos, "Chain endpoint not packed");
+            Real len = (Real)chains_.getChainLength(c);
+            att_.push_back(a);
+            att_.push_back(b);
+            attw_.push_back(len*len);
+        }
+
+        for(Network::CompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i)
+            comp_.push_back(*i);
+
+        if(comps) {
+            cont_.resize(elt_.size(), npos);
+            for(uint64 c=0; c<comp_.size(); ++c) {
+                for(Compartment::EltIt j=comp_[c]->EltsBegin(); j!=comp_[c]->EltsEnd(); ++j) {
+                    uint64 k = find(*j);
+                    // first compartment listing the element wins
+                    if(k != npos && cont_[k] == npos)
+                        cont_[k] = c;
+                }
+            }
+        }
+    }
+
+    void LayoutWorkspace::packComps() {
+        cx_.resize(comp_.size());
+        cy_.resize(comp_.size());
+        csize_.resize(comp_.size());
+        cdeg_.resize(comp_.size());
+        for(uint64 c=0; c<comp_.size(); ++c) {
+            const Box& b = comp_[c]->_ext();
+            Point p(b.getCenter());
+            cx_[c] = p.x;
+            cy_[c] = p.y;
+            csize_[c] = max(b.width(), b.height());
+            cdeg_[c] = (Real)comp_[c]->_deg;
+        }
+    }
+
+    void LayoutWorkspace::commit() {
+        AN(net_, "Workspace not bound");
+        for(uint64 i=0; i<elt_.size(); ++i) {
+            NetworkElement* e = elt_[i];
+            e->_p() = Point(x_[i], y_[i]);
+            e->_ext() = Box(Point(ext_[4*i], ext_[4*i+1]), Point(ext_[4*i+2], ext_[4*i+3]));
+            if(type_[i] == NET_ELT_TYPE_RXN)
+                e->_r() = 10.;
+            else
+                e->_r() = e->_ext().maxDim()*0.5;
+        }
+        if(contract_)
+            chains_.expand();
+    }
+
+    void LayoutWorkspace::publish() {
+        commit();
+        net_->refreshCurves();
+        snaps_.publish(*net_);
+    }
+
+}
@@ -0,0 +1,161 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file workspace.h
+ * @brief Reusable scratch storage for the layout algorithm
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_WORKSPACE_H_
+#define __SBNW_LAYOUT_WORKSPACE_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/network.h"
+#include "graphfab/layout/chain.h"
+#include "graphfab/layout/snapshot.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+#include <utility>
+
+namespace Graphfab {
+
+    /** @brief Packed layout state for a network
+     * @details Holds the positions, deltas, extents and degree/size constants of
+     * all species and reaction elements in flat arrays (in network element order),
+     * together with the reaction-species attraction pairs. Buffers are cleared
+     * but never shrunk, so binding the same (or a smaller) network again performs
+     * no heap allocation.
+     */
+    class _GraphfabExport LayoutWorkspace {
+        public:
+            LayoutWorkspace()
+                : net_(NULL), contract_(false), stride_(0) {}
+
+            /** @brief Pack the state of @a net into the buffers
+             * @details If chain contraction is enabled, chain interiors are left
+             * out and replaced by weighted super-edges between the chain ends.
+             * If @a comps is true (compartment interaction), chains are never
+             * contracted and the compartment containing each species is recorded.
+             */
+            void bind(Network& net, bool comps = false);
+
+            /// Refresh the packed compartment centroids, sizes & degrees from the compartments
+            void packComps();
+
+            /// Write positions & extents back to the network elements (re-expanding chains)
+            void commit();
+
+            /// Enable/disable contraction of linear chains (see @ref ChainContraction)
+            void setChainContraction(bool contract) { contract_ = contract; }
+
+            bool getChainContraction() const { return contract_; }
+
+            /** @brief Publish a snapshot every @a stride iterations (0 disables)
+             * @details Lets another thread draw the layout while it runs: the layout
+             * thread writes the packed state back to the network, refreshes the curves
+             * and publishes to @ref getSnapshots after every @a stride iterations and
+             * once at the end. Other threads must read the snapshots, not the network.
+             */
+            void setPublishStride(uint64 stride) { stride_ = stride; }
+
+            uint64 getPublishStride() const { return stride_; }
+
+            /// Snapshots published by the layout (safe to acquire from any thread)
+            LayoutSnapshotBuffer& getSnapshots() { return snaps_; }
+
+            /// Write back the current state and publish it (layout thread only)
+            void publish();
+
+            /// Chains found by the last @ref bind
+            const ChainContraction& getChains() const { return chains_; }
+
+            /// The bound network (NULL if none)
+            Network* getNetwork() const { return net_; }
+
+            /// Number of packed (non-compartment) elements
+            uint64 size() const { return elt_.size(); }
+
+            /// Packed elements, in network element order
+            std::vector<NetworkElement*> elt_;
+            /// Element type
+            std::vector<NetworkEltType> type_;
+            /// Locked elements do not move
+            std::vector<int> lock_;
+            /// Degree (as Real)
+            std::vector<Real> deg_;
+            /// Centroids
+            std::vector<Real> x_, y_;
+            /// Deltas (forces)
+            std::vector<Real> vx_, vy_;
+            /// Extents (min x, min y, max x, max y)
+            std::vector<Real> ext_;
+            /// Width & height as seen by the force computation
+            std::vector<Real> w_, h_;
+            /// Attraction pairs (reaction index, species index) in reaction order,
+            /// followed by chain super-edges
+            std::vector<uint64> att_;
+            /// Attraction weights (1 for reaction-species pairs; squared chain length for super-edges)
+            std::vector<Real> attw_;
+            /// Compartments (updated through the object interface)
+            std::vector<Compartment*> comp_;
+            /// Packed indices of the species (the species batch)
+            std::vector<uint64> spec_;
+            /// Index in @ref comp_ of the compartment containing each packed
+            /// element, or -1 (only filled when bound with compartments)
+            std::vector<uint64> cont_;
+            /// Compartment centroids, sizes (larger of width & height) & degrees; see @ref packComps
+            std::vector<Real> cx_, cy_, csize_, cdeg_;
+
+        protected:
+            /// Index of @a e in the packed arrays
+            uint64 find(NetworkElement* e) const;
+
+            /// Sorted (element, index) pairs used to resolve attraction pairs
+            std::vector< std::pair<NetworkElement*, uint64> > index_;
+
+            Network* net_;
+
+            bool contract_;
+            ChainContraction chains_;
+
+            uint64 stride_;
+            LayoutSnapshotBuffer snaps_;
+    };
+
+}
+
+#endif
+
+#endif
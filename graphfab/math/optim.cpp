@@ -0,0 +1,189 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/math/optim.h"
+#include "graphfab/math/min_max.h"
+
+#include <math.h>
+
+namespace Graphfab {
+
+    static Real dot(const Real* a, const Real* b, uint64 n) {
+        Real r = 0.;
+        for(uint64 i=0; i<n; ++i)
+            r += a[i]*b[i];
+        return r;
+    }
+
+    // CLASS LBFGSOptimizer:
+
+    LBFGSOptimizer::LBFGSOptimizer(uint64 m, uint64 maxit)
+        : m_(m ? m : 1), maxit_(maxit), gtol_(1e-5), ftol_(1e-9), maxstep_(50.) {}
+
+    void LBFGSOptimizer::reserve(uint64 n) {
+        // resize never shrinks capacity, so steady-state calls do not allocate
+        s_.resize(m_*n);
+        y_.resize(m_*n);
+        rho_.resize(m_);
+        alpha_.resize(m_);
+        g_.resize(n);
+        gp_.resize(n);
+        d_.resize(n);
+        xp_.resize(n);
+    }
+
+    uint64 LBFGSOptimizer::minimize(ObjectiveFunction& f, Real* x) {
+        const uint64 n = f.getDimension();
+        if(!n)
+            return 0;
+        reserve(n);
+
+        Real* g  = &g_[0];
+        Real* gp = &gp_[0];
+        Real* d  = &d_[0];
+        Real* xp = &xp_[0];
+
+        Real fx = f.evaluate(x, g);
+
+        // history is a ring buffer: newest pair at head, nhist valid entries
+        uint64 head = 0, nhist = 0;
+        uint64 it;
+
+        for(it=0; it<maxit_; ++it) {
+            Real gnorm = sqrt(dot(g, g, n));
+            Real xnorm = sqrt(dot(x, x, n));
+            if(gnorm <= gtol_*max(1., xnorm))
+                break;
+
+            // two-loop recursion
+            for(uint64 i=0; i<n; ++i)
+                d[i] = -g[i];
+            for(uint64 k=0; k<nhist; ++k) {
+                uint64 h = (head + m_ - k) % m_;
+                alpha_[h] = rho_[h]*dot(&s_[h*n], d, n);
+                const Real* yh = &y_[h*n];
+                for(uint64 i=0; i<n; ++i)
+                    d[i] -= alpha_[h]*yh[i];
+            }
+            if(nhist) {
+                const Real* yh = &y_[head*n];
+                Real gamma = 1./(rho_[head]*dot(yh, yh, n));
+                for(uint64 i=0; i<n; ++i)
+                    d[i] *= gamma;
+            }
+            for(uint64 k=nhist; k>0; --k) {
+                uint64 h = (head + m_ - (k-1)) % m_;
+                Real beta = rho_[h]*dot(&y_[h*n], d, n);
+                const Real* sh = &s_[h*n];
+                for(uint64 i=0; i<n; ++i)
+                    d[i] += (alpha_[h] - beta)*sh[i];
+            }
+
+            Real dg = dot(d, g, n);
+            if(dg >= 0.) {
+                // not a descent direction: fall back to steepest descent
+                for(uint64 i=0; i<n; ++i)
+                    d[i] = -g[i];
+                dg = -gnorm*gnorm;
+                nhist = 0;
+            }
+
+            // limit the largest coordinate displacement
+            Real dmax = 0.;
+            for(uint64 i=0; i<n; ++i)
+                dmax = max(dmax, fabs(d[i]));
+            Real step = 1.;
+            if(dmax*step > maxstep_)
+                step = maxstep_/dmax;
+
+            for(uint64 i=0; i<n; ++i) {
+                xp[i] = x[i];
+                gp[i] = g[i];
+            }
+            Real fp = fx;
+
+            // backtracking line search
+            bool accepted = false;
+            for(int ls=0; ls<40; ++ls) {
+                for(uint64 i=0; i<n; ++i)
+                    x[i] = xp[i] + step*d[i];
+                fx = f.evaluate(x, g);
+                if(fx <= fp + 1e-4*step*dg) {
+                    accepted = true;
+                    break;
+                }
+                step *= 0.5;
+            }
+
+            if(!accepted) {
+                for(uint64 i=0; i<n; ++i) {
+                    x[i] = xp[i];
+                    g[i] = gp[i];
+                }
+                fx = fp;
+                if(nhist) {
+                    // discard curvature info and retry along the gradient
+                    nhist = 0;
+                    continue;
+                }
+                break;
+            }
+
+            // store the correction pair (skipped if curvature condition fails)
+            uint64 next = nhist ? (head + 1) % m_ : head;
+            Real* sn = &s_[next*n];
+            Real* yn = &y_[next*n];
+            for(uint64 i=0; i<n; ++i) {
+                sn[i] = x[i] - xp[i];
+                yn[i] = g[i] - gp[i];
+            }
+            Real sy = dot(sn, yn, n);
+            if(sy > 1e-10*dot(yn, yn, n)) {
+                rho_[next] = 1./sy;
+                head = next;
+                if(nhist < m_)
+                    ++nhist;
+            } else if(nhist == m_) {
+                // the rejected pair overwrote the oldest entry
+                --nhist;
+            }
+
+            if(fabs(fp - fx) <= ftol_*max(1., fabs(fx))) {
+                ++it;
+                break;
+            }
+        }
+
+        return it;
+    }
+
+}
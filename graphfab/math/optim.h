@@ -0,0 +1,129 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/**
+ * @author JKM
+ * @file optim.h
+ * @copyright BSD 3-clause (details in source)
+ * @brief Unconstrained minimization of differentiable objectives
+ * @details Provides the objective/optimizer interface used by the energy-based
+ * layout engine, along with a limited-memory BFGS implementation.
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_OPTIM_H_
+#define __SBNW_OPTIM_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+//-- C++ code --
+# ifdef __cplusplus
+
+# include <vector>
+
+namespace Graphfab {
+
+    /** @brief A differentiable scalar function of a flat coordinate vector
+     * @details Implement this to expose an objective to an @ref Optimizer.
+     */
+    class _GraphfabExport ObjectiveFunction {
+        public:
+            virtual ~ObjectiveFunction() {}
+
+            /// Number of variables
+            virtual uint64 getDimension() const = 0;
+
+            /** @brief Evaluate the objective
+             * @param[in] x The coordinates (length @ref getDimension)
+             * @param[out] grad Receives the gradient at @a x (ignored if NULL)
+             */
+            virtual Real evaluate(const Real* x, Real* grad) = 0;
+    };
+
+    /** @brief Minimizer for an @ref ObjectiveFunction
+     * @details Implementations may be supplied by clients to replace the
+     * built-in L-BFGS engine.
+     */
+    class _GraphfabExport Optimizer {
+        public:
+            virtual ~Optimizer() {}
+
+            /** @brief Minimize @a f
+             * @param[in] f The objective
+             * @param[in,out] x Initial guess; overwritten with the minimizer
+             * @return The number of iterations performed
+             */
+            virtual uint64 minimize(ObjectiveFunction& f, Real* x) = 0;
+    };
+
+    /** @brief Limited-memory BFGS with a backtracking (Armijo) line search
+     * @details Scratch storage is retained between calls so that repeated
+     * minimizations of the same dimension do not allocate.
+     */
+    class _GraphfabExport LBFGSOptimizer : public Optimizer {
+        public:
+            /// Keep @a m correction pairs; stop after @a maxit iterations
+            LBFGSOptimizer(uint64 m = 7, uint64 maxit = 500);
+
+            uint64 minimize(ObjectiveFunction& f, Real* x);
+
+            /// Maximum number of iterations
+            void setMaxIterations(uint64 maxit) { maxit_ = maxit; }
+
+            /// Stop when |g| <= gtol*max(1,|x|)
+            void setGradientTolerance(Real gtol) { gtol_ = gtol; }
+
+            /// Stop when the relative decrease in f falls below ftol
+            void setFunctionTolerance(Real ftol) { ftol_ = ftol; }
+
+            /// Limit the displacement of any coordinate in a single step
+            void setMaxStep(Real maxstep) { maxstep_ = maxstep; }
+
+        protected:
+            /// Size of the scratch buffers for dimension @a n
+            void reserve(uint64 n);
+
+            uint64 m_, maxit_;
+            Real gtol_, ftol_, maxstep_;
+
+            /// Correction pairs, stored as m_ rows of length n
+            std::vector<Real> s_, y_;
+            std::vector<Real> rho_, alpha_;
+            /// Current/previous gradient, search direction, previous point
+            std::vector<Real> g_, gp_, d_, xp_;
+    };
+
+}
+
+# endif
+
+#endif
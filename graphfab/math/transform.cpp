@@ -34,6 +34,13 @@
 
 namespace Graphfab {
     
+    // CLASS ViewTransformRef:
+
+    const ViewTransform& ViewTransformRef::identity() {
+        static const ViewTransform id = ViewTransform();
+        return id;
+    }
+
     // CLASS Affine2d:
     
     Affine2d Affine2d::inv() const {
@@ -195,6 +195,41 @@ namespace Graphfab {
             Real _e[9];
     };
     
+    /** @brief Transform from layout to view coordinates, with its inverse
+     *  @details Held once per network and shared by its elements and curves.
+     */
+    struct ViewTransform {
+        /// Layout to view
+        Affine2d tf;
+        /// View to layout
+        Affine2d itf;
+    };
+
+    /** @brief Reference to the view transform of the owning network
+     *  @details Refers to the identity while the holder is not part of a
+     *  network. Not carried over when the holder is copied.
+     */
+    class _GraphfabExport ViewTransformRef {
+        public:
+            ViewTransformRef() : v_(&identity()) {}
+            ViewTransformRef(const ViewTransformRef&) : v_(&identity()) {}
+            ViewTransformRef& operator=(const ViewTransformRef&) { return *this; }
+
+            const Affine2d& tf() const { return v_->tf; }
+            const Affine2d& itf() const { return v_->itf; }
+
+            const ViewTransform* get() const { return v_; }
+
+            /// Refer to @a v (the identity if NULL)
+            void bind(const ViewTransform* v) { v_ = v ? v : &identity(); }
+
+            /// Shared identity transform
+            static const ViewTransform& identity();
+
+        protected:
+            const ViewTransform* v_;
+    };
+
     Point xformPoint(const Point& p, const Affine2d& t);
     Box xformBox(const Box& b, const Affine2d& t);
     
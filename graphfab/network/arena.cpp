@@ -0,0 +1,142 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/arena.h"
+
+#include <new>
+#include <stdlib.h>
+
+namespace Graphfab {
+
+    namespace {
+        /// Blocks and objects are aligned to this many bytes
+        const std::size_t kAlign = 16;
+        /// Space reserved in front of each object (keeps the object aligned)
+        const std::size_t kHeader = 16;
+        /// Minimum slab size
+        const std::size_t kSlabBytes = 64*1024;
+
+        struct BlockHeader {
+            ElementArena* arena;
+            std::size_t cls;
+        };
+
+        inline BlockHeader* headerOf(void* p) {
+            return (BlockHeader*)((char*)p - kHeader);
+        }
+    }
+
+    // CLASS ElementArena:
+
+    ElementArena::ElementArena()
+        : live_(0), detached_(false) {}
+
+    ElementArena::~ElementArena() {
+        for(std::vector<char*>::iterator i=slabs_.begin(); i!=slabs_.end(); ++i)
+            free(*i);
+    }
+
+    void* ElementArena::allocate(std::size_t size) {
+        std::size_t cls = (size + kHeader + kAlign - 1)/kAlign;
+        if(cls >= free_.size()) {
+            free_.resize(cls+1, NULL);
+            cursor_.resize(cls+1);
+        }
+
+        void* b = free_[cls];
+        if(b)
+            free_[cls] = *(void**)b;
+        else
+            b = carve(cls);
+
+        BlockHeader* h = (BlockHeader*)b;
+        h->arena = this;
+        h->cls = cls;
+        ++live_;
+        return (char*)b + kHeader;
+    }
+
+    void* ElementArena::carve(std::size_t cls) {
+        const std::size_t bsize = cls*kAlign;
+        Cursor& c = cursor_[cls];
+        if(c.end - c.cur < (std::ptrdiff_t)bsize) {
+            std::size_t nblocks = kSlabBytes/bsize;
+            if(nblocks < 1)
+                nblocks = 1;
+            char* slab = (char*)malloc(nblocks*bsize);
+            if(!slab)
+                throw std::bad_alloc();
+            slabs_.push_back(slab);
+            c.cur = slab;
+            c.end = slab + nblocks*bsize;
+        }
+        void* b = c.cur;
+        c.cur += bsize;
+        return b;
+    }
+
+    void ElementArena::release(void* b, std::size_t cls) {
+        *(void**)b = free_[cls];
+        free_[cls] = b;
+        --live_;
+        if(detached_ && !live_)
+            delete this;
+    }
+
+    void* ElementArena::allocateHeap(std::size_t size) {
+        BlockHeader* h = (BlockHeader*)::operator new(size + kHeader);
+        h->arena = NULL;
+        h->cls = 0;
+        return (char*)h + kHeader;
+    }
+
+    ElementArena* ElementArena::of(const void* p) {
+        return headerOf((void*)p)->arena;
+    }
+
+    void ElementArena::deallocate(void* p) {
+        if(!p)
+            return;
+        BlockHeader* h = headerOf(p);
+        if(h->arena)
+            h->arena->release(h, h->cls);
+        else
+            ::operator delete(h);
+    }
+
+    void ElementArena::detach() {
+        detached_ = true;
+        if(!live_)
+            delete this;
+    }
+
+}
@@ -0,0 +1,157 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file arena.h
+ * @brief Slab allocation for network elements and curves
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_NETWORK_ARENA_H_
+#define __SBNW_NETWORK_ARENA_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+#include <cstddef>
+
+namespace Graphfab {
+
+    /** @brief Slab allocator owned by a network
+     * @details Blocks are carved from large slabs, with one free list and one
+     * slab cursor per size class, so objects of the same type are laid out
+     * contiguously and freed blocks are reused without touching the heap.
+     * Every block is preceded by a header naming its arena (NULL for blocks
+     * taken from the global heap), which lets a plain @c delete return a block
+     * to wherever it came from. When a whole network goes, its elements are
+     * destroyed in place with @ref dispose and the slabs released in one step
+     * instead of returning every block to a free list. The arena stays alive
+     * after its owner detaches until the last block is returned (e.g. elements
+     * removed from the network and not deleted yet), then releases all slabs.
+     */
+    class _GraphfabExport ElementArena {
+        public:
+            ElementArena();
+
+            /// Allocate @a size bytes from this arena
+            void* allocate(std::size_t size);
+
+            /// Allocate @a size bytes from the global heap (with a NULL arena header)
+            static void* allocateHeap(std::size_t size);
+
+            /// Return a block obtained from @ref allocate or @ref allocateHeap
+            static void deallocate(void* p);
+
+            /// Arena a block came from (NULL for the global heap)
+            static ElementArena* of(const void* p);
+
+            /** @brief Run the destructor of @a x but leave its block to be released with the slabs
+             *  @details Objects from the heap or another arena are deleted as usual.
+             *  The object must start with its @ref ArenaAllocated base.
+             */
+            template <class T>
+            void dispose(T* x) {
+                if(!x)
+                    return;
+                if(of(x) == this) {
+                    x->~T();
+                    --live_;
+                } else
+                    delete x;
+            }
+
+            /// Called by the owner when it goes away; frees the arena once no blocks are live
+            void detach();
+
+            /// Number of blocks currently handed out
+            uint64 getNumLive() const { return live_; }
+
+            /// Number of slabs held
+            uint64 getNumSlabs() const { return slabs_.size(); }
+
+        protected:
+            ~ElementArena();
+
+            void* carve(std::size_t cls);
+
+            void release(void* b, std::size_t cls);
+
+            struct Cursor {
+                Cursor() : cur(NULL), end(NULL) {}
+                char* cur;
+                char* end;
+            };
+
+            /// Free blocks per size class (linked through their first word)
+            std::vector<void*> free_;
+            /// Bump pointers per size class
+            std::vector<Cursor> cursor_;
+            std::vector<char*> slabs_;
+            uint64 live_;
+            bool detached_;
+
+        private:
+            ElementArena(const ElementArena&);
+            ElementArena& operator=(const ElementArena&);
+    };
+
+    /** @brief Base for classes that can be placed in an @ref ElementArena
+     * @details @c new @c (arena) @c T() allocates from @a arena (or the heap if
+     * @a arena is NULL); plain @c new uses the heap. @c delete works for both.
+     */
+    class ArenaAllocated {
+        public:
+            static void* operator new(std::size_t size) {
+                return ElementArena::allocateHeap(size);
+            }
+
+            static void* operator new(std::size_t size, ElementArena* arena) {
+                return arena ? arena->allocate(size) : ElementArena::allocateHeap(size);
+            }
+
+            static void operator delete(void* p) {
+                ElementArena::deallocate(p);
+            }
+
+            /// Called if a constructor throws during arena placement
+            static void operator delete(void* p, ElementArena*) {
+                ElementArena::deallocate(p);
+            }
+    };
+
+}
+
+#endif
+
+#endif
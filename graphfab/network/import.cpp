@@ -0,0 +1,483 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/import.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+namespace Graphfab {
+
+    static void getSegment(const ::LineSegment* line, ImportData::Segment& seg) {
+        if(!line)
+            return;
+        seg.set = true;
+        seg.s = Point(line->getStart()->x(), line->getStart()->y());
+        seg.e = Point(line->getEnd()->x(), line->getEnd()->y());
+        if(const ::CubicBezier* bez = dynamic_cast< ::CubicBezier const* >(line)) {
+            seg.bezier = true;
+            seg.b1 = Point(bez->getBasePoint1()->x(), bez->getBasePoint1()->y());
+            seg.b2 = Point(bez->getBasePoint2()->x(), bez->getBasePoint2()->y());
+        }
+    }
+
+    static void getCurve(const ::Curve* curve, ImportData::Segment& seg) {
+        if(curve && curve->getNumCurveSegments() > 0)
+            getSegment(curve->getCurveSegment(0), seg);
+    }
+
+    void getImportData(const Model& mod, const Layout* lay, ImportData& d) {
+        d.hasid = mod.isSetId();
+        d.id = mod.getId();
+        d.level = mod.getLevel();
+        d.version = mod.getVersion();
+
+        d.comps.resize(mod.getNumCompartments());
+        for(unsigned int i=0; i<mod.getNumCompartments(); ++i) {
+            const ::Compartment* comp = mod.getCompartment(i);
+            d.comps[i].id = comp->getId();
+            d.comps[i].sbo = comp->isSetSBOTerm() ? comp->getSBOTerm() : -1;
+        }
+
+        d.species.resize(mod.getNumSpecies());
+        for(unsigned int i=0; i<mod.getNumSpecies(); ++i) {
+            const Species* s = mod.getSpecies(i);
+            AN(s, "Failed to get species");
+            d.species[i].id = s->getId();
+            d.species[i].name = s->getName();
+            d.species[i].comp = s->getCompartment();
+        }
+
+        d.rxns.resize(mod.getNumReactions());
+        for(unsigned int i=0; i<mod.getNumReactions(); ++i) {
+            const ::Reaction* rxn = mod.getReaction(i);
+            AN(rxn, "Failed to get reaction");
+            ImportData::Rxn& r = d.rxns[i];
+            r.id = rxn->getId();
+            r.comp = rxn->getCompartment();
+            r.refs.resize(rxn->getNumReactants() + rxn->getNumProducts() + rxn->getNumModifiers());
+            std::vector<ImportData::SpecRef>::iterator ref = r.refs.begin();
+            for(unsigned int j=0; j<rxn->getNumReactants(); ++j, ++ref) {
+                ref->species = rxn->getReactant(j)->getSpecies();
+                ref->role = RXN_ROLE_SUBSTRATE;
+            }
+            for(unsigned int j=0; j<rxn->getNumProducts(); ++j, ++ref) {
+                ref->species = rxn->getProduct(j)->getSpecies();
+                ref->role = RXN_ROLE_PRODUCT;
+            }
+            for(unsigned int j=0; j<rxn->getNumModifiers(); ++j, ++ref) {
+                ref->species = rxn->getModifier(j)->getSpecies();
+                ref->role = RXN_ROLE_MODIFIER;
+            }
+        }
+
+        d.haslayout = lay != NULL;
+        if(!lay)
+            return;
+
+        if(const Dimensions* dims = lay->getDimensions()) {
+            d.width = dims->getWidth();
+            d.height = dims->getHeight();
+        }
+
+        d.compglyphs.resize(lay->getNumCompartmentGlyphs());
+        for(unsigned int i=0; i<lay->getNumCompartmentGlyphs(); ++i) {
+            const CompartmentGlyph* cg = lay->getCompartmentGlyph(i);
+            const BoundingBox* bb = cg->getBoundingBox();
+            ImportData::Glyph& g = d.compglyphs[i];
+            g.id = cg->getId();
+            g.target = cg->getCompartmentId();
+            g.x = bb->x();
+            g.y = bb->y();
+            g.w = bb->width();
+            g.h = bb->height();
+        }
+
+        d.specglyphs.resize(lay->getNumSpeciesGlyphs());
+        for(unsigned int i=0; i<lay->getNumSpeciesGlyphs(); ++i) {
+            const SpeciesGlyph* sg = lay->getSpeciesGlyph(i);
+            const BoundingBox* bb = sg->getBoundingBox();
+            ImportData::Glyph& g = d.specglyphs[i];
+            g.id = sg->getId();
+            g.target = sg->getSpeciesId();
+            g.x = bb->x();
+            g.y = bb->y();
+            g.w = bb->width();
+            g.h = bb->height();
+        }
+
+        d.rxnglyphs.resize(lay->getNumReactionGlyphs());
+        for(unsigned int i=0; i<lay->getNumReactionGlyphs(); ++i) {
+            const ReactionGlyph* rg = lay->getReactionGlyph(i);
+            ImportData::RxnGlyph& g = d.rxnglyphs[i];
+            g.id = rg->getId();
+            g.rxn = rg->getReactionId();
+            g.x = g.y = g.w = g.h = 0;
+            if(const BoundingBox* bb = rg->getBoundingBox()) {
+                g.x = bb->getPosition()->x();
+                g.y = bb->getPosition()->y();
+                if(bb->getDimensions()) {
+                    g.w = bb->getDimensions()->getWidth();
+                    g.h = bb->getDimensions()->getHeight();
+                }
+            }
+            getCurve(rg->getCurve(), g.curve);
+
+            g.refs.resize(rg->getNumSpeciesReferenceGlyphs());
+            for(unsigned int j=0; j<rg->getNumSpeciesReferenceGlyphs(); ++j) {
+                const SpeciesReferenceGlyph* srg = rg->getSpeciesReferenceGlyph(j);
+                ImportData::SpecRefGlyph& r = g.refs[j];
+                r.glyph = srg->getSpeciesGlyphId();
+                r.ref = srg->getSpeciesReferenceId();
+                r.role = SBMLRole2GraphfabRole(srg->getRole());
+                getCurve(srg->getCurve(), r.curve);
+            }
+        }
+    }
+
+    /// Control points of a curve from the first segment of a species reference glyph
+    static void setCurveCPs(RxnBezier* c, const ImportData::Segment& seg) {
+        if(!seg.set)
+            return;
+        c->s = seg.s;
+        c->e = seg.e;
+        if(seg.bezier) {
+            c->c1 = seg.b1;
+            c->c2 = seg.b2;
+        } else {
+            c->c1 = seg.s;
+            c->c2 = seg.e;
+            //  CPs should be separated from endpoints for endcap orientation
+            Point ctmp = c->c1;
+            c->c1 = 0.9*c->c1 + 0.1*c->c2;
+            c->c2 = 0.9*c->c2 + 0.1*ctmp;
+        }
+    }
+
+    namespace {
+
+        /// Maps ids to positions in the import data; the first occurrence wins, as in the network's own lookup tables
+        typedef std::unordered_map<std::string, uint64> ImportIdMap;
+
+        const uint64 IMPORT_NONE = (uint64)-1;
+
+        uint64 lookup(const ImportIdMap& m, const std::string& id) {
+            ImportIdMap::const_iterator i = m.find(id);
+            return i != m.end() ? i->second : IMPORT_NONE;
+        }
+
+    }
+
+    Network* networkFromImport(const ImportData& d) {
+        const uint64 ncomp = d.comps.size(), nspec = d.species.size(), nrxn = d.rxns.size();
+
+        // resolve every id once up front; the network is then built with
+        // plain indexing instead of a search per reference and glyph
+
+        // compartments that are drawn
+        ImportIdMap compidx;
+        compidx.reserve(ncomp);
+        for(uint64 k=0; k<ncomp; ++k)
+            if(isVisualCompartment(d.comps[k].id, d.comps[k].sbo))
+                compidx.insert(std::make_pair(d.comps[k].id, k));
+
+        ImportIdMap specidx;
+        specidx.reserve(nspec);
+        for(uint64 k=0; k<nspec; ++k)
+            specidx.insert(std::make_pair(d.species[k].id, k));
+
+        // compartments without species are dropped, so they are never created;
+        // a reaction is placed in its compartment only if that one is kept
+        std::vector<uint64> speccomp(nspec, IMPORT_NONE), rxncomp(nrxn, IMPORT_NONE);
+        std::vector<uint64> compsize(ncomp, 0);
+        for(uint64 k=0; k<nspec; ++k)
+            if((speccomp[k] = lookup(compidx, d.species[k].comp)) != IMPORT_NONE)
+                ++compsize[speccomp[k]];
+        for(uint64 k=0; k<nrxn; ++k) {
+            uint64 c = lookup(compidx, d.rxns[k].comp);
+            if(c != IMPORT_NONE && compsize[c]) {
+                rxncomp[k] = c;
+                ++compsize[c];
+            }
+        }
+        uint64 nkept = 0;
+        for(uint64 k=0; k<ncomp; ++k)
+            if(compsize[k])
+                ++nkept;
+
+        // species of every reference, in reaction order
+        std::vector<uint64> refspec;
+        for(uint64 k=0; k<nrxn; ++k)
+            for(std::vector<ImportData::SpecRef>::const_iterator j=d.rxns[k].refs.begin(); j!=d.rxns[k].refs.end(); ++j) {
+                uint64 s = lookup(specidx, j->species);
+                if(s == IMPORT_NONE)
+                    SBNW_THROW(InvalidParameterException, "Invalid species reference " + j->species, "networkFromImport");
+                refspec.push_back(s);
+            }
+
+        // the first glyph of a species is drawn with the species' node, each further one gets an alias
+        std::vector<uint64> glyphspec(d.specglyphs.size(), IMPORT_NONE);
+        std::vector<uint64> glyphrxn(d.rxnglyphs.size(), IMPORT_NONE);
+        uint64 nnodes = nspec;
+        if(d.haslayout) {
+            std::vector<bool> drawn(nspec, false);
+            std::unordered_set<std::string> glyphids;
+            for(uint64 k=0; k<d.specglyphs.size(); ++k) {
+                uint64 s = lookup(specidx, d.specglyphs[k].target);
+                if(s == IMPORT_NONE)
+                    SBNW_THROW(InvalidParameterException, "No such species " + d.specglyphs[k].target, "networkFromImport");
+                glyphspec[k] = s;
+                if(drawn[s])
+                    ++nnodes;
+                drawn[s] = true;
+                glyphids.insert(d.specglyphs[k].id);
+            }
+            // species without a glyph keep an empty one
+            bool bare = std::find(drawn.begin(), drawn.end(), false) != drawn.end();
+
+            ImportIdMap rxnidx;
+            rxnidx.reserve(nrxn);
+            for(uint64 k=0; k<nrxn; ++k)
+                rxnidx.insert(std::make_pair(d.rxns[k].id, k));
+            for(uint64 k=0; k<d.rxnglyphs.size(); ++k) {
+                const ImportData::RxnGlyph& rg = d.rxnglyphs[k];
+                if((glyphrxn[k] = lookup(rxnidx, rg.rxn)) == IMPORT_NONE)
+                    SBNW_THROW(InvalidParameterException, "No such reaction " + rg.rxn, "networkFromImport");
+                for(std::vector<ImportData::SpecRefGlyph>::const_iterator j=rg.refs.begin(); j!=rg.refs.end(); ++j)
+                    if(!glyphids.count(j->glyph) && !(bare && j->glyph.empty()))
+                        SBNW_THROW(InvalidParameterException, "No such species glyph " + j->glyph, "networkFromImport");
+            }
+        }
+
+        Network* net = new Network();
+
+        if(d.hasid)
+            net->setId(d.id);
+
+        net->reserve(nkept, nnodes, nrxn);
+        
+        // add compartments
+        std::vector<Graphfab::Compartment*> comps(ncomp, (Graphfab::Compartment*)NULL);
+        for(uint64 k=0; k<ncomp; ++k) {
+            if(!compsize[k])
+                continue;
+            Graphfab::Compartment* c = new (net->getArena()) Graphfab::Compartment();
+            
+            // set id
+            c->setId(d.comps[k].id);
+            c->reserveElts(compsize[k]);
+            
+            // add to network
+            net->addCompartment(c);
+            comps[k] = c;
+        }
+        
+        // add nodes
+        std::vector<Node*> nodes(nspec);
+        for(uint64 i=0; i<nspec; ++i) {
+            const ImportData::Spec& s = d.species[i];
+            Node* n = new (net->getArena()) Node();
+            
+            n->setName(s.name);
+            n->setId(s.id);
+            
+            //no alias info
+            n->numUses() = 1;
+            n->setAlias(false);
+            
+            // associate compartment (if one exists)
+            if(speccomp[i] != IMPORT_NONE) {
+                Graphfab::Compartment* c = comps[speccomp[i]];
+                c->addElt(n);
+                n->_comp = c;
+            }
+            
+            // set index
+            n->set_i((size_t)i);
+            
+            // add to network
+            net->addNode(n);
+            nodes[i] = n;
+        }
+        
+        // resize compartments to enclose contents
+        //NOTE: nodes do not yet have positions, can't do this
+        //net->resizeCompartments();
+        net->autosizeComps();
+        
+        // add connections
+        std::vector<Graphfab::Reaction*> rxns(nrxn);
+        std::vector<uint64>::const_iterator ref = refspec.begin();
+        for(uint64 i=0; i<nrxn; ++i) {
+            const ImportData::Rxn& x = d.rxns[i];
+            Graphfab::Reaction* r = new (net->getArena()) Graphfab::Reaction();
+            
+            r->setId(x.id);
+
+            // associate compartment (if one exists)
+            if(rxncomp[i] != IMPORT_NONE)
+                comps[rxncomp[i]]->addElt(r);
+            
+            for(std::vector<ImportData::SpecRef>::const_iterator j=x.refs.begin(); j!=x.refs.end(); ++j, ++ref)
+                r->addSpeciesRef(nodes[*ref], j->role);
+            
+            net->addReaction(r);
+            rxns[i] = r;
+        }
+        
+        #if SAGITTARIUS_DEBUG_LEVEL >= 3
+        net->dump(std::cout, 0);
+        #endif
+
+        if(!d.haslayout)
+            return net;
+        
+        // used to compute aliases
+        net->resetUsageInfo();
+        
+        //add additional information from layout
+        // for compartments
+        for(std::vector<ImportData::Glyph>::const_iterator i=d.compglyphs.begin(); i!=d.compglyphs.end(); ++i) {
+            uint64 k = lookup(compidx, i->target);
+            // not drawn (e.g. the default compartment)
+            if(k == IMPORT_NONE || !comps[k])
+                continue;
+            Graphfab::Compartment* c = comps[k];
+            
+            c->setGlyph(i->id);
+            
+            c->setRestExtents(Box(Point(i->x, i->y), Point(i->x+i->w, i->y+i->h)));
+        }
+
+        // place elements inside parent compartments
+        for(uint64 i=0; i<nspec; ++i)
+            if(speccomp[i] != IMPORT_NONE)
+                nodes[i]->setCentroid(comps[speccomp[i]]->getCentroid());
+        for(uint64 i=0; i<nrxn; ++i)
+            if(rxncomp[i] != IMPORT_NONE)
+                rxns[i]->setCentroid(comps[rxncomp[i]]->getCentroid());
+        
+        // for nodes
+        std::unordered_map<std::string, Node*> glyphs;
+        glyphs.reserve(d.specglyphs.size());
+        for(uint64 k=0; k<d.specglyphs.size(); ++k) {
+            const ImportData::Glyph& g = d.specglyphs[k];
+            Node* n = nodes[glyphspec[k]];
+            
+            //increment usage counter (used to find aliases)
+            if(n->numUses() == 0) {
+                n->numUses()++;
+                n->setGlyph(g.id);
+            } else {
+                //create an alias node
+                n->setAlias(true);
+                n = new (net->getArena()) Node(*n);
+                n->setGlyph(g.id);
+                n->_ldeg = 0;
+                //add alias node to the network
+                net->addNode(n);
+            }
+            // a repeated glyph id is left to the network to resolve
+            if(!glyphs.insert(std::make_pair(g.id, n)).second)
+                glyphs[g.id] = NULL;
+            
+            n->setCentroid(Point(g.x + g.w/2., g.y + g.h/2.));
+            n->setWidth(g.w);
+            n->setHeight(g.h);
+        }
+        
+        // for reactions
+        std::vector<Node*> targets;
+        for(uint64 i=0; i<d.rxnglyphs.size(); ++i) {
+            const ImportData::RxnGlyph& rg = d.rxnglyphs[i];
+            Graphfab::Reaction* r = rxns[glyphrxn[i]];
+            
+            targets.resize(rg.refs.size());
+            for(uint64 j=0; j<rg.refs.size(); ++j) {
+                //get the alias
+                std::unordered_map<std::string, Node*>::const_iterator g = glyphs.find(rg.refs[j].glyph);
+                // nodes without a glyph are only known to the network
+                Node* alias = g != glyphs.end() && g->second ? g->second : net->findNodeByGlyph(rg.refs[j].glyph);
+                AN(alias, "Unable to find alias node");
+                targets[j] = alias;
+
+                //fix the reference to point to the alias
+                r->substituteSpeciesByIdwRole(rg.refs[j].ref, alias, rg.refs[j].role);
+            }
+
+            // delete preexisting curves
+            r->deleteCurves();
+
+            // first try bounding box (the proper method, which none of the models use)
+            if (!(rg.x == 0 && rg.y == 0 && rg.w == 0 && rg.h == 0)) {
+                r->setCentroid(rg.x, rg.y);
+            } else if (rg.curve.set) {
+                // next try using preexisting centroid coords via reaction curve
+                r->setCentroid(rg.curve.e.x, rg.curve.e.y);
+
+                for(uint64 j=0; j<rg.refs.size(); ++j) {
+                    RxnBezier* c = r->addCurve(rg.refs[j].role);
+                    Node* target = targets[j];
+
+                    if (c->getRole() == RXN_CURVE_PRODUCT) {
+                        c->as = &r->_p();
+                        c->ae = &target->_p();
+                        c->ne = target;
+                    } else {
+                        c->as = &target->_p();
+                        c->ns = target;
+                        c->ae = &r->_p();
+                    }
+                    c->owne = 0;
+                    c->owns = 0;
+                }
+
+                r->recalcCurveCPs();
+
+                r->clearDirtyFlag();
+
+                // Try to fill in the CP data from layout info
+                for(uint64 j=0; j<rg.refs.size(); ++j)
+                    setCurveCPs(r->getCurve(j), rg.refs[j].curve);
+            } else {
+                // if all else fails average node coords
+                r->forceRecalcCentroid();
+            }
+        }
+        
+        net->setLayoutSpecified(true);
+        
+        return net;
+    }
+
+}
@@ -0,0 +1,143 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file import.h
+ * @brief Building a network from the contents of a model
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_NETWORK_IMPORT_H_
+#define __SBNW_NETWORK_IMPORT_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/network.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <string>
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief The parts of a model and its layout a network is built from
+     * @details Ids, species references and glyph geometry, copied out of
+     * libSBML objects by @ref getImportData or read straight from SBML text
+     * by @ref readImportData. Everything else in the model (kinetics,
+     * annotations, notes ...) is left out.
+     */
+    struct _GraphfabExport ImportData {
+        struct Comp {
+            std::string id;
+            /// SBO term (-1 if not set)
+            int sbo;
+        };
+
+        struct Spec {
+            std::string id, name, comp;
+        };
+
+        struct SpecRef {
+            std::string species;
+            RxnRoleType role;
+        };
+
+        struct Rxn {
+            std::string id, comp;
+            /// Reactants, then products, then modifiers
+            std::vector<SpecRef> refs;
+        };
+
+        /// First segment of a layout curve
+        struct Segment {
+            Segment() : set(false), bezier(false) {}
+
+            bool set, bezier;
+            Point s, e, b1, b2;
+        };
+
+        /// A compartment or species glyph
+        struct Glyph {
+            /// @a target is the id of the compartment or species
+            std::string id, target;
+            /// Bounding box
+            Real x, y, w, h;
+        };
+
+        struct SpecRefGlyph {
+            std::string glyph, ref;
+            RxnRoleType role;
+            Segment curve;
+        };
+
+        struct RxnGlyph {
+            std::string id, rxn;
+            Real x, y, w, h;
+            Segment curve;
+            std::vector<SpecRefGlyph> refs;
+        };
+
+        ImportData() : hasid(false), level(3), version(1), haslayout(false), width(1024), height(1024) {}
+
+        bool hasid;
+        std::string id;
+        uint64 level, version;
+
+        std::vector<Comp> comps;
+        std::vector<Spec> species;
+        std::vector<Rxn> rxns;
+
+        /// True if the model has a layout (only the first is used)
+        bool haslayout;
+        Real width, height;
+        std::vector<Glyph> compglyphs, specglyphs;
+        std::vector<RxnGlyph> rxnglyphs;
+    };
+
+    /** @brief Copy what a network is built from out of a libSBML model
+     * @param[in] lay The layout to use (may be NULL)
+     */
+    _GraphfabExport void getImportData(const Model& mod, const Layout* lay, ImportData& d);
+
+    /** @brief Construct a network from imported model contents
+     * @details Same as @ref networkFromLayout (or @ref networkFromModel
+     * when @a d has no layout) on the model @a d was taken from.
+     * @throws InvalidParameterException if a species reference or glyph
+     * names a species, reaction or species glyph that does not exist
+     */
+    _GraphfabExport Network* networkFromImport(const ImportData& d);
+
+}
+
+#endif
+
+#endif
@@ -32,6 +32,7 @@
 #include "graphfab/core/SagittariusCore.h"
 #include "graphfab/diag/error.h"
 #include "graphfab/network/network.h"
+#include "graphfab/network/import.h"
 #include "graphfab/io/io.h"
 #include "graphfab/math/rand_unif.h"
 #include "graphfab/math/dist.h"
@@ -40,6 +41,9 @@
 #include "graphfab/math/geom.h"
 
 #include <exception>
+#include <mutex>
+#include <new>
+#include <algorithm>
 #include <typeinfo>
 #include <math.h>
 #include <stdlib.h> //rand
@@ -151,53 +155,423 @@ namespace Graphfab {
       return ArrowheadStyleLookup(this);
     }
     
+    //--CLASS Symbol--
+
+    const std::string& Symbol::none() {
+        static const std::string empty;
+        return empty;
+    }
+
+    void Symbol::release() {
+        if(!t_ && s_ != &none())
+            delete s_;
+        s_ = &none();
+    }
+
+    void Symbol::assign(const std::string& v) {
+        if(t_) {
+            s_ = t_->intern(v);
+            return;
+        }
+        // v may refer to the current value
+        const std::string* x = v.empty() ? &none() : new std::string(v);
+        release();
+        s_ = x;
+    }
+
+    void Symbol::bind(SymbolTable* t) {
+        if(t == t_)
+            return;
+        const std::string* x = t ? t->intern(*s_) : (s_->empty() ? &none() : new std::string(*s_));
+        release();
+        s_ = x;
+        t_ = t;
+    }
+
+    void Symbol::find(SymbolTable* t, const std::string& v) {
+        const std::string* x = t ? t->find(v) : NULL;
+        if(x) {
+            release();
+            s_ = x;
+            t_ = t;
+        } else {
+            bind(NULL);
+            assign(v);
+        }
+    }
+
+    //--CLASS ElementGeometry--
+
+    ElementGeometry::ElementGeometry()
+        : store_(&GeometryStore::detached()), slot_(store_->acquire()) {
+        p() = Point(0,0);
+        v() = Point(0,0);
+        ext() = Box();
+        r() = 0;
+        lock() = 0;
+    }
+
+    ElementGeometry::ElementGeometry(const ElementGeometry& other)
+        : store_(&GeometryStore::detached()), slot_(store_->acquire()) {
+        p() = other.p();
+        v() = other.v();
+        ext() = other.ext();
+        r() = other.r();
+        lock() = other.lock();
+    }
+
+    ElementGeometry& ElementGeometry::operator=(const ElementGeometry& other) {
+        if(this != &other) {
+            p() = other.p();
+            v() = other.v();
+            ext() = other.ext();
+            r() = other.r();
+            lock() = other.lock();
+        }
+        return *this;
+    }
+
+    ElementGeometry::~ElementGeometry() {
+        store_->release(slot_);
+    }
+
+    //--CLASS GeometryStore--
+
+    namespace {
+        /// Most elements that can be outside a network at once
+        const uint64 kMaxDetached = (uint64)1 << 22;
+
+        std::mutex& detachedLock() {
+            static std::mutex m;
+            return m;
+        }
+    }
+
+    GeometryStore::GeometryStore(uint64 max)
+        : size_(0), max_(max) {
+        p_.reserveTable(max);
+        v_.reserveTable(max);
+        ext_.reserveTable(max);
+        r_.reserveTable(max);
+        lock_.reserveTable(max);
+        type_.reserveTable(max);
+        elt_.reserveTable(max);
+    }
+
+    GeometryStore& GeometryStore::detached() {
+        // never destroyed: elements may go away during static destruction
+        static GeometryStore* s = new GeometryStore(kMaxDetached);
+        return *s;
+    }
+
+    uint64 GeometryStore::acquire() {
+        std::unique_lock<std::mutex> g(detachedLock(), std::defer_lock);
+        if(max_)
+            g.lock();
+        if(!free_.empty()) {
+            uint64 k = free_.back();
+            free_.pop_back();
+            return k;
+        }
+        if(max_ && size_ == max_)
+            throw std::bad_alloc();
+        uint64 k = size_++;
+        p_.reserve(size_);
+        v_.reserve(size_);
+        ext_.reserve(size_);
+        r_.reserve(size_);
+        lock_.reserve(size_);
+        type_.reserve(size_);
+        elt_.reserve(size_);
+        elt_[k] = NULL;
+        return k;
+    }
+
+    void GeometryStore::release(uint64 k) {
+        std::unique_lock<std::mutex> g(detachedLock(), std::defer_lock);
+        if(max_)
+            g.lock();
+        elt_[k] = NULL;
+        free_.push_back(k);
+    }
+
+    void GeometryStore::reserve(uint64 n) {
+        p_.reserve(n);
+        v_.reserve(n);
+        ext_.reserve(n);
+        r_.reserve(n);
+        lock_.reserve(n);
+        type_.reserve(n);
+        elt_.reserve(n);
+    }
+
+    void GeometryStore::attach(NetworkElement* e, ElementGeometry& g, NetworkEltType type) {
+        AT(g.store_ == &detached(), "Element geometry already attached");
+        uint64 k = acquire();
+        p_[k] = g.p();
+        v_[k] = g.v();
+        ext_[k] = g.ext();
+        r_[k] = g.r();
+        lock_[k] = g.lock();
+        type_[k] = type;
+        elt_[k] = e;
+
+        g.store_->release(g.slot_);
+        g.store_ = this;
+        g.slot_ = k;
+    }
+
+    void GeometryStore::detach(ElementGeometry& g) {
+        AT(g.store_ == this, "Element geometry not in this store");
+        uint64 k = g.slot_;
+        GeometryStore& d = detached();
+        uint64 j = d.acquire();
+        d.p_[j] = p_[k];
+        d.v_[j] = v_[k];
+        d.ext_[j] = ext_[k];
+        d.r_[j] = r_[k];
+        d.lock_[j] = lock_[k];
+
+        g.store_ = &d;
+        g.slot_ = j;
+        release(k);
+    }
+
+    uint64 GeometryStore::numChunks() const {
+        return (size_ + GeometryColumn<Point>::CHUNK - 1) >> GeometryColumn<Point>::CHUNK_BITS;
+    }
+
+    uint64 GeometryStore::chunkSize(uint64 c) const {
+        uint64 base = c << GeometryColumn<Point>::CHUNK_BITS;
+        return size_ - base < (uint64)GeometryColumn<Point>::CHUNK ? size_ - base : (uint64)GeometryColumn<Point>::CHUNK;
+    }
+
+    void GeometryStore::resetVelocities() {
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            Point* v = v_.chunk(c);
+            for(uint64 j=0; j<n; ++j)
+                if(elt[j] && type[j] != NET_ELT_TYPE_COMP)
+                    v[j] = Point(0.,0.);
+        }
+    }
+
+    void GeometryStore::capVelocities(Real cap2) {
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            Point* v = v_.chunk(c);
+            for(uint64 j=0; j<n; ++j)
+                if(elt[j] && type[j] != NET_ELT_TYPE_COMP)
+                    v[j].capMag2_(cap2);
+        }
+    }
+
+    void GeometryStore::advance(Real scale) {
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            Point* p = p_.chunk(c);
+            const Point* v = v_.chunk(c);
+            const int* lock = lock_.chunk(c);
+            for(uint64 j=0; j<n; ++j)
+                if(elt[j] && type[j] != NET_ELT_TYPE_COMP && !lock[j])
+                    advanceElement(p[j], v[j], scale);
+        }
+    }
+
+    void GeometryStore::recalcExtents() {
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            Point* p = p_.chunk(c);
+            Box* ext = ext_.chunk(c);
+            Real* r = r_.chunk(c);
+            for(uint64 j=0; j<n; ++j) {
+                if(!elt[j])
+                    continue;
+                switch(type[j]) {
+                    case NET_ELT_TYPE_SPEC:
+                        recalcSpeciesExtents(p[j], ext[j], r[j]);
+                        break;
+                    case NET_ELT_TYPE_RXN:
+                        recalcReactionExtents(p[j], ext[j], r[j]);
+                        break;
+                    case NET_ELT_TYPE_COMP:
+                        recalcCompartmentExtents(p[j], ext[j], r[j]);
+                        break;
+                }
+            }
+        }
+    }
+
+    bool GeometryStore::boundingBox(Box& b) const {
+        bool found = false;
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            const Point* p = p_.chunk(c);
+            const Box* ext = ext_.chunk(c);
+            for(uint64 j=0; j<n; ++j) {
+                if(!elt[j])
+                    continue;
+                Box e = type[j] == NET_ELT_TYPE_RXN ? reactionLocalExtents(p[j]) : ext[j];
+                if(found)
+                    b.expandx(e);
+                else {
+                    b = e;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    uint64 GeometryStore::sumCentroids(Point& s) const {
+        uint64 count = 0;
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            const Point* p = p_.chunk(c);
+            const Box* ext = ext_.chunk(c);
+            for(uint64 j=0; j<n; ++j) {
+                if(!elt[j])
+                    continue;
+                s = s + (type[j] == NET_ELT_TYPE_COMP ? ext[j].getCenter() : p[j]);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    Point GeometryStore::sumSquaredDeviations(const Point& m) const {
+        Point d(0.,0.);
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const uint64 n = chunkSize(c);
+            NetworkElement* const* elt = elt_.chunk(c);
+            const NetworkEltType* type = type_.chunk(c);
+            const Point* p = p_.chunk(c);
+            const Box* ext = ext_.chunk(c);
+            for(uint64 j=0; j<n; ++j) {
+                if(!elt[j])
+                    continue;
+                d = d + Point((type[j] == NET_ELT_TYPE_COMP ? ext[j].getCenter() : p[j]) - m).squareTerms();
+            }
+        }
+        return d;
+    }
+
+    bool GeometryStore::findSlot(const NetworkElement* e, uint64& k) const {
+        if(!e || e->geo_.store_ != this)
+            return false;
+        k = e->geo_.slot_;
+        return true;
+    }
+
+    bool GeometryStore::findCentroidSlot(const Point* p, uint64& k) const {
+        for(uint64 c=0; c<numChunks(); ++c) {
+            const Point* base = p_.chunk(c);
+            if(p >= base && p < base + chunkSize(c)) {
+                k = (c << GeometryColumn<Point>::CHUNK_BITS) + (uint64)(p - base);
+                return elt_[k] != NULL;
+            }
+        }
+        return false;
+    }
+
+    //--CLASS ElementRemap--
+
+    void ElementRemap::set(const NetworkElement* e, NetworkElement* copy) {
+        uint64 k;
+        if(!from_.findSlot(e, k))
+            SBNW_THROW(InvalidParameterException, "Element does not belong to the network", "ElementRemap::set");
+        to_[k] = copy;
+    }
+
+    NetworkElement* ElementRemap::operator()(const NetworkElement* e) const {
+        if(!e)
+            return NULL;
+        uint64 k;
+        if(!from_.findSlot(e, k) || !to_[k])
+            SBNW_THROW(InvalidParameterException, "Element does not belong to the network", "ElementRemap::operator()");
+        return to_[k];
+    }
+
+    Point* ElementRemap::centroid(const Point* p) const {
+        uint64 k;
+        if(!p || !from_.findCentroidSlot(p, k) || !to_[k])
+            return NULL;
+        return &to_[k]->_p();
+    }
+
+    
     //--CLASS NetworkElement--
     
     void NetworkElement::resetActivity() {
-        _v = Point(0.,0.);
+        _v() = Point(0.,0.);
     }
     
     void NetworkElement::doMotion(const Real scale) {
-        if(_lock)
+        if(_lock())
             return;
         AT(_type != NET_ELT_TYPE_COMP);
-//         _p = _p + _v*scale;
-        if (_v.mag2() > 1e-6)
-          _p = _p + _v.normed()*scale;
+//         _p() = _p() + _v()*scale;
+        GeometryStore::advanceElement(_p(), _v(), scale);
     }
     
     void NetworkElement::addDelta(const Point& d) {
-        _v = _v + d;
+        _v() = _v() + d;
     }
     
     void NetworkElement::capDelta(const Real cap) {
-        _v = _v.capMag(cap);
+        _v() = _v().capMag(cap);
     }
     
     void NetworkElement::capDelta2(const Real cap2) {
-        _v.capMag2_(cap2);
+        _v().capMag2_(cap2);
     }
     
     void NetworkElement::setCentroid(const Point& p) {
-        _p = p;
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        _p() = p;
         _pset = 1;
         recalcExtents();
     }
     
     void NetworkElement::setGlobalCentroid(const Point& p) {
-        _p = itf_*p;
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        _p() = view_.itf()*p;
         _pset = 1;
         recalcExtents();
     }
+
+    void NetworkElement::setExtents(const Box& b) {
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        _ext() = b;
+        recalcCentroid();
+    }
+
+    EditJournal* NetworkElement::getRecordingJournal() const {
+        if(owner_.net && owner_.net->getJournal().isRecording())
+            return &owner_.net->getJournal();
+        return NULL;
+    }
     
     Point NetworkElement::getCentroid(COORD_SYSTEM coord) const {
       if (coord == COORD_SYSTEM_LOCAL)
-        return _p;
+        return _p();
       else if (coord == COORD_SYSTEM_GLOBAL)
-        return tf_*_p;
+        return view_.tf()*_p();
       else {
         AN(0, "Unknown coord system");
-        return _p;
+        return _p();
       }
     }
     
@@ -266,40 +640,64 @@ namespace Graphfab {
     }
 	
 	const std::string& Node::getName() const {
-        return _name;
+        return _name.str();
     }
     
     const std::string& Node::getId() const {
-        return _id;
+        return _id.str();
     }
     
     void Node::setId(const std::string& id) {
-        _id = id;
+        if(owner_.net) {
+            std::string before(_id.str());
+            _id = id;
+            owner_.net->eltIdChanged(this, before);
+        } else
+            _id = id;
+    }
+    
+    void Node::set_i(size_t i) {
+        if(owner_.net) {
+            std::size_t before = i_;
+            i_ = i;
+            owner_.net->nodeIndexChanged(before, i_);
+        } else
+            i_ = i;
     }
     
     const std::string& Node::getGlyph() const {
-        return _gly;
+        return _gly.str();
     }
     
     void Node::setGlyph(const std::string& id) {
-        _gly = id;
+        if(owner_.net) {
+            std::string before(_gly.str());
+            _gly = id;
+            owner_.net->eltGlyphChanged(this, before);
+        } else
+            _gly = id;
     }
 
     int Node::alias(Network* net) {
         if(!net->containsNode(this))
           SBNW_THROW(InvalidParameterException, "No such node in network", "Network::alias");
 
-        net->clearExcludeFromSubgraphEnum();
-        int nsub_before = net->getNumSubgraphs();
-
-        net->clearExcludeFromSubgraphEnum();
-        setExcludeFromSubgraphEnum();
-        int nsub_after = net->getNumSubgraphs();
-
-        if (nsub_before !=  nsub_after)
+        // aliasing must not split the network
+        const NetworkIncidence& inc = net->getIncidence();
+        uint64 k = 0;
+        inc.findNode(this, k);
+        std::vector<char> exclude(inc.getNumNodes(), 0);
+        exclude[k] = 1;
+        std::vector<int> label;
+        std::vector<uint64> size;
+        if (inc.labelSubgraphs(label, size, &exclude) != net->getNumConnectedSubgraphs())
           return 1;
 
-        for (Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+        // one step in the undo history
+        EditJournal::GroupScope edit(net->getJournal());
+
+        Network::AttachedRxnList rxns = net->getConnectedReactions(this);
+        for (Network::AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
           Reaction* r = *i;
           int k = 0;
 
@@ -313,7 +711,7 @@ namespace Graphfab {
             if (c->ns != this && c->ne != this)
               continue;
 
-            Node* n = new Node();
+            Node* n = new (net->getArena()) Node();
 
             n->setName(getName());
 
@@ -334,8 +732,6 @@ namespace Graphfab {
             n->set_i(net->getUniqueIndex());
 
             n->setCentroid(new2ndPos(c->getCentroidCP(), getCentroid(), 0., -50., false));
-            n->setTransform(tf_,  false);
-            n->setInverseTransform(itf_,  false);
 
             net->addNode(n);
 
@@ -358,45 +754,60 @@ namespace Graphfab {
           SBNW_THROW(InternalCheckFailureException, "Could not remove original node", "Network::alias");
         }
 
+        // the journal keeps the original if the aliasing can be undone
+        if(!net->getJournal().holds(this))
+          delete this;
+
         return 0;
     }
 
+    void Node::setAlias(bool b) {
+        if(b != _isAlias)
+            if(EditJournal* j = getRecordingJournal())
+                j->recordAlias(this, _isAlias);
+        _isAlias = b;
+    }
+
     bool Node::isCommonInstance(const Node* other) const {
-        return getId() == other->getId();
+        return _id == other->_id;
     }
     
     Point Node::getUpperLeftCorner() const {
-        return _p - Point(40,20);
+        return _p() - Point(40,20);
     }
     
     Point Node::getLowerRightCorner() const {
-        return _p + Point(40,20);
+        return _p() + Point(40,20);
     }
     
     void Node::setWidth(Real w) {
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
         Point d(w/2., getHeight()/2.);
-        _ext.setMin(getCentroid() - d);
-        _ext.setMax(getCentroid() + d);
+        _ext().setMin(getCentroid() - d);
+        _ext().setMax(getCentroid() + d);
     }
     
     void Node::setHeight(Real h) {
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
         Point d(getWidth()/2., h/2.);
-        _ext.setMin(getCentroid() - d);
-        _ext.setMax(getCentroid() + d);
+        _ext().setMin(getCentroid() - d);
+        _ext().setMax(getCentroid() + d);
     }
     
     void Node::affectGlobalWidth(Real ww) {
-        Real w = ww/tf_.scaleFactor();
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        Real w = ww/view_.tf().scaleFactor();
         Point d(w/2., getHeight()/2.);
-        _ext.setMin(getCentroid() - d);
-        _ext.setMax(getCentroid() + d);
+        _ext().setMin(getCentroid() - d);
+        _ext().setMax(getCentroid() + d);
     }
     
     void Node::affectGlobalHeight(Real hh) {
-        Real h = hh/tf_.scaleFactor();
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        Real h = hh/view_.tf().scaleFactor();
         Point d(getWidth()/2., h/2.);
-        _ext.setMin(getCentroid() - d);
-        _ext.setMax(getCentroid() + d);
+        _ext().setMin(getCentroid() - d);
+        _ext().setMax(getCentroid() + d);
     }
     
     void Node::dump(std::ostream& os, uint32 ind) {
@@ -424,7 +835,7 @@ namespace Graphfab {
     
     void Node::dumpForces(std::ostream& os, uint32 ind) const {
         indent(os, ind);
-        os << "Node forces: " << _v << "\n";
+        os << "Node forces: " << _v() << "\n";
     }
     
     std::string rxnRoleToString(RxnRoleType role) {
@@ -465,33 +876,227 @@ namespace Graphfab {
 
     // -- CLASS RxnCurveFactory
 
-    RxnBezier* RxnCurveFactory::CreateCurve(RxnRoleType role) {
+    RxnBezier* RxnCurveFactory::CreateCurve(RxnRoleType role, ElementArena* arena) {
         switch(role) {
             case RXN_ROLE_SUBSTRATE:
             case RXN_ROLE_SIDESUBSTRATE:
-                return new SubCurve();
+                return new (arena) SubCurve();
             case RXN_ROLE_PRODUCT:
             case RXN_ROLE_SIDEPRODUCT:
-                return new PrdCurve();
+                return new (arena) PrdCurve();
             case RXN_ROLE_MODIFIER:
-                return new ModCurve();
+                return new (arena) ModCurve();
             case RXN_ROLE_ACTIVATOR:
-                return new ActCurve();
+                return new (arena) ActCurve();
             case RXN_ROLE_INHIBITOR:
-                return new InhCurve();
+                return new (arena) InhCurve();
             default:
                 AN(0, "Unrecognized species type");
         }
     }
     
+    RxnCurveType RxnCurveFactory::CurveType(RxnRoleType role) {
+        switch(role) {
+            case RXN_ROLE_SUBSTRATE:
+            case RXN_ROLE_SIDESUBSTRATE:
+                return RXN_CURVE_SUBSTRATE;
+            case RXN_ROLE_PRODUCT:
+            case RXN_ROLE_SIDEPRODUCT:
+                return RXN_CURVE_PRODUCT;
+            case RXN_ROLE_MODIFIER:
+                return RXN_CURVE_MODIFIER;
+            case RXN_ROLE_ACTIVATOR:
+                return RXN_CURVE_ACTIVATOR;
+            case RXN_ROLE_INHIBITOR:
+                return RXN_CURVE_INHIBITOR;
+            default:
+                SBNW_THROW(InvalidParameterException, "Unrecognized species type", "RxnCurveFactory::CurveType");
+        }
+    }
+
+    RxnBezier* RxnCurveFactory::CloneCurve(const RxnBezier* c, ElementArena* arena) {
+        AN(c, "No curve");
+        switch(c->getRole()) {
+            case RXN_CURVE_SUBSTRATE:
+                return new (arena) SubCurve(*static_cast<const SubCurve*>(c));
+            case RXN_CURVE_PRODUCT:
+                return new (arena) PrdCurve(*static_cast<const PrdCurve*>(c));
+            case RXN_CURVE_MODIFIER:
+                return new (arena) ModCurve(*static_cast<const ModCurve*>(c));
+            case RXN_CURVE_ACTIVATOR:
+                return new (arena) ActCurve(*static_cast<const ActCurve*>(c));
+            case RXN_CURVE_INHIBITOR:
+                return new (arena) InhCurve(*static_cast<const InhCurve*>(c));
+            default:
+                SBNW_THROW(InvalidParameterException, "Unrecognized curve type", "RxnCurveFactory::CloneCurve");
+        }
+    }
+    
+    //--CLASS NodeIncidence--
+
+    void NodeIncidence::detach(Reaction* r, RxnRoleType role) {
+        for(EntryVec::iterator i=entries.begin(); i!=entries.end(); ++i) {
+            if(i->first == r && i->second == role) {
+                entries.erase(i);
+                return;
+            }
+        }
+    }
+
+    void NodeIncidence::detachAll(Reaction* r) {
+        EntryVec::iterator w = entries.begin();
+        for(EntryVec::iterator i=entries.begin(); i!=entries.end(); ++i)
+            if(i->first != r)
+                *w++ = *i;
+        entries.erase(w, entries.end());
+    }
+
+    //--CLASS AliasGroupIndex--
+
+    void AliasGroupIndex::add(Node* n) {
+        std::pair<SlotMap::iterator, bool> r = slot_.insert(std::make_pair(n->getId(), (uint64)groups_.size()));
+        if(r.second)
+            groups_.push_back(Instances());
+        groups_[r.first->second].push_back(n);
+    }
+
+    void AliasGroupIndex::remove(Node* n, const std::string& id) {
+        SlotMap::iterator i = slot_.find(id);
+        if(i == slot_.end())
+            return;
+        uint64 k = i->second;
+        Instances& g = groups_[k];
+        Instances::iterator j = std::find(g.begin(), g.end(), n);
+        if(j == g.end())
+            return;
+        g.erase(j);
+        if(!g.empty())
+            return;
+        // move the last group into the freed slot
+        slot_.erase(i);
+        if(k+1 != groups_.size()) {
+            groups_[k].swap(groups_.back());
+            slot_[groups_[k].front()->getId()] = k;
+        }
+        groups_.pop_back();
+    }
+
+    const AliasGroupIndex::Instances* AliasGroupIndex::find(const std::string& id) const {
+        SlotMap::const_iterator i = slot_.find(id);
+        return i != slot_.end() ? &groups_[i->second] : NULL;
+    }
+
+    //--CLASS NetworkIncidence--
+
+    void NetworkIncidence::build(const Network& net) {
+        const uint64 nnodes = net.getTotalNumNodes();
+        const uint64 nrxns = net.getTotalNumRxns();
+
+        nodepos_.clear();
+        uint64 k = 0;
+        for(Network::ConstNodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i, ++k)
+            nodepos_.insert(std::make_pair(*i, k));
+
+        rxnoff_.assign(1, 0);
+        rxnnode_.clear();
+        rxnrole_.clear();
+        nodeoff_.assign(nnodes+1, 0);
+        for(Network::ConstRxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+            for(Reaction::ConstNodeIt j=(*i)->NodesBegin(); j!=(*i)->NodesEnd(); ++j) {
+                std::unordered_map<const Node*, uint64>::const_iterator p = nodepos_.find(j->first);
+                if(p == nodepos_.end())
+                    continue;
+                rxnnode_.push_back(p->second);
+                rxnrole_.push_back(j->second);
+                ++nodeoff_[p->second+1];
+            }
+            rxnoff_.push_back(rxnnode_.size());
+        }
+
+        // transpose; scanning reactions in order keeps each node's entries in network order
+        for(k=0; k<nnodes; ++k)
+            nodeoff_[k+1] += nodeoff_[k];
+        noderxn_.resize(rxnnode_.size());
+        noderole_.resize(rxnnode_.size());
+        std::vector<uint64> fill(nodeoff_.begin(), nodeoff_.end()-1);
+        for(uint64 j=0; j<nrxns; ++j) {
+            for(uint64 p=rxnoff_[j]; p<rxnoff_[j+1]; ++p) {
+                uint64 q = fill[rxnnode_[p]]++;
+                noderxn_[q] = j;
+                noderole_[q] = rxnrole_[p];
+            }
+        }
+    }
+
+    bool NetworkIncidence::findNode(const Node* n, uint64& k) const {
+        std::unordered_map<const Node*, uint64>::const_iterator p = nodepos_.find(n);
+        if(p == nodepos_.end())
+            return false;
+        k = p->second;
+        return true;
+    }
+
+    int NetworkIncidence::labelSubgraphs(std::vector<int>& label, std::vector<uint64>& size, const std::vector<char>* exclude) const {
+        const uint64 n = getNumNodes();
+        DisjointSets sets;
+        sets.reset(n);
+        for(uint64 j=0; j<getNumRxns(); ++j) {
+            uint64 first = n;
+            for(uint64 p=rxnBegin(j); p<rxnEnd(j); ++p) {
+                uint64 k = rxnNode(p);
+                if(exclude && (*exclude)[k])
+                    continue;
+                if(first == n)
+                    first = k;
+                else
+                    sets.unite(first, k);
+            }
+        }
+
+        // number in order of first appearance
+        label.assign(n, -1);
+        size.clear();
+        std::vector<int> root(n, -1);
+        for(uint64 k=0; k<n; ++k) {
+            if(exclude && (*exclude)[k])
+                continue;
+            uint64 r = sets.find(k);
+            if(root[r] < 0) {
+                root[r] = (int)size.size();
+                size.push_back(0);
+            }
+            label[k] = root[r];
+            ++size[root[r]];
+        }
+        return (int)size.size();
+    }
+    
     //--CLASS Reaction--
     
     void Reaction::hierarchRelease() {
         deleteCurves();
     }
     
+    void Reaction::setId(const std::string& id) {
+        if(owner_.net) {
+            std::string before(_id.str());
+            _id = id;
+            owner_.net->eltIdChanged(this, before);
+        } else
+            _id = id;
+    }
+    
     void Reaction::addSpeciesRef(Node* n, RxnRoleType role) {
-        _spec.push_back(std::make_pair(n, role));
+        insertSpeciesRef(_spec.size(), n, role);
+    }
+
+    void Reaction::insertSpeciesRef(uint64 k, Node* n, RxnRoleType role) {
+        AT(k <= _spec.size(), "Species reference out of range");
+        _spec.insert(_spec.begin() + k, std::make_pair(n, role));
+        if(owner_.net) {
+            n->inc_.attach(this, role);
+            owner_.net->structureChanged();
+        }
         // recompute curves
         _cdirty = 1;
         // increase degree
@@ -499,6 +1104,24 @@ namespace Graphfab {
         ++_ldeg;
         ++n->_deg;
         ++n->_ldeg;
+        if(EditJournal* j = getRecordingJournal())
+            j->recordConnect(this, k);
+    }
+
+    void Reaction::removeSpeciesRef(uint64 k) {
+        AT(k < _spec.size(), "Species reference out of range");
+        Node* n = _spec[k].first;
+        RxnRoleType role = _spec[k].second;
+        _spec.erase(_spec.begin() + k);
+        if(owner_.net) {
+            n->inc_.detach(this, role);
+            owner_.net->structureChanged();
+        }
+        _cdirty = 1;
+        --_deg;
+        --_ldeg;
+        --n->_deg;
+        --n->_ldeg;
     }
     
     void Reaction::removeNode(Node* n) {
@@ -508,7 +1131,6 @@ namespace Graphfab {
             Node* x = i->first;
             if(x == n) {
                 rebuild = true;
-                std::cout << "Rxn: element erased\n";
                 --_deg;
                 --_ldeg;
                 --n->_deg;
@@ -517,14 +1139,20 @@ namespace Graphfab {
                 goto repeat; // in case the species shows up multiple times
             }
         }
+        if(rebuild && owner_.net) {
+            n->inc_.detachAll(this);
+            owner_.net->structureChanged();
+        }
         if(rebuild)
             rebuildCurves();
     }
     
     Node* Reaction::findSpeciesById(const std::string& id) {
+        Symbol key;
+        key.find(_id.getTable(), id);
         for(NodeVec::iterator i=_spec.begin(); i!=_spec.end(); ++i) {
             Node* n = i->first;
-            if(n->getId() == id)
+            if(n->_id == key)
                 return n;
         }
         //not found
@@ -552,28 +1180,45 @@ namespace Graphfab {
     }
     
     void Reaction::substituteSpeciesById(const std::string& id, Node* spec) {
+        Symbol key;
+        key.find(_id.getTable(), id);
         for(NodeVec::iterator i=_spec.begin(); i!=_spec.end(); ++i) {
             Node* n = i->first;
-            if(n->getId() == id) {
+            if(n->_id == key) {
                 --n->_ldeg;
                 ++spec->_ldeg;
                 i->first = spec;
+                if(owner_.net) {
+                    n->inc_.detach(this, i->second);
+                    spec->inc_.attach(this, i->second);
+                    owner_.net->structureChanged();
+                }
+                _cdirty = 1;
             }
         }
     }
 
     void Reaction::substituteSpeciesByIdwRole(const std::string& id, Node* spec, RxnRoleType role) {
+        Symbol key;
+        key.find(_id.getTable(), id);
         for(NodeVec::iterator i=_spec.begin(); i!=_spec.end(); ++i) {
             Node* n = i->first;
-            if(n->getId() == id && matchSBML_RoleGenericMod(i->second, role)) {
+            if(n->_id == key && matchSBML_RoleGenericMod(i->second, role)) {
                 --n->_ldeg;
                 ++spec->_ldeg;
                 i->first = spec;
+                if(owner_.net)
+                    n->inc_.detach(this, i->second);
                 // SBML inconsistency
                 if ((i->second == RXN_ROLE_MODIFIER) && (role == RXN_ROLE_ACTIVATOR || role == RXN_ROLE_INHIBITOR) ) {
 //                   std::cerr << "Set role for " << spec->getId() << " to " << rxnRoleToString(role) << "\n";
                   i->second = role;
                 }
+                if(owner_.net) {
+                    spec->inc_.attach(this, i->second);
+                    owner_.net->structureChanged();
+                }
+                _cdirty = 1;
             }
         }
     }
@@ -595,6 +1240,12 @@ namespace Graphfab {
                 --n->_ldeg;
                 ++after->_ldeg;
                 i->first = after;
+                if(owner_.net) {
+                    before->inc_.detach(this, i->second);
+                    after->inc_.attach(this, i->second);
+                    owner_.net->structureChanged();
+                }
+                _cdirty = 1;
             }
         }
     }
@@ -607,84 +1258,140 @@ namespace Graphfab {
 #define REBUILD_CURVES_DIAG 0
     
     void Reaction::rebuildCurves() {
-        deleteCurves();
+        syncCurves();
+        recalcCurveCPs();
+    }
+
+    void Reaction::syncCurves() {
+        ElementArena* arena = owner_.net ? owner_.net->getArena() : NULL;
 
 # if REBUILD_CURVES_DIAG
         std::cerr << "Rebuild curves\n";
 # endif
         
-        for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i) {
+        uint64 k=0;
+        for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i, ++k) {
             Node* n = i->first;
             RxnRoleType r = i->second;
-            // the curve
-            RxnBezier* curv = NULL;
 # if REBUILD_CURVES_DIAG
             std::cerr << "  Role: " << rxnRoleToString(r) << "\n";
 # endif
-            switch(r) {
-                case RXN_ROLE_SUBSTRATE:
-                case RXN_ROLE_SIDESUBSTRATE:
-                    curv = new SubCurve();
-                    curv->as = &n->_p;
-                    curv->ns = n;
-                    curv->owns = 0; //weak ref
-                    curv->ae = &_p;
-                    curv->owne = 0; //weak ref
-                    break;
-                case RXN_ROLE_PRODUCT:
-                case RXN_ROLE_SIDEPRODUCT:
-                    curv = new PrdCurve();
-                    curv->as = &_p;
-                    curv->owns = 0; //weak ref
-                    curv->ae = &n->_p;
-                    curv->ne = n;
-                    curv->owne = 0; //weak ref
-                    break;
-                case RXN_ROLE_MODIFIER:
-                    curv = new ModCurve();
-                    curv->as = &n->_p;
-                    curv->ns = n;
-                    curv->owns = 0; //weak ref
-                    curv->ae = &_p;
-                    curv->owne = 0; //weak ref
-                    break;
-                case RXN_ROLE_ACTIVATOR:
-                    curv = new ActCurve();
-                    curv->as = &n->_p;
-                    curv->ns = n;
-                    curv->owns = 0; //weak ref
-                    curv->ae = &_p;
-                    curv->owne = 0; //weak ref
-                    break;
-                case RXN_ROLE_INHIBITOR:
-                    curv = new InhCurve();
-                    curv->as = &n->_p;
-                    curv->ns = n;
-                    curv->owns = 0; //weak ref
-                    curv->ae = &_p;
-                    curv->owne = 0; //weak ref
-                    break;
-                default:
-                    std::cerr << "Unrecognized role type\n";
-                    AN(0, "Unrecognized role type");
+            // the curve (reused if it already has the right type)
+            RxnBezier* curv = k < _curv.size() ? _curv[k] : NULL;
+            if(curv && curv->getRole() != RxnCurveFactory::CurveType(r)) {
+                delete curv;
+                curv = NULL;
             }
+            if(!curv)
+                curv = RxnCurveFactory::CreateCurve(r, arena);
             AN(curv, "Failed to create curve");
 # if REBUILD_CURVES_DIAG
             std::cerr << "  Curve type: " << CurveTypeToString(curv->getRole()) << "\n";
 # endif
+
+            if(curv->isStartNodeSide()) {
+                curv->as = &n->_p();
+                curv->ns = n;
+                curv->ae = &_p();
+                curv->ne = NULL;
+            } else {
+                curv->as = &_p();
+                curv->ns = NULL;
+                curv->ae = &n->_p();
+                curv->ne = n;
+            }
+            curv->owns = 0; //weak ref
+            curv->owne = 0; //weak ref
             
-            curv->setTransform(tf_);
-            curv->setInverseTransform(itf_);
-            _curv.push_back(curv);
+            curv->view_.bind(view_.get());
+            if(k < _curv.size())
+                _curv[k] = curv;
+            else
+                _curv.push_back(curv);
         }
-        
-        recalcCurveCPs();
+
+        // curves of species no longer in the reaction
+        while(_curv.size() > k) {
+            delete _curv.back();
+            _curv.pop_back();
+        }
+
+        // control points are stale
+        cpkey_.clear();
         
         _cdirty = 0;
 
 //         std::cerr << "Done rebuilding curves\n";
     }
 
+    bool Reaction::curvesMatchSpecies() const {
+        if(_curv.size() != _spec.size())
+            return false;
+        for(uint64 i=0; i<_spec.size(); ++i) {
+            Node* n = _spec[i].first;
+            const RxnBezier* c = _curv[i];
+            if(c->getRole() != RxnCurveFactory::CurveType(_spec[i].second))
+                return false;
+            if(c->getNodeUsed() != n)
+                return false;
+            if(c->isStartNodeSide()) {
+                if(c->as != &n->_p() || c->ae != &_p())
+                    return false;
+            } else {
+                if(c->as != &_p() || c->ae != &n->_p())
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void Reaction::refreshCurveStructure() {
+        if(_cdirty || !curvesMatchSpecies())
+            syncCurves();
+    }
+
+    void Reaction::refreshCurves() {
+        refreshCurveStructure();
+        if(curveInputsChanged())
+            recalcCurveCPs();
+    }
+
+    void Reaction::getCurveInputs(std::vector<Point>& key) const {
+        key.clear();
+        key.push_back(_p());
+        for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i) {
+            const Node* n = i->first;
+            Box b(n->getBoundingBox());
+            key.push_back(n->getCentroid());
+            key.push_back(b.getMin());
+            key.push_back(b.getMax());
+        }
+    }
+
+    bool Reaction::curveInputsChanged() const {
+        if(cpkey_.size() != 1 + 3*_spec.size())
+            return true;
+        std::vector<Point>::const_iterator k = cpkey_.begin();
+        if(k->x != _p().x || k->y != _p().y)
+            return true;
+        ++k;
+        for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i) {
+            const Node* n = i->first;
+            Point p(n->getCentroid());
+            Box b(n->getBoundingBox());
+            if(k->x != p.x || k->y != p.y)
+                return true;
+            ++k;
+            if(k->x != b.getMin().x || k->y != b.getMin().y)
+                return true;
+            ++k;
+            if(k->x != b.getMax().x || k->y != b.getMax().y)
+                return true;
+            ++k;
+        }
+        return false;
+    }
+
 #define PRINT_CURVE_DIAG 0
 
 # if PRINT_CURVE_DIAG
@@ -700,6 +1407,7 @@ namespace Graphfab {
 
     void Reaction::recalcCurveCPs() {
 //         std::cerr << "recalcCurveCPs\n";
+        getCurveInputs(cpkey_);
         uint64 csub=0;
         Point ctrlCent(0,0);
         Point loopPt;
@@ -749,7 +1457,7 @@ namespace Graphfab {
         }
 #endif
 
-        ctrlCent = (ctrlCent+_p) * (1. / (csub+1));
+        ctrlCent = (ctrlCent+_p()) * (1. / (csub+1));
         
 #if PRINT_CURVE_DIAG
         if (!filterRxn(this))
@@ -758,11 +1466,11 @@ namespace Graphfab {
 
         if(looped) {
             const Real d = -25.;
-            ctrlCent = _p + (_p - loopPt);
+            ctrlCent = _p() + (_p() - loopPt);
 
-            ctrlCent = new2ndPos(loopPt, _p, 0., d, false);
+            ctrlCent = new2ndPos(loopPt, _p(), 0., d, false);
 
-            ctrlCent = new2ndPos(_p, ctrlCent, -90., 0., false);
+            ctrlCent = new2ndPos(_p(), ctrlCent, -90., 0., false);
         }
         
 #if PRINT_CURVE_DIAG
@@ -772,7 +1480,7 @@ namespace Graphfab {
 
         // Correction applied to uni-uni reactions
         if (NetworkElement::degree() == 2) {
-            double d = -(_p - ctrlCent).mag();
+            double d = -(_p() - ctrlCent).mag();
 //             std::cerr << "  uni-uni dist: " << d << "\n";
             Point p1, p2;
 
@@ -804,8 +1512,8 @@ namespace Graphfab {
                 }
             }
 
-            ctrlCent = _p + (p2 - p1);
-            ctrlCent = new2ndPos(ctrlCent, _p, 0, d, false);
+            ctrlCent = _p() + (p2 - p1);
+            ctrlCent = new2ndPos(ctrlCent, _p(), 0, d, false);
         }
         
 #if PRINT_CURVE_DIAG
@@ -814,9 +1522,9 @@ namespace Graphfab {
 #endif
 
         // keep dir, subtract 25 from length
-        ctrlCent = new2ndPos(ctrlCent, _p, 0., -25., false);
-//         ctrlCent = new2ndPos(ctrlCent, _p, 180., 0., false);
-//         ctrlCent = new2ndPos(ctrlCent, _p, 0., 50., false);
+        ctrlCent = new2ndPos(ctrlCent, _p(), 0., -25., false);
+//         ctrlCent = new2ndPos(ctrlCent, _p(), 180., 0., false);
+//         ctrlCent = new2ndPos(ctrlCent, _p(), 0., 50., false);
         
 #if PRINT_CURVE_DIAG
         if (!filterRxn(this))
@@ -839,7 +1547,7 @@ namespace Graphfab {
                       std::cerr << "SUBSTRATE\n";
 #endif
                     c->s = calcCurveBackup(ctrlCent, *c->as, c->ns ? c->ns->getBoundingBox() : bs, 10.);
-                    c->c1 = new2ndPos(_p, c->s, 0., -20., false);
+                    c->c1 = new2ndPos(_p(), c->s, 0., -20., false);
                     c->e = *c->ae;
 //                     std::cerr << "* Substrate endpoint: " << c->e << "\n";
                     c->c2 = ctrlCent;
@@ -848,14 +1556,14 @@ namespace Graphfab {
 #if PRINT_CURVE_DIAG
                     if (!filterRxn(this)) {
                       std::cerr << "PRODUCT\n";
-                      std::cerr << "  rxn " << getId() <<  ", ctrlCent: " << ctrlCent << ", _p: " << _p << ", *c->ae: " << *c->ae << ", ne: " << c->ne->getId() << ", ne coords: " << c->ne->getCentroid() << ", ne corner: " << c->ne->getBoundingBox().getMin() << "\n";
+                      std::cerr << "  rxn " << getId() <<  ", ctrlCent: " << ctrlCent << ", _p(): " << _p() << ", *c->ae: " << *c->ae << ", ne: " << c->ne->getId() << ", ne coords: " << c->ne->getCentroid() << ", ne corner: " << c->ne->getBoundingBox().getMin() << "\n";
                     }
 #endif
                     c->s = *c->as;
 //                     std::cerr << "* Product startpoint: " << c->s << "\n";
-                    c->c1 = new2ndPos(ctrlCent, _p, 0., 1., true);
+                    c->c1 = new2ndPos(ctrlCent, _p(), 0., 1., true);
                     c->e = calcCurveBackup(c->c1, *c->ae, c->ne ? c->ne->getBoundingBox() : be, 10.);
-                    c->c2 = new2ndPos(_p, c->e, 0., -20., false);
+                    c->c2 = new2ndPos(_p(), c->e, 0., -20., false);
                     break;
                 case RXN_CURVE_ACTIVATOR:
                 case RXN_CURVE_INHIBITOR:
@@ -864,17 +1572,17 @@ namespace Graphfab {
                     if (!filterRxn(this))
                       std::cerr << "MODIFIER\n";
 #endif
-                    c->s  = calcCurveBackup(_p, *c->as, c->ns ? c->ns->getBoundingBox() : bs, 10.);
-                    c->c1 = new2ndPos(*c->as, _p, 0., -15., false);
+                    c->s  = calcCurveBackup(_p(), *c->as, c->ns ? c->ns->getBoundingBox() : bs, 10.);
+                    c->c1 = new2ndPos(*c->as, _p(), 0., -15., false);
                     c->e = c->c1;
-                    c->c2 = new2ndPos(*c->as, _p, 0., -20., false);
+                    c->c2 = new2ndPos(*c->as, _p(), 0., -20., false);
                     break;
                 default:
                     AN(0, "Unrecognized curve type");
-                    c->s = calcCurveBackup(_p, *c->as, c->ns ? c->ns->getBoundingBox() : bs, 10.);
+                    c->s = calcCurveBackup(_p(), *c->as, c->ns ? c->ns->getBoundingBox() : bs, 10.);
                     c->c1 = c->s;
-                    c->e = _p;
-                    c->c2 = _p;
+                    c->e = _p();
+                    c->c2 = _p();
                     break;
             }
 #if PRINT_CURVE_DIAG
@@ -939,14 +1647,14 @@ namespace Graphfab {
     void Reaction::recenter() {
 //         std::cerr << "RECENTER\n";
         uint32 count=0;
-        _p = Point(0.,0.);
+        _p() = Point(0.,0.);
         for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i) {
             Node* n = i->first;
-            _p = _p + n->getCentroid();
+            _p() = _p() + n->getCentroid();
             ++count;
         }
         // normalize
-        _p = _p*(1./count);
+        _p() = _p()*(1./count);
         rebuildCurves();
     }
     
@@ -965,7 +1673,7 @@ namespace Graphfab {
 
     void Reaction::doCentroidCalc() {
       uint32 count=0;
-      _p = Point(0.,0.);
+      _p() = Point(0.,0.);
       for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i) {
         // detect duplicates
         for(ConstNodeIt j=NodesBegin(); j!=i; ++j)
@@ -974,22 +1682,76 @@ namespace Graphfab {
 
         {
           Node* n = i->first;
-          _p = _p + n->getCentroid();
+          _p() = _p() + n->getCentroid();
           ++count;
         }
 
         doCentroidCalc_skip:;
       }
       // normalize
-      _p = _p*(1./count);
+      _p() = _p()*(1./count);
     }
     
+    RxnBezier* Reaction::addCurve(RxnRoleType role) {
+        _curv.push_back(RxnCurveFactory::CreateCurve(role, owner_.net ? owner_.net->getArena() : NULL));
+        _curv.back()->view_.bind(view_.get());
+        return _curv.back();
+    }
+
+    void Reaction::bindView(const ViewTransform* v) {
+        view_.bind(v);
+        for(CurveIt i=CurvesBegin(); i!=CurvesEnd(); ++i)
+            (*i)->view_.bind(v);
+    }
+
+    void Reaction::moveCurveAnchors(const Point* from) {
+        for(CurveIt i=CurvesBegin(); i!=CurvesEnd(); ++i) {
+            RxnBezier* c = *i;
+            if(c->as == from)
+                c->as = &_p();
+            if(c->ae == from)
+                c->ae = &_p();
+        }
+    }
+
+    void Reaction::remapCopy(const ElementRemap& m, ElementArena* arena) {
+        for(NodeIt i=NodesBegin(); i!=NodesEnd(); ++i)
+            i->first = static_cast<Node*>(m(i->first));
+        for(CurveIt i=CurvesBegin(); i!=CurvesEnd(); ++i) {
+            RxnBezier* c = RxnCurveFactory::CloneCurve(*i, arena);
+            c->ns = static_cast<Node*>(m(c->ns));
+            c->ne = static_cast<Node*>(m(c->ne));
+            *i = c;
+        }
+    }
+
+    void Reaction::remapCurveAnchors(const ElementRemap& m) {
+        for(CurveIt i=CurvesBegin(); i!=CurvesEnd(); ++i) {
+            RxnBezier* c = *i;
+            Point* as = m.centroid(c->as);
+            Point* ae = m.centroid(c->ae);
+            if(!as || !ae) {
+                // not anchored to an element of the network: rebuild on next use
+                as = ae = &_p();
+                _cdirty = 1;
+            }
+            c->as = as;
+            c->ae = ae;
+        }
+    }
+
     void Reaction::deleteCurves() {
         for(CurveVec::iterator i=_curv.begin(); i!=_curv.end(); ++i) {
             delete *i;
         }
         _curv.clear();
     }
+
+    void Reaction::disposeCurves(ElementArena* arena) {
+        for(CurveVec::iterator i=_curv.begin(); i!=_curv.end(); ++i)
+            arena->dispose(*i);
+        _curv.clear();
+    }
     
     void Reaction::dump(std::ostream& os, uint32 ind) {
         indent(os, ind);
@@ -1010,37 +1772,76 @@ namespace Graphfab {
     
     void Reaction::dumpForces(std::ostream& os, uint32 ind) const {
         indent(os, ind);
-        os << "Reaction forces: " << _v << "\n";
+        os << "Reaction forces: " << _v() << "\n";
     }
     
     //--CLASS Compartment--
     
+    void Compartment::setId(const std::string& id) {
+        if(owner_.net) {
+            std::string before(_id.str());
+            _id = id;
+            owner_.net->eltIdChanged(this, before);
+        } else
+            _id = id;
+    }
+    
+    void Compartment::setGlyph(const std::string& glyph) {
+        if(owner_.net) {
+            std::string before(_gly.str());
+            _gly = glyph;
+            owner_.net->eltGlyphChanged(this, before);
+        } else
+            _gly = glyph;
+    }
+    
     void Compartment::addElt(NetworkElement* e) {
-        _elt.push_back(e);
+        if(eltpos_.insert(std::make_pair((const NetworkElement*)e, (uint64)_elt.size())).second)
+            _elt.push_back(e);
     }
     
     bool Compartment::containsElt(const NetworkElement* e) const {
-        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            const NetworkElement* x = *i;
-            if(x == e)
-                return true;
-        }
-        return false;
+        return eltpos_.find(e) != eltpos_.end();
     }
     
     void Compartment::removeElt(NetworkElement* e) {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            if(*i == e) {
-                printf("Element erased\n");
-                _elt.erase(i);
-                return;
-            }
+        EltPosMap::iterator i = eltpos_.find(e);
+        if(i == eltpos_.end())
+            return;
+        uint64 k = i->second;
+        eltpos_.erase(i);
+        if(k + 1 != _elt.size()) {
+            _elt[k] = _elt.back();
+            eltpos_[_elt[k]] = k;
         }
+        _elt.pop_back();
+    }
+
+    void Compartment::reindexElts() {
+        eltpos_.clear();
+        for(uint64 k=0; k<_elt.size(); ++k)
+            eltpos_[_elt[k]] = k;
+    }
+
+    void Compartment::remapCopy(const ElementRemap& m) {
+        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i)
+            *i = m(*i);
+        reindexElts();
     }
     
+    void Compartment::setMin(const Point& p) {
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        _ext().setMin(p);
+    }
+
+    void Compartment::setMax(const Point& p) {
+        EditJournal::GeometryScope edit(getRecordingJournal(), this);
+        _ext().setMax(p);
+    }
+
     void Compartment::setRestExtents(const Box& ext) {
-        _ext = ext;
-        _ra = _ext.area();
+        _ext() = ext;
+        _ra = _ext().area();
     }
     
     void Compartment::resizeEnclose(double padding) {
@@ -1061,9 +1862,9 @@ namespace Graphfab {
             miny = min(miny, e->getMinY());
             maxy = max(maxy, e->getMaxY());
         }
-        _ext = Box(Point(minx,miny), Point(maxx,maxy));
-        _ext = _ext.padded(padding);
-        _ra = _ext.area();
+        _ext() = Box(Point(minx,miny), Point(maxx,maxy));
+        _ext() = _ext().padded(padding);
+        _ra = _ext().area();
     }
     
     void Compartment::autoSize() {
@@ -1071,17 +1872,17 @@ namespace Graphfab {
         Real dim = 350*sqrt((Real)count);
         // avoid singularities in layout algo
         Point shake((rand()%1000)/100.,(rand()%1000)/100.);
-        _ext = Box(Point(0,0) + shake, Point(dim,dim) + shake);
-		//_ext = Box(Point(0, 0), Point(dim, dim));
-        _ra = _ext.area();
+        _ext() = Box(Point(0,0) + shake, Point(dim,dim) + shake);
+		//_ext() = Box(Point(0, 0), Point(dim, dim));
+        _ra = _ext().area();
     }
     
     void Compartment::resetActivity() {
-        _v = Point(0,0);
+        _v() = Point(0,0);
         // now calculate stress due to being stretched beyond rest area
         // this stress always acts to shrink the comp
-        Real w = _ext.width(), h = _ext.height();
-        Real d2 = _ext.area()-_ra;
+        Real w = _ext().width(), h = _ext().height();
+        Real d2 = _ext().area()-_ra;
         // strain (liberally speaking), evenly distributed along all axes
         Real strain = sign(d2)*sqrt(mag(d2) / _ra);
         _fx1 = _res*_E*strain*w;
@@ -1098,13 +1899,18 @@ namespace Graphfab {
     }
     
     void Compartment::doInternalForce(NetworkElement* e, const Real f, const Real t) {
-        Real x1=_ext.getMin().x, y1 = _ext.getMin().y, x2 = _ext.getMax().x, y2 = _ext.getMax().y;
+        // do forces on element
+        e->addDelta(internalForce(e->getExtents(), f, t));
+    }
+
+    Point Compartment::internalForce(const Box& e, const Real f, const Real t) {
+        Real x1=_ext().getMin().x, y1 = _ext().getMin().y, x2 = _ext().getMax().x, y2 = _ext().getMax().y;
         Real invt = 1./t;
         
-        Real eminx = e->getMinX();
-        Real eminy = e->getMinY();
-        Real emaxx = e->getMaxX();
-        Real emaxy = e->getMaxY();
+        Real eminx = e.getMin().x;
+        Real eminy = e.getMin().y;
+        Real emaxx = e.getMax().x;
+        Real emaxy = e.getMax().y;
         
         // compute forces
         Real fx1 = f*exp((x1-eminx)*invt);
@@ -1112,12 +1918,11 @@ namespace Graphfab {
         Real fy1 = f*exp((y1-eminy)*invt);
         Real fy2 = -f*exp((emaxy-y2)*invt);
         
-        // do forces on element
-        e->addDelta(Point(fx1+fx2, fy1+fy2));
-        
         // do forces on container
         applyBoundaryForce(-fx1, -fx2, -fy1, -fy2);
         addDelta(-Point(fx1+fx2,fy1+fy2));
+
+        return Point(fx1+fx2, fy1+fy2);
     }
     
     void Compartment::doInternalForceAll(const Real f, const Real t) {
@@ -1128,23 +1933,23 @@ namespace Graphfab {
     }
     
     void Compartment::doMotion(const Real scale_) {
-        if(_lock)
+        if(_lock())
             return;
         const Real scale = 0.2*scale_;
-        Real w = _ext.width(), h = _ext.height();
+        Real w = _ext().width(), h = _ext().height();
         // adjust the extents based on Hooke's law of elasticity
         // forces -> stress -> strain -> displacement
-        _ext.setMin(_ext.getMin() + (scale/_E)*Point(_fx1*w/h, _fy1*h/w) + scale*_v);
-        _ext.setMax(_ext.getMax() + (scale/_E)*Point(_fx2*w/h, _fy2*h/w) + scale*_v);
-        if(_ext.width() < 10.)
-            _ext.setWidth(10.);
-        if(_ext.height() < 10.)
-            _ext.setHeight(10.);
+        _ext().setMin(_ext().getMin() + (scale/_E)*Point(_fx1*w/h, _fy1*h/w) + scale*_v());
+        _ext().setMax(_ext().getMax() + (scale/_E)*Point(_fx2*w/h, _fy2*h/w) + scale*_v());
+        if(_ext().width() < 10.)
+            _ext().setWidth(10.);
+        if(_ext().height() < 10.)
+            _ext().setHeight(10.);
         //recalc centroid?
     }
     
     void Compartment::capDelta2(const Real cap2) {
-        _v.capMag2_(cap2);
+        _v().capMag2_(cap2);
         const Real cap = sqrt(cap2);
         if(mag(_fx1) > cap)
             _fx1 = sign(_fx1)*cap;
@@ -1157,11 +1962,7 @@ namespace Graphfab {
     }
     
     bool Compartment::contains(const NetworkElement* e) const {
-        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            if(*i == e)
-                return true;
-        }
-        return false;
+        return containsElt(e);
     }
     
     void Compartment::dump(std::ostream& os, uint32 ind) {
@@ -1172,46 +1973,454 @@ namespace Graphfab {
         indent(os, ind+2);
         os << "Glyph: \"" << _gly << "\"\n";
         indent(os, ind+2);
-        os << "Extents: " << _ext << "\n";
+        os << "Extents: " << _ext() << "\n";
     }
     
     void Compartment::dumpForces(std::ostream& os, uint32 ind) const {
         indent(os, ind);
-        os << "Compartment forces: " << _fx1 << ", " << _fy1 << ", " << _fx2 << ", " << _fy2 << "), Centroid forces: " << _v << "\n";
+        os << "Compartment forces: " << _fx1 << ", " << _fy1 << ", " << _fx2 << ", " << _fy2 << "), Centroid forces: " << _v() << "\n";
     }
     
-    //--CLASS Network--
-    
-    void Network::hierarchRelease() {
-        // FIXME: replace with hierarch free
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            // (*i)->hierarchRelease();
-            delete *i;
+    //--CLASS EditJournal--
+
+    EditJournal::GeometryScope::GeometryScope(EditJournal* j, NetworkElement* e)
+        : j_(j), e_(e) {
+        if(j_)
+            before_ = getGeometry(e_);
+    }
+
+    EditJournal::GeometryScope::~GeometryScope() {
+        if(j_)
+            j_->recordGeometry(e_, before_);
+    }
+
+    EditJournal::Geometry EditJournal::getGeometry(const NetworkElement* e) {
+        Geometry g;
+        g.p = e->_p();
+        g.ext = e->_ext();
+        g.r = e->_r();
+        return g;
+    }
+
+    void EditJournal::setGeometry(NetworkElement* e, const Geometry& g) {
+        e->_p() = g.p;
+        e->_ext() = g.ext;
+        e->_r() = g.r;
+    }
+
+    void EditJournal::setEnabled(bool enabled) {
+        if(!enabled)
+            clear();
+        enabled_ = enabled;
+    }
+
+    void EditJournal::clear() {
+        undo_.clear();
+        redo_.clear();
+        seal();
+        base_ = 0;
+        bytes_ = 0;
+        refs_.clear();
+        for(std::unordered_set<NetworkElement*>::iterator i=hidden_.begin(); i!=hidden_.end(); ++i)
+            release(*i);
+        hidden_.clear();
+    }
+
+    void EditJournal::release(NetworkElement* e) {
+        switch(e->getType()) {
+            case NET_ELT_TYPE_SPEC:
+                delete static_cast<Node*>(e);
+                break;
+            case NET_ELT_TYPE_RXN:
+                static_cast<Reaction*>(e)->hierarchRelease();
+                delete static_cast<Reaction*>(e);
+                break;
+            default:
+                AN(0, "Unexpected element type");
         }
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
-            (*i)->hierarchRelease();
-            delete *i;
+    }
+
+    void EditJournal::ref(NetworkElement* e) {
+        if(e)
+            ++refs_[e];
+    }
+
+    void EditJournal::unref(NetworkElement* e) {
+        if(!e)
+            return;
+        std::unordered_map<const NetworkElement*, uint64>::iterator i = refs_.find(e);
+        AT(i != refs_.end(), "Element not referenced by the history");
+        if(--i->second)
+            return;
+        refs_.erase(i);
+        // no step left that could put it back
+        if(hidden_.erase(e))
+            release(e);
+    }
+
+    void EditJournal::discard(const Edit& x) {
+        bytes_ -= cost(x);
+        unref(x.e);
+        unref(x.other);
+        for(std::vector<SpeciesRef>::const_iterator i=x.refs.begin(); i!=x.refs.end(); ++i)
+            unref(i->r);
+    }
+
+    void EditJournal::setMemoryLimit(uint64 bytes) {
+        limit_ = bytes;
+        trim();
+    }
+
+    void EditJournal::beginGroup() {
+        if(!depth_++)
+            open_ = ++lastgroup_;
+    }
+
+    void EditJournal::endGroup() {
+        AT(depth_, "No group to end");
+        --depth_;
+    }
+
+    uint64 EditJournal::cost(const Edit& x) const {
+        return sizeof(Edit) + x.refs.capacity()*sizeof(SpeciesRef);
+    }
+
+    void EditJournal::push(Edit& x) {
+        x.group = depth_ ? open_ : ++lastgroup_;
+        ref(x.e);
+        ref(x.other);
+        for(std::vector<SpeciesRef>::const_iterator i=x.refs.begin(); i!=x.refs.end(); ++i)
+            ref(i->r);
+        // a new edit invalidates the undone ones
+        while(!redo_.empty()) {
+            discard(redo_.back());
+            redo_.pop_back();
         }
-        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
-            // (*i)->hierarchRelease();
-            delete *i;
+
+        undo_.push_back(x);
+        bytes_ += cost(x);
+        trim();
+    }
+
+    void EditJournal::trim() {
+        // oldest steps first, then the furthest redo steps
+        while(bytes_ > limit_ && !undo_.empty()) {
+            uint64 g = undo_.front().group;
+            while(!undo_.empty() && undo_.front().group == g) {
+                discard(undo_.front());
+                undo_.pop_front();
+                ++base_;
+            }
+            if(undo_.empty())
+                seal();
+        }
+        while(bytes_ > limit_ && !redo_.empty()) {
+            uint64 g = redo_.front().group;
+            while(!redo_.empty() && redo_.front().group == g) {
+                discard(redo_.front());
+                redo_.pop_front();
+            }
         }
     }
+
+    void EditJournal::recordGeometry(NetworkElement* e, const Geometry& before) {
+        if(!isRecording())
+            return;
+        Geometry after = getGeometry(e);
+        if(!sealed_) {
+            std::unordered_map<const NetworkElement*, uint64>::iterator i = coalesce_.find(e);
+            if(i != coalesce_.end()) {
+                undo_[i->second - base_].after = after;
+                return;
+            }
+        }
+        // merge only into a step that holds nothing but moves & resizes
+        bool extend = !sealed_ && depth_ && !undo_.empty() && undo_.back().group == open_;
+        if(!extend)
+            seal();
+
+        Edit x;
+        x.type = EDIT_GEOMETRY;
+        x.e = e;
+        x.other = NULL;
+        x.k = 0;
+        x.role = RXN_ROLE_SUBSTRATE;
+        x.before = before;
+        x.after = after;
+        push(x);
+
+        sealed_ = false;
+        coalesce_[e] = base_ + undo_.size() - 1;
+    }
+
+    void EditJournal::recordNode(Node* n, bool added) {
+        if(!isRecording())
+            return;
+        Edit x;
+        x.type = added ? EDIT_ADD_NODE : EDIT_REMOVE_NODE;
+        x.e = n;
+        x.other = NULL;
+        x.k = 0;
+        x.role = RXN_ROLE_SUBSTRATE;
+        if(!added) {
+            saveNode(x);
+            hide(n);
+        } else
+            unhide(n);
+        seal();
+        push(x);
+    }
+
+    void EditJournal::recordReaction(Reaction* r, bool added) {
+        if(!isRecording())
+            return;
+        Edit x;
+        x.type = added ? EDIT_ADD_RXN : EDIT_REMOVE_RXN;
+        x.e = r;
+        x.other = NULL;
+        x.k = 0;
+        x.role = RXN_ROLE_SUBSTRATE;
+        if(!added)
+            hide(r);
+        else
+            unhide(r);
+        seal();
+        push(x);
+    }
+
+    void EditJournal::recordConnect(Reaction* r, uint64 k) {
+        if(!isRecording())
+            return;
+        Edit x;
+        Reaction::NodeIt i = r->NodesBegin() + k;
+        x.type = EDIT_CONNECT;
+        x.e = i->first;
+        x.other = r;
+        x.k = k;
+        x.role = i->second;
+        seal();
+        push(x);
+    }
+
+    void EditJournal::recordAlias(Node* n, bool before) {
+        if(!isRecording())
+            return;
+        Edit x;
+        x.type = EDIT_ALIAS;
+        x.e = n;
+        x.other = NULL;
+        x.k = before ? 1 : 0;
+        x.role = RXN_ROLE_SUBSTRATE;
+        seal();
+        push(x);
+    }
+
+    void EditJournal::saveNode(Edit& x) {
+        Node* n = static_cast<Node*>(x.e);
+        x.refs.clear();
+        x.other = NULL;
+        Network::AttachedRxnList rxns = net_->getConnectedReactions(n);
+        for(Network::AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
+            uint64 k = 0;
+            for(Reaction::NodeIt j=(*i)->NodesBegin(); j!=(*i)->NodesEnd(); ++j, ++k)
+                if(j->first == n) {
+                    SpeciesRef ref = {*i, k, j->second};
+                    x.refs.push_back(ref);
+                }
+        }
+        // aliases are added to a compartment without setting _comp
+        x.other = net_->findContainingCompartment(n);
+    }
+
+    void EditJournal::hideNode(Edit& x) {
+        uint64 c = cost(x);
+        std::vector<SpeciesRef> old(x.refs);
+        NetworkElement* comp = x.other;
+        saveNode(x);
+        for(std::vector<SpeciesRef>::const_iterator i=x.refs.begin(); i!=x.refs.end(); ++i)
+            ref(i->r);
+        ref(x.other);
+        for(std::vector<SpeciesRef>::const_iterator i=old.begin(); i!=old.end(); ++i)
+            unref(i->r);
+        unref(comp);
+        bytes_ += cost(x) - c;
+        net_->removeNode(static_cast<Node*>(x.e));
+        hide(x.e);
+    }
+
+    void EditJournal::restoreNode(Edit& x) {
+        Node* n = static_cast<Node*>(x.e);
+        net_->addNode(n);
+        unhide(n);
+        if(x.other)
+            static_cast<Graphfab::Compartment*>(x.other)->addElt(n);
+        // saved in reaction order & ascending position, so each lands where it was
+        for(std::vector<SpeciesRef>::iterator i=x.refs.begin(); i!=x.refs.end(); ++i) {
+            i->r->insertSpeciesRef(i->k, n, i->role);
+            if(i+1 == x.refs.end() || (i+1)->r != i->r)
+                i->r->rebuildCurves();
+        }
+    }
+
+    void EditJournal::apply(Edit& x) {
+        switch(x.type) {
+            case EDIT_GEOMETRY:
+                setGeometry(x.e, x.after);
+                break;
+            case EDIT_ADD_NODE:
+                restoreNode(x);
+                break;
+            case EDIT_REMOVE_NODE:
+                hideNode(x);
+                break;
+            case EDIT_ADD_RXN:
+                net_->addReaction(static_cast<Reaction*>(x.e));
+                unhide(x.e);
+                break;
+            case EDIT_REMOVE_RXN:
+                net_->removeReaction(static_cast<Reaction*>(x.e));
+                hide(x.e);
+                break;
+            case EDIT_CONNECT: {
+                Reaction* r = static_cast<Reaction*>(x.other);
+                r->insertSpeciesRef(x.k, static_cast<Node*>(x.e), x.role);
+                r->rebuildCurves();
+                break;
+            }
+            case EDIT_ALIAS:
+                static_cast<Node*>(x.e)->setAlias(!x.k);
+                break;
+        }
+    }
+
+    void EditJournal::revert(Edit& x) {
+        switch(x.type) {
+            case EDIT_GEOMETRY:
+                setGeometry(x.e, x.before);
+                break;
+            case EDIT_ADD_NODE:
+                hideNode(x);
+                break;
+            case EDIT_REMOVE_NODE:
+                restoreNode(x);
+                break;
+            case EDIT_ADD_RXN:
+                net_->removeReaction(static_cast<Reaction*>(x.e));
+                hide(x.e);
+                break;
+            case EDIT_REMOVE_RXN:
+                net_->addReaction(static_cast<Reaction*>(x.e));
+                unhide(x.e);
+                break;
+            case EDIT_CONNECT: {
+                Reaction* r = static_cast<Reaction*>(x.other);
+                r->removeSpeciesRef(x.k);
+                r->rebuildCurves();
+                break;
+            }
+            case EDIT_ALIAS:
+                static_cast<Node*>(x.e)->setAlias(x.k != 0);
+                break;
+        }
+    }
+
+    bool EditJournal::undo() {
+        if(undo_.empty())
+            return false;
+        seal();
+        replaying_ = true;
+        try {
+            uint64 g = undo_.back().group;
+            while(!undo_.empty() && undo_.back().group == g) {
+                revert(undo_.back());
+                redo_.push_back(undo_.back());
+                undo_.pop_back();
+            }
+        } catch(...) {
+            replaying_ = false;
+            throw;
+        }
+        replaying_ = false;
+        return true;
+    }
+
+    bool EditJournal::redo() {
+        if(redo_.empty())
+            return false;
+        seal();
+        replaying_ = true;
+        try {
+            uint64 g = redo_.back().group;
+            while(!redo_.empty() && redo_.back().group == g) {
+                apply(redo_.back());
+                undo_.push_back(redo_.back());
+                redo_.pop_back();
+            }
+        } catch(...) {
+            replaying_ = false;
+            throw;
+        }
+        replaying_ = false;
+        return true;
+    }
+
+    
+    void Network::hierarchRelease() {
+        journal_.clear();
+        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i)
+            arena_->dispose(*i);
+        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
+            (*i)->disposeCurves(arena_);
+            arena_->dispose(*i);
+        }
+        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i)
+            arena_->dispose(*i);
+
+        _nodes.clear();
+        _rxn.clear();
+        _comp.clear();
+        _elt.clear();
+        nodeids_.clear();
+        nodeglyphs_.clear();
+        rxnids_.clear();
+        compids_.clear();
+        compglyphs_.clear();
+        aliasgroups_.clear();
+        idxuse_.clear();
+        idxfree_ = FreeList();
+        idnext_ = 1;
+        idfree_ = FreeList();
+        structureChanged();
+    }
     
     void Network::addNode(Node* n) {
         AN(n, "No node to add");
         _nodes.push_back(n);
         addElt(n);
+        geom_.attach(n, n->geo_, NET_ELT_TYPE_SPEC);
+        n->owner_.net = this;
+        n->view_.bind(&viewtf_);
+        n->bindSymbols(&symbols_);
+        nodeids_.add(n);
+        nodeglyphs_.add(n);
+        aliasgroups_.add(n);
+        claimIndex(n->get_i());
+        structureChanged();
+        if(journal_.isRecording())
+            journal_.recordNode(n, true);
     }
     
     void Network::removeReactionsForNode(Node* n) {
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
+        AttachedRxnList rxns = getConnectedReactions(n);
+        for(AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
             (*i)->removeNode(n);
         }
     }
     
     void Network::removeNode(Node* n) {
         AN(n, "No node to remove");
+        if(journal_.isRecording() && containsNode(n))
+            journal_.recordNode(n, false);
         // remove from element container
         removeElt(n);
         // remove from compartments
@@ -1224,7 +2433,16 @@ namespace Graphfab {
             Node* x = *i;
             if(x == n) {
                 _nodes.erase(i);
-                std::cout << "Removed node " << n << "\n";
+                nodeids_.remove(n, n->getId());
+                nodeglyphs_.remove(n, n->getGlyph());
+                aliasgroups_.remove(n, n->getId());
+                releaseIndex(n->get_i());
+                releaseGeneratedId(n->getId());
+                geom_.detach(n->geo_);
+                n->owner_.net = NULL;
+                n->view_.bind(NULL);
+                n->bindSymbols(NULL);
+                structureChanged();
                 return;
             }
         }
@@ -1255,41 +2473,45 @@ namespace Graphfab {
     }
     
     Node* Network::findNodeById(const std::string& id) {
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* n = *i;
-            if(n->getId() == id)
-                return n;
-        }
-        //not found
-        return NULL;
+        return nodeids_.find(id, _nodes);
     }
     
     const Node* Network::findNodeById(const std::string& id) const {
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            const Node* n = *i;
-            if(n->getId() == id)
-                return n;
-        }
-        //not found
-        return NULL;
+        return nodeids_.find(id, _nodes);
     }
     
     std::string Network::getUniqueId() const {
-        std::size_t k=0;
-        std::string id;
-        const Node* n=NULL;
-        
-        do {
-            ++k;
+        for(;;) {
+            std::size_t k;
+            if(!idfree_.empty()) {
+                k = idfree_.top();
+                idfree_.pop();
+            } else
+                k = idnext_++;
+
             std::stringstream ss;
             ss << "Node_" << k;
-            id = ss.str();
-            std::cout << "Trying " << id << "\n";
-        } while(findNodeById(id));
-        
-        std::cout << "Unique ID: " << id << "\n";
-        
-        return id;
+            std::string id = ss.str();
+            if(!findNodeById(id))
+                return id;
+        }
+    }
+
+    void Network::releaseGeneratedId(const std::string& id) {
+        static const std::string prefix("Node_");
+        if(id.size() <= prefix.size() || id.compare(0, prefix.size(), prefix))
+            return;
+        // only canonical numbers (no sign, no leading zeros) map back to a counter value
+        if(id[prefix.size()] == '0')
+            return;
+        std::size_t k = 0;
+        for(std::size_t c=prefix.size(); c<id.size(); ++c) {
+            if(id[c] < '0' || id[c] > '9')
+                return;
+            k = k*10 + (id[c] - '0');
+        }
+        if(k < idnext_)
+            idfree_.push(k);
     }
 
     std::string Network::getUniqueGlyphId(const Node& src) const {
@@ -1304,108 +2526,89 @@ namespace Graphfab {
     }
     
     std::size_t Network::getUniqueIndex() const {
-//         std::cout << "getUniqueIndex started\n";
-        std::size_t k=0;
-        
-        repeat:
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            const Node* node = *i;
-            if(node->get_i() == k) {
-                ++k;
-                goto repeat;
-            }
+        // discard free entries that have been claimed since they were pushed
+        while(!idxfree_.empty() && idxuse_[idxfree_.top()])
+            idxfree_.pop();
+        if(!idxfree_.empty())
+            return idxfree_.top();
+        return idxuse_.size();
+    }
+
+    void Network::claimIndex(std::size_t k) {
+        if(k >= idxuse_.size()) {
+            for(std::size_t j=idxuse_.size(); j<k; ++j)
+                idxfree_.push(j);
+            idxuse_.resize(k+1, 0);
         }
-        
-        return k;
+        ++idxuse_[k];
+    }
+
+    void Network::releaseIndex(std::size_t k) {
+        AT(k < idxuse_.size() && idxuse_[k], "Index not held by any node");
+        if(!--idxuse_[k])
+            idxfree_.push(k);
+    }
+
+    void Network::nodeIndexChanged(std::size_t before, std::size_t after) {
+        releaseIndex(before);
+        claimIndex(after);
     }
     
     Node* Network::findNodeByGlyph(const std::string& gly) {
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* n = *i;
-            if(n->getGlyph() == gly)
-                return n;
-        }
-        //not found
-        return NULL;
+        return nodeglyphs_.find(gly, _nodes);
     }
 
     Node* Network::getUniqueNodeAt(const size_t n) {
-        size_t k = 0, a = 1;
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* x = *i;
-            if (k == n)
-                return x;
-            if (!x->isAlias()) {
-                ++k;
-                a = 1;
-            } else {
-                k += a;
-                a = 0;
-            }
-        }
-        {
+        if (n >= aliasgroups_.getNumGroups()) {
             std::stringstream ss;
             ss << "No unique node with given index " << n << " where number of unique nodes is " << getNumUniqueNodes();
             SBNW_THROW(InvalidParameterException, ss.str(), "Network::getUniqueNodeAt");
         }
+        return aliasgroups_.getGroup(n).front();
     }
 
     size_t Network::getNumInstances(const Node* u) {
-        size_t k = 0;
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* v = *i;
-            if (u->isCommonInstance(v))
-                ++k;
-        }
-        return k;
+        const AliasGroupIndex::Instances* g = aliasgroups_.find(u->getId());
+        return g ? g->size() : 0;
     }
 
     Node* Network::getInstance(const Node* u, const size_t n) {
-        size_t k = 0;
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* v = *i;
-            if (u->isCommonInstance(v)) {
-                if (k == n)
-                    return v;
-                else
-                    ++k;
-            }
-        }
-        {
+        const AliasGroupIndex::Instances* g = aliasgroups_.find(u->getId());
+        if (!g || n >= g->size()) {
             std::stringstream ss;
             ss << "No instance with given index " << n << " where number of unique nodes is " << getNumUniqueNodes();
             SBNW_THROW(InvalidParameterException, ss.str(), "Network::getInstance");
         }
+        return (*g)[n];
     }
     
     bool Network::containsNode(const Node* n) const {
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            const Node* x = *i;
-            if(x == n)
-                return true;
-        }
-        return false;
+        return n && n->owner_.net == this;
     }
 
     bool Network::containsReaction(const Reaction* r) const {
-        for(ConstRxnIt i=RxnsBegin(); i!=RxnsEnd(); ++i) {
-            const Reaction* x = *i;
-            if(x == r)
-                return true;
-        }
-        return false;
+        return r && r->owner_.net == this;
     }
 
     Network::AttachedRxnList Network::getConnectedReactions(const Node* n) {
         AttachedRxnList result;
-        for(ConstRxnIt i = RxnsBegin(); i != RxnsEnd(); ++i) {
-            Reaction* x = *i;
-            if(x->hasSpecies(n))
-                result.push_back(x);
+        std::unordered_set<const Reaction*> seen;
+        for(Node::IncidenceIt i=n->IncidenceBegin(); i!=n->IncidenceEnd(); ++i) {
+            Reaction* r = i->first;
+            if(r->owner_.net == this && seen.insert(r).second)
+                result.push_back(r);
         }
         return result;
     }
 
+    const NetworkIncidence& Network::getIncidence() const {
+        if(incver_ != structver_) {
+            inc_.build(*this);
+            incver_ = structver_;
+        }
+        return inc_;
+    }
+
     Network::AttachedCurveList Network::getAttachedCurves(const Node* n) {
         AttachedRxnList rxns = getConnectedReactions(n);
         AttachedCurveList result;
@@ -1421,34 +2624,64 @@ namespace Graphfab {
     }
 
     int Network::getNumSubgraphs() {
-        enumerateSubgraphs();
-        return nsub_;
+        return enumerateSubgraphs();
     }
 
-    void Network::enumerateSubgraphs() {
-        nsub_ = 0;
-        loop:
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* x = *i;
-            if(!x->isSetSubgraphIndex()) {
-                propagateSubgraphIndex(x, nsub_++);
-                goto loop;
-            }
+    int Network::enumerateSubgraphs() {
+        const NetworkIncidence& inc = getIncidence();
+        const uint64 n = inc.getNumNodes();
+
+        std::vector<char> exclude(n, 0);
+        bool any = false;
+        for(uint64 k=0; k<n; ++k)
+            if(_nodes[k]->excludeFromSubgraphEnum())
+                exclude[k] = any = true;
+
+        std::vector<int> label;
+        std::vector<uint64> size;
+        int nsub;
+        if(any)
+            nsub = inc.labelSubgraphs(label, size, &exclude);
+        else {
+            updateConnectedSubgraphs();
+            label = sublabel_;
+            nsub = (int)subsize_.size();
         }
-    }
 
-    void Network::propagateSubgraphIndex(Node* x, int isub) {
-        AT(!x->isSetSubgraphIndex(), "Subgraph index is already set");
-        x->setSubgraphIndex(isub);
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
-            Reaction* r = *i;
-            if(r->hasSpecies(x)) {
-                for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++i) {
-                    if (!j->first->isSetSubgraphIndex())
-                        propagateSubgraphIndex(j->first, isub);
-                }
-            }
+        for(uint64 k=0; k<n; ++k) {
+            if(label[k] < 0)
+                _nodes[k]->clearSubgraphIndex();
+            else
+                _nodes[k]->setSubgraphIndex(label[k]);
         }
+        return nsub;
+    }
+
+    void Network::updateConnectedSubgraphs() const {
+        if(subver_ == structver_)
+            return;
+        getIncidence().labelSubgraphs(sublabel_, subsize_);
+        subver_ = structver_;
+    }
+
+    int Network::getNumConnectedSubgraphs() const {
+        updateConnectedSubgraphs();
+        return (int)subsize_.size();
+    }
+
+    uint64 Network::getConnectedSubgraphSize(int isub) const {
+        updateConnectedSubgraphs();
+        if(isub < 0 || isub >= (int)subsize_.size())
+            SBNW_THROW(InvalidParameterException, "No such subgraph", "Network::getConnectedSubgraphSize");
+        return subsize_[isub];
+    }
+
+    int Network::getConnectedSubgraph(const Node* n) const {
+        updateConnectedSubgraphs();
+        uint64 k;
+        if(!getIncidence().findNode(n, k))
+            return -1;
+        return sublabel_[k];
     }
 
     void Network::clearSubgraphInfo() {
@@ -1466,33 +2699,49 @@ namespace Graphfab {
     }
     
     Reaction* Network::findReactionById(const std::string& id) {
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
-            Reaction* r = *i;
-            if(r->getId() == id)
-                return r;
-        }
-        //not found
-        return NULL;
+        return rxnids_.find(id, _rxn);
     }
     
     Compartment* Network::findCompById(const std::string& id) {
-        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
-            Compartment* c = *i;
-            if(c->getId() == id)
-                return c;
-        }
-        //not found
-        return NULL;
+        return compids_.find(id, _comp);
     }
     
     Compartment* Network::findCompByGlyph(const std::string& gly) {
-        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
-            Compartment* c = *i;
-            if(c->getGlyph() == gly)
-                return c;
+        return compglyphs_.find(gly, _comp);
+    }
+
+    void Network::eltIdChanged(NetworkElement* e, const std::string& before) {
+        switch(e->getType()) {
+            case NET_ELT_TYPE_SPEC:
+                nodeids_.rekey((Node*)e, before);
+                if(before != ((Node*)e)->getId()) {
+                    aliasgroups_.remove((Node*)e, before);
+                    aliasgroups_.add((Node*)e);
+                }
+                releaseGeneratedId(before);
+                break;
+            case NET_ELT_TYPE_RXN:
+                rxnids_.rekey((Reaction*)e, before);
+                break;
+            case NET_ELT_TYPE_COMP:
+                compids_.rekey((Compartment*)e, before);
+                break;
+            default:
+                SBNW_THROW(InvalidParameterException, "Unrecognized element type", "Network::eltIdChanged");
+        }
+    }
+
+    void Network::eltGlyphChanged(NetworkElement* e, const std::string& before) {
+        switch(e->getType()) {
+            case NET_ELT_TYPE_SPEC:
+                nodeglyphs_.rekey((Node*)e, before);
+                break;
+            case NET_ELT_TYPE_COMP:
+                compglyphs_.rekey((Compartment*)e, before);
+                break;
+            default:
+                SBNW_THROW(InvalidParameterException, "Element type has no glyph", "Network::eltGlyphChanged");
         }
-        //not found
-        return NULL;
     }
     
     void Network::resetUsageInfo() {
@@ -1506,23 +2755,265 @@ namespace Graphfab {
         AN(rxn);
         _rxn.push_back(rxn);
         addElt(rxn);
+        {
+            const Point* before = &rxn->_p();
+            geom_.attach(rxn, rxn->geo_, NET_ELT_TYPE_RXN);
+            rxn->moveCurveAnchors(before);
+        }
+        rxn->owner_.net = this;
+        rxn->bindView(&viewtf_);
+        rxn->bindSymbols(&symbols_);
+        rxnids_.add(rxn);
+        for(Reaction::NodeIt i=rxn->NodesBegin(); i!=rxn->NodesEnd(); ++i)
+            i->first->inc_.attach(rxn, i->second);
+        structureChanged();
+        if(journal_.isRecording())
+            journal_.recordReaction(rxn, true);
     }
     
     void Network::removeReaction(Reaction* r) {
         AN(r, "No reaction to remove");
+        if(journal_.isRecording() && containsReaction(r))
+            journal_.recordReaction(r, false);
         // remove from element container
         removeElt(r);
         for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
             Reaction* x = *i;
             if(x == r) {
                 _rxn.erase(i);
-                std::cout << "Removed reaction " << r << "\n";
+                rxnids_.remove(r, r->getId());
+                {
+                    const Point* before = &r->_p();
+                    geom_.detach(r->geo_);
+                    r->moveCurveAnchors(before);
+                }
+                r->owner_.net = NULL;
+                r->bindView(NULL);
+                r->bindSymbols(NULL);
+                for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j)
+                    j->first->inc_.detachAll(r);
+                structureChanged();
                 return;
             }
         }
         SBNW_THROW(InvalidParameterException, "No such reaction", "Network::removeReaction");
     }
     
+    void Network::addCompartment(Compartment* c) {
+        _comp.push_back(c);
+        addElt(c);
+        geom_.attach(c, c->geo_, NET_ELT_TYPE_COMP);
+        c->owner_.net = this;
+        c->view_.bind(&viewtf_);
+        c->bindSymbols(&symbols_);
+        compids_.add(c);
+        compglyphs_.add(c);
+    }
+
+    void Network::removeCompartment(Compartment* c) {
+        AN(c, "No compartment to remove");
+        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
+            if(*i == c) {
+                _comp.erase(i);
+                removeElt(c);
+                compids_.remove(c, c->getId());
+                compglyphs_.remove(c, c->getGlyph());
+                geom_.detach(c->geo_);
+                // contents no longer belong to any compartment
+                for(EltIt j=c->EltsBegin(); j!=c->EltsEnd(); ++j)
+                    if((*j)->getType() == NET_ELT_TYPE_SPEC && static_cast<Node*>(*j)->_comp == c)
+                        static_cast<Node*>(*j)->_comp = NULL;
+                c->owner_.net = NULL;
+                c->view_.bind(NULL);
+                c->bindSymbols(NULL);
+                return;
+            }
+        }
+        SBNW_THROW(InvalidParameterException, "No such compartment", "Network::removeCompartment");
+    }
+    
+    Network* Network::clone() const {
+        Network* net = new Network();
+        // the network's own extents, transforms & ids live in the compartment base
+        static_cast<Compartment&>(*net) = *this;
+        net->_elt.clear();
+        net->eltpos_.clear();
+        net->layoutspecified_ = layoutspecified_;
+        net->viewtf_ = viewtf_;
+
+        ElementArena* arena = net->getArena();
+        ElementRemap m(geom_);
+
+        // copy the elements
+        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
+            const NetworkElement* e = *i;
+            NetworkElement* x = NULL;
+            switch(e->getType()) {
+                case NET_ELT_TYPE_SPEC:
+                    x = new (arena) Node(*static_cast<const Node*>(e));
+                    break;
+                case NET_ELT_TYPE_RXN:
+                    x = new (arena) Graphfab::Reaction(*static_cast<const Graphfab::Reaction*>(e));
+                    break;
+                case NET_ELT_TYPE_COMP:
+                    x = new (arena) Graphfab::Compartment(*static_cast<const Graphfab::Compartment*>(e));
+                    break;
+                default:
+                    SBNW_THROW(InvalidParameterException, "Unknown element type", "Network::clone");
+            }
+            m.set(e, x);
+        }
+
+        // point the references between elements at the copies
+        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
+            NetworkElement* x = m(*i);
+            switch(x->getType()) {
+                case NET_ELT_TYPE_SPEC: {
+                    Node* n = static_cast<Node*>(x);
+                    n->_comp = static_cast<Graphfab::Compartment*>(m(n->_comp));
+                    break;
+                }
+                case NET_ELT_TYPE_RXN:
+                    static_cast<Graphfab::Reaction*>(x)->remapCopy(m, arena);
+                    break;
+                case NET_ELT_TYPE_COMP:
+                    static_cast<Graphfab::Compartment*>(x)->remapCopy(m);
+                    break;
+            }
+        }
+
+        // add in the original order, which rebuilds the lookup tables & incidence
+        for(ConstNodeIt i=NodesBegin(); i!=NodesEnd(); ++i)
+            net->addNode(static_cast<Node*>(m(*i)));
+        for(ConstRxnIt i=RxnsBegin(); i!=RxnsEnd(); ++i)
+            net->addReaction(static_cast<Graphfab::Reaction*>(m(*i)));
+        for(ConstCompIt i=CompsBegin(); i!=CompsEnd(); ++i)
+            net->addCompartment(static_cast<Graphfab::Compartment*>(m(*i)));
+        // removals reorder the element container independently of the above
+        for(uint64 k=0; k<_elt.size(); ++k)
+            net->_elt[k] = m(_elt[k]);
+        net->reindexElts();
+
+        // the centroids have moved into the new store
+        for(RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i)
+            (*i)->remapCurveAnchors(m);
+
+        net->idnext_ = idnext_;
+        net->idfree_ = idfree_;
+
+        return net;
+    }
+
+    void Network::build(uint64 nspec, const char* const* specids, const int64* speccomp,
+                        uint64 ncomp, const char* const* compids,
+                        uint64 nrxn, const char* const* rxnids,
+                        uint64 nref, const uint64* refrxn, const uint64* refspec, const RxnRoleType* refrole) {
+        if(!_elt.empty())
+            SBNW_THROW(InvalidParameterException, "Network is not empty", "Network::build");
+
+        // validate everything before the network is touched
+        {
+            std::unordered_set<std::string> seen;
+            seen.reserve(std::max(std::max(nspec, ncomp), nrxn));
+            for(uint64 k=0; k<ncomp; ++k) {
+                if(!compids[k])
+                    SBNW_THROW(InvalidParameterException, "Missing compartment id", "Network::build");
+                if(!seen.insert(compids[k]).second)
+                    SBNW_THROW(InvalidParameterException, std::string("Duplicate compartment id ") + compids[k], "Network::build");
+            }
+            seen.clear();
+            for(uint64 k=0; k<nspec; ++k) {
+                if(!specids[k])
+                    SBNW_THROW(InvalidParameterException, "Missing species id", "Network::build");
+                if(!seen.insert(specids[k]).second)
+                    SBNW_THROW(InvalidParameterException, std::string("Duplicate species id ") + specids[k], "Network::build");
+                if(speccomp && (speccomp[k] < -1 || speccomp[k] >= (int64)ncomp))
+                    SBNW_THROW(InvalidParameterException, std::string("No such compartment for species ") + specids[k], "Network::build");
+            }
+            seen.clear();
+            for(uint64 k=0; k<nrxn; ++k) {
+                if(!rxnids[k])
+                    SBNW_THROW(InvalidParameterException, "Missing reaction id", "Network::build");
+                if(!seen.insert(rxnids[k]).second)
+                    SBNW_THROW(InvalidParameterException, std::string("Duplicate reaction id ") + rxnids[k], "Network::build");
+            }
+            for(uint64 k=0; k<nref; ++k) {
+                if(refrxn[k] >= nrxn || refspec[k] >= nspec) {
+                    std::stringstream ss;
+                    ss << "Species reference " << k << " out of range";
+                    SBNW_THROW(InvalidParameterException, ss.str(), "Network::build");
+                }
+            }
+        }
+
+        ElementArena* arena = getArena();
+        reserve(ncomp, nspec, nrxn);
+
+        CompVec comps(ncomp);
+        for(uint64 k=0; k<ncomp; ++k) {
+            Graphfab::Compartment* c = new (arena) Graphfab::Compartment();
+            c->setName(compids[k]);
+            c->setId(compids[k]);
+            addCompartment(c);
+            comps[k] = c;
+        }
+
+        // the network is empty, so the indices handed out one at a time would be 0,1,...
+        for(uint64 k=0; k<nspec; ++k) {
+            Node* n = new (arena) Node();
+            n->setName(specids[k]);
+            n->setId(specids[k]);
+            n->numUses() = 1;
+            n->setAlias(false);
+            if(speccomp && speccomp[k] >= 0) {
+                comps[speccomp[k]]->addElt(n);
+                n->_comp = comps[speccomp[k]];
+            }
+            n->set_i(k);
+            addNode(n);
+        }
+
+        // bucket the species references by reaction, keeping their order
+        std::vector<uint64> off(nrxn+1, 0);
+        for(uint64 k=0; k<nref; ++k)
+            ++off[refrxn[k]+1];
+        for(uint64 j=0; j<nrxn; ++j)
+            off[j+1] += off[j];
+        std::vector<uint64> refs(nref);
+        {
+            std::vector<uint64> fill(off.begin(), off.end()-1);
+            for(uint64 k=0; k<nref; ++k)
+                refs[fill[refrxn[k]]++] = k;
+        }
+
+        for(uint64 j=0; j<nrxn; ++j) {
+            Graphfab::Reaction* r = new (arena) Graphfab::Reaction();
+            r->setName(rxnids[j]);
+            r->setId(rxnids[j]);
+            addReaction(r);
+            for(uint64 q=off[j]; q<off[j+1]; ++q)
+                r->addSpeciesRef(_nodes[refspec[refs[q]]], refrole[refs[q]]);
+            if(off[j+1] > off[j])
+                r->rebuildCurves();
+        }
+    }
+
+    void Network::reserve(uint64 ncomp, uint64 nspec, uint64 nrxn) {
+        _comp.reserve(ncomp);
+        _nodes.reserve(nspec);
+        _rxn.reserve(nrxn);
+        reserveElts(ncomp + nspec + nrxn);
+        geom_.reserve(ncomp + nspec + nrxn);
+        symbols_.reserve(ncomp + nspec + nrxn + 1);
+        nodeids_.reserve(nspec);
+        nodeglyphs_.reserve(nspec);
+        aliasgroups_.reserve(nspec);
+        rxnids_.reserve(nrxn);
+        compids_.reserve(ncomp);
+        compglyphs_.reserve(ncomp);
+        idxuse_.reserve(nspec);
+    }
+
     void Network::elideEmptyComps() {
         // replace in elt vec
         EltVec w;
@@ -1536,6 +3027,7 @@ namespace Graphfab {
                 w.push_back(e);
         }
         _elt.swap(w);
+        reindexElts();
         
         // replace in comp vec & delete empty ones
         CompVec v;
@@ -1547,6 +3039,13 @@ namespace Graphfab {
                 delete c;
         }
         _comp.swap(v);
+
+        compids_.clear();
+        compglyphs_.clear();
+        for(CompIt i=CompsBegin(); i!=CompsEnd(); ++i) {
+            compids_.add(*i);
+            compglyphs_.add(*i);
+        }
     }
     
     Compartment* Network::findContainingCompartment(const NetworkElement* e) {
@@ -1559,36 +3058,12 @@ namespace Graphfab {
     }
 
     uint64 Network::getNumUniqueNodes() const {
-        uint64 k = 0, a = 1;
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            const Node* x = *i;
-            if (!x->isAlias()) {
-                ++k;
-                a = 1;
-            } else {
-                k += a;
-                a = 0;
-            }
-        }
-        return k;
+        return aliasgroups_.getNumGroups();
     }
     
     Box Network::getBoundingBox() const {
         Box b;
-        {
-            ConstEltIt i=EltsBegin();
-            if(i == EltsEnd())
-                return b;
-            NetworkElement* e = *i;
-            b = e->getBoundingBox();
-        }
-//         std::cerr << "Network initial bounding box: " << b << "\n";
-        for(ConstEltIt i=EltsBegin()+1; i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            b.expandx(e->getBoundingBox());
-//             std::cerr << "  Expand by: " << e->getBoundingBox() << "\n";
-//             std::cerr << "  new bounding box: " << b << "\n";
-        }
+        geom_.boundingBox(b);
 //         std::cerr << "Network bounding box: " << b << "\n";
         return b;
     }
@@ -1607,20 +3082,6 @@ namespace Graphfab {
         }
     }
     
-    void Network::setTransform(const Affine2d& t, bool recurse) {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->setTransform(t, recurse);
-        }
-    }
-    
-    void Network::setInverseTransform(const Affine2d& it, bool recurse) {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->setInverseTransform(it, recurse);
-        }
-    }
-
     void Network::applyDisplacement(const Point& d) {
         for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
             NetworkElement* e = *i;
@@ -1629,16 +3090,18 @@ namespace Graphfab {
     }
     
     void Network::resetActivity() {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->resetActivity();
+        geom_.resetVelocities();
+        for(CompIt i=CompsBegin(); i!=CompsEnd(); ++i) {
+            Compartment* c = *i;
+            c->resetActivity();
         }
     }
 
     void Network::updatePositions(const Real scale) {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->doMotion(scale);
+        geom_.advance(scale);
+        for(CompIt i=CompsBegin(); i!=CompsEnd(); ++i) {
+            Compartment* c = *i;
+            c->doMotion(scale);
         }
     }
     
@@ -1657,27 +3120,20 @@ namespace Graphfab {
     }
     
     void Network::updateExtents() {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->recalcExtents();
-        }
+        geom_.recalcExtents();
     }
     
     void Network::capDeltas(const Real cap) {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->capDelta2(cap*cap);
+        geom_.capVelocities(cap*cap);
+        for(CompIt i=CompsBegin(); i!=CompsEnd(); ++i) {
+            Compartment* c = *i;
+            c->capDelta2(cap*cap);
         }
     }
     
     Point Network::pmean() const {
         Point m(0.,0.);
-        uint64 c=0;
-        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            m = m + e->getCentroid();
-            ++c;
-        }
+        uint64 c = geom_.sumCentroids(m);
         m = m * (1./c);
         return m;
     }
@@ -1687,21 +3143,9 @@ namespace Graphfab {
     }
     
     Box Network::getExtents() const {
-        if(EltsBegin() == EltsEnd()) return Box();
-        Box m((*EltsBegin())->getExtents());
-        
-        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            if(e->getMinX() < m.getMinX())
-                m.setMinX(e->getMinX());
-            if(e->getMinY() < m.getMinY())
-                m.setMinY(e->getMinY());
-            if(e->getMaxX() > m.getMaxX())
-                m.setMaxX(e->getMaxX());
-            if(e->getMaxY() > m.getMaxY())
-                m.setMaxY(e->getMaxY());
-        }
-        
+        Box m;
+        if(!geom_.boundingBox(m))
+            return Box();
         return m;
     }
     
@@ -1716,13 +3160,8 @@ namespace Graphfab {
     
     Point Network::pvariance() const {
         Point m(pmean());
-        Point d(0.,0.);
-        uint64 c=0;
-        for(ConstEltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            d = d + Point(e->getCentroid() - m).squareTerms();
-            ++c;
-        }
+        Point d(geom_.sumSquaredDeviations(m));
+        uint64 c = _elt.size();
         d = d.sqrtTerms() * (1./c);
         return d;
     }
@@ -1757,16 +3196,36 @@ namespace Graphfab {
     }
     
     void Network::rebuildCurves() {
+        // curves come from the network arena, so restructure serially
         for(RxnIt i=RxnsBegin(); i!=RxnsEnd(); ++i) {
             Reaction* r = *i;
-            r->rebuildCurves();
+            r->syncCurves();
         }
+        recalcCurveCPs();
     }
 
     void Network::recalcCurveCPs() {
+        const long n = (long)_rxn.size();
+#if SBNW_USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 64) if(n > 256)
+#endif
+        for(long k=0; k<n; ++k)
+            _rxn[k]->recalcCurveCPs();
+    }
+
+    void Network::refreshCurves() {
         for(RxnIt i=RxnsBegin(); i!=RxnsEnd(); ++i) {
             Reaction* r = *i;
-            r->recalcCurveCPs();
+            r->refreshCurveStructure();
+        }
+        const long n = (long)_rxn.size();
+#if SBNW_USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 64) if(n > 256)
+#endif
+        for(long k=0; k<n; ++k) {
+            Reaction* r = _rxn[k];
+            if(r->curveInputsChanged())
+                r->recalcCurveCPs();
         }
     }
     
@@ -1799,350 +3258,29 @@ namespace Graphfab {
     //--GLOBAL--
 
     Network* networkFromLayout(const Layout& lay, const Model& mod) {
-        Network* net= networkFromModel(mod);
-        
-        // used to compute aliases
-        net->resetUsageInfo();
-        
-        //add additional information from layout
-        // for compartments
-        for(int i=0; i<lay.getNumCompartmentGlyphs(); ++i) {
-            const CompartmentGlyph* cg = lay.getCompartmentGlyph(i);
-            
-            Graphfab::Compartment* c = net->findCompById(cg->getCompartmentId());
-            
-            c->setGlyph(cg->getId());
-            
-            const BoundingBox* bbox = cg->getBoundingBox();
-            
-            c->setRestExtents(Box(Point(bbox->x(), bbox->y()), Point(bbox->x()+bbox->width(), bbox->y()+bbox->height())));
-        }
-
-        // place elements inside parent compartments
-        for(Network::NodeIt z=net->NodesBegin(); z!=net->NodesEnd(); ++z) {
-          Node* n = *z;
-          Compartment* c = net->findContainingCompartment(n);
-          if (c)
-            n->setCentroid(c->getCentroid());
-        }
-        for(Network::RxnIt z=net->RxnsBegin(); z!=net->RxnsEnd(); ++z) {
-          Reaction* r = *z;
-          Compartment* c = net->findContainingCompartment(r);
-          if (c)
-            r->setCentroid(c->getCentroid());
-        }
-        
-        // for nodes
-        for(int i=0; i<lay.getNumSpeciesGlyphs(); ++i) {
-            const SpeciesGlyph* sg = lay.getSpeciesGlyph(i);
-            
-            Node* n = net->findNodeById(sg->getSpeciesId());
-            AN(n, "No such node exists");
-            
-//             std::cerr << "Species glyph: " << sg->getSpeciesId() << "(" << sg->getId() << ")\n";
-            
-            //increment usage counter (used to find aliases)
-            if(n->numUses() == 0) {
-                n->numUses()++;
-                n->setGlyph(sg->getId());
-            } else {
-                //create an alias node
-                n->setAlias(true);
-                n = new Node(*n);
-                n->setGlyph(sg->getId());
-                n->_ldeg = 0;
-                //add alias node to the network
-                net->addNode(n);
-            }
-            
-            const BoundingBox* bb = sg->getBoundingBox();
-            
-            n->setCentroid(Point(bb->x() + bb->width()/2., bb->y() + bb->height()/2.));
-            n->setWidth(bb->width());
-            n->setHeight(bb->height());
-        }
-        
-        // for reactions
-        for(int i=0; i<lay.getNumReactionGlyphs(); ++i) {
-            const ReactionGlyph* rg = lay.getReactionGlyph(i);
-//             std::cerr << "Read ReactionGlyph " << rg->getId() << "\n";
-            
-            Reaction* r = net->findReactionById(rg->getReactionId());
-            AN(r, "No such reaction");
-            
-            for(int i_spc=0; i_spc<rg->getNumSpeciesReferenceGlyphs(); ++i_spc) {
-                const SpeciesReferenceGlyph* srg = rg->getSpeciesReferenceGlyph(i_spc);
-
-                //get the alias
-//                 std::cerr << "Searching for glyph " << srg->getSpeciesGlyphId() << "\n";
-                Node* alias = net->findNodeByGlyph(srg->getSpeciesGlyphId());
-                AN(alias, "Unable to find alias node");
-
-                //fix the reference to point to the alias
-//                 r->substituteSpeciesById(srg->getSpeciesReferenceId(), alias);
-//                 std::cerr << srg->getId() << ": ";
-//                 if (!r->hasSpecies(alias))
-//                   std::cerr << "Not present\n";
-//                 else
-//                   std::cerr << "Is present\n";
-                RxnRoleType role = SBMLRole2GraphfabRole(srg->getRole());
-//                 if (isRoleActive(role))
-                    r->substituteSpeciesByIdwRole(srg->getSpeciesReferenceId(), alias, role);
-//                 else
-//                     r->addSpeciesRef(alias, role);
-
-//                 for (Reaction::CurveIt ci = r->CurvesBegin(); ci != r->CurvesEnd(); ++ci) {
-//                   RxnBezier* c = *ci;
-//                   std::cerr << "  ci\n";
-//                   if (c->includes(alias)) {
-//                     std::cerr << "  includes node\n";
-//                   }
-//                 }
-            }
-
-            // delete preexisting curves
-            r->deleteCurves();
-
-            ::Curve const* curve = rg->getCurve();
-            ::BoundingBox const* sbml_bb = rg->getBoundingBox();
-            
-            // calculate the centroid
-//             if (!curve)
-//               std::cerr << rg->getId() << ": no curve\n";
-//             else
-//               std::cerr << rg->getId() << ": have curve, n segs = " << curve->getNumCurveSegments() << "\n";
-
-            // first try bounding box (the proper method, which none of the models use)
-            if (sbml_bb &&
-             !(sbml_bb->getPosition()->x() == 0 && sbml_bb->getPosition()->y() == 0 &&
-             sbml_bb->getDimensions() && sbml_bb->getDimensions()->getWidth() == 0 && sbml_bb->getDimensions()->getHeight() == 0) ) {
-
-                Real x_offset = 0, y_offset = 0;
-                if (sbml_bb->getDimensions())
-                  x_offset = sbml_bb->getDimensions()->getWidth() * 0.5, y_offset = sbml_bb->getDimensions()->getHeight() * 0.5;
-                r->setCentroid(sbml_bb->getPosition()->x(), sbml_bb->getPosition()->y());
-            } else if (curve && curve->getNumCurveSegments() > 0) {
-                // next try using preexisting centroid coords via reaction curve
-//                 std::cerr << "manual centroid\n";
-                r->setCentroid(curve->getCurveSegment(0)->getEnd()->x(), curve->getCurveSegment(0)->getEnd()->y());
-
-                for (unsigned int j = 0; j < rg->getNumSpeciesReferenceGlyphs(); ++j) {
-                    RxnBezier* c = r->addCurve(SBMLRole2GraphfabRole(rg->getSpeciesReferenceGlyph(j)->getRole()));
-//                     std::cerr << "  Created curve with role " << rxnRoleToString(SBMLRole2GraphfabRole(rg->getSpeciesReferenceGlyph(j)->getRole())) << "\n";
-                    Node* target = net->findNodeByGlyph(rg->getSpeciesReferenceGlyph(j)->getSpeciesGlyphId());
-
-                    if (c->getRole() == RXN_CURVE_PRODUCT) {
-                        c->as = &r->_p;
-                        c->ae = &target->_p;
-                        c->ne = target;
-                    } else {
-                        c->as = &target->_p;
-                        c->ns = target;
-                        c->ae = &r->_p;
-                    }
-                    c->owne = 0;
-                    c->owns = 0;
-                }
-
-                r->recalcCurveCPs();
-
-                r->clearDirtyFlag();
-
-                // Try to fill in the CP data from layout info
-                for (unsigned int j = 0; j < rg->getNumSpeciesReferenceGlyphs(); ++j) {
-                  SpeciesReferenceGlyph const* srg = rg->getSpeciesReferenceGlyph(j);
-                  RxnBezier* c = r->getCurve(j);
-                  // use the first curve segment
-                  ::Curve const* sr_curve = srg->getCurve();
-                  ::LineSegment const* sr_line = sr_curve->getCurveSegment(0);
-                  ::CubicBezier const* sr_bez = dynamic_cast< ::CubicBezier const* >(sr_line);
-                  if (sr_bez) {
-                    //std::cerr << "sr_bez\n";
-                    c->s.x = sr_bez->getStart()->x();
-                    c->s.y = sr_bez->getStart()->y();
-                    c->e.x = sr_bez->getEnd()->x();
-                    c->e.y = sr_bez->getEnd()->y();
-
-                    c->c1.x = sr_bez->getBasePoint1()->x();
-                    c->c1.y = sr_bez->getBasePoint1()->y();
-                    c->c2.x = sr_bez->getBasePoint2()->x();
-                    c->c2.y = sr_bez->getBasePoint2()->y();
-                  } else if (sr_line) {
-                    //std::cerr << "no sr_bez\n";
-                    c->s.x = sr_line->getStart()->x();
-                    c->s.y = sr_line->getStart()->y();
-                    c->e.x = sr_line->getEnd()->x();
-                    c->e.y = sr_line->getEnd()->y();
-
-                    c->c1.x = sr_line->getStart()->x();
-                    c->c1.y = sr_line->getStart()->y();
-                    c->c2.x = sr_line->getEnd()->x();
-                    c->c2.y = sr_line->getEnd()->y();
-                    //  CPs should be separated from endpoints for endcap orientation
-                    Point ctmp = c->c1;
-                    c->c1 = 0.9*c->c1 + 0.1*c->c2;
-                    c->c2 = 0.9*c->c2 + 0.1*ctmp;
-                  }
-                }
-            } else {
-                // poor results
-                if (false) {
-                  // try to get the centroid from the reaction curves
-                  for(int i_spc=0; i_spc<rg->getNumSpeciesReferenceGlyphs(); ++i_spc) {
-                      // spec ref
-                      const SpeciesReferenceGlyph* srg = rg->getSpeciesReferenceGlyph(i_spc);
-                      // role
-                      RxnRoleType role = SBMLRole2GraphfabRole(srg->getRole());
-                      // curve
-                      ::Curve const* crv = srg->getCurve();
-                      if (!crv)
-                        break;
-
-                      for (int i_seg=0; i_seg<crv->getNumCurveSegments(); ++i_seg) {
-                        ::LineSegment const* seg = crv->getCurveSegment(i_seg);
-                        if (role == RXN_ROLE_PRODUCT || role == RXN_ROLE_SIDEPRODUCT)
-                          r->setCentroid(seg->getStart()->x(), seg->getStart()->y());
-                        else
-                          r->setCentroid(seg->getEnd()->x(), seg->getEnd()->y());
-                        goto skip_recalc_centroid;
-                      }
-                  }
-                }
+        ImportData d;
+        getImportData(mod, &lay, d);
+        return networkFromImport(d);
+    }
 
-                // if all else fails average node coords
-                r->forceRecalcCentroid();
+    bool isVisualCompartment(const ::Compartment& comp) {
+        return isVisualCompartment(comp.getId(), comp.isSetSBOTerm() ? comp.getSBOTerm() : -1);
+    }
 
-                skip_recalc_centroid:;
-            }
+    bool isVisualCompartment(const std::string& id, int sbo) {
+        // elide "default" compartments based on SBO
+        if(sbo == 410)
+            return false;
 
-//             r->rebuildCurves();
-//             std::cerr << "Reaction centroid: " << r->getCentroid(NetworkElement::COORD_SYSTEM_GLOBAL) << "\n";
-        }
-        
-        net->setLayoutSpecified(true);
-        
-        return net;
+        // assume a compartment with the id "default" or "compartment" represents
+        // a default, non-visual compartment, so discard it from the model
+        return id != "default" && id != "compartment" && id != "graphfab_default_compartment" && (!haveDefaultCompartmentId() || getDefaultCompartmentId() !=  id);
     }
 
     Network* networkFromModel(const Model& mod) {
-        Network* net = new Network();
-
-        if( mod.isSetId() )
-            net->setId(mod.getId());
-        
-        // add compartments
-        for(int i=0; i<mod.getNumCompartments(); ++i) {
-            const ::Compartment* comp = mod.getCompartment(i);
-            
-            // elide "default" compartments based on SBO
-            if(comp->isSetSBOTerm() && comp->getSBOTerm() == 410) {
-                continue;
-            }
-            
-            // assume a compartment with the id "default" or "compartment" represents
-            // a default, non-visual compartment, so discard it from the model
-            if(comp->getId() != "default" && comp->getId() != "compartment" && comp->getId() != "graphfab_default_compartment" && (!haveDefaultCompartmentId() || getDefaultCompartmentId() !=  comp->getId())) {
-                Graphfab::Compartment* c = new Compartment();
-                
-                // set id
-                c->setId(comp->getId());
-                
-                // add to network
-                net->addCompartment(c);
-            }
-        }
-        
-        // add nodes
-        //printf("# floating = %d\n", floating);
-        for(int i=0; i<mod.getNumSpecies(); ++i) {
-            Node* n = new Node();
-            
-            const Species* s = mod.getSpecies(i);
-            
-            AN(s, "Failed to get species");
-            #if SAGITTARIUS_DEBUG_LEVEL >= 2
-//             std::cout << "Species: name: " << s->getName() << ", id: " << s->getId() << "\n";
-            #endif
-            
-            n->setName(s->getName());
-            n->setId(s->getId());
-            
-            //no alias info
-            n->numUses() = 1;
-            n->setAlias(false);
-            
-            // associate compartment (if one exists)
-            Graphfab::Compartment* c = net->findCompById(s->getCompartment());
-            if(c) {
-                c->addElt(n);
-                n->_comp = c;
-            }
-            
-            // set index
-            n->set_i((size_t)i);
-            
-            // add to network
-            net->addNode(n);
-        }
-        
-        // remove empty compartments
-        net->elideEmptyComps();
-        
-        // resize compartments to enclose contents
-        //NOTE: nodes do not yet have positions, can't do this
-        //net->resizeCompartments();
-        net->autosizeComps();
-        
-        // add connections
-        for(int i_rxn=0; i_rxn<mod.getNumReactions(); ++i_rxn) {
-            const ::Reaction* rxn = mod.getReaction(i_rxn);
-            Reaction* r = new Reaction();
-            
-            r->setId(rxn->getId());
-            
-            AN(rxn, "Failed to get reaction");
-
-            // associate compartment (if one exists)
-            Graphfab::Compartment* c = net->findCompById(rxn->getCompartment());
-            if(c) {
-                c->addElt(r);
-            }
-            
-            // get reactants
-            for(int i_spc=0; i_spc<rxn->getNumReactants(); ++i_spc) {
-                //get the reference
-                const SpeciesReference* spc = rxn->getReactant(i_spc);
-                Node* src = net->findNodeById(spc->getSpecies());
-                AN(src, "Invalid species reference");
-                r->addSpeciesRef(src, RXN_ROLE_SUBSTRATE);
-            }
-            
-            // get products
-            for(int i_spc=0; i_spc<rxn->getNumProducts(); ++i_spc) {
-                //get the reference
-                const SpeciesReference* spc = rxn->getProduct(i_spc);
-                Node* src = net->findNodeById(spc->getSpecies());
-                AN(src, "Invalid species reference");
-                r->addSpeciesRef(src, RXN_ROLE_PRODUCT);
-            }
-            
-            // get modifiers
-            for(int i_spc=0; i_spc<rxn->getNumModifiers(); ++i_spc) {
-                //get the reference
-                const ModifierSpeciesReference* spc = rxn->getModifier(i_spc);
-                Node* src = net->findNodeById(spc->getSpecies());
-                AN(src, "Invalid species reference");
-                r->addSpeciesRef(src, RXN_ROLE_MODIFIER);
-            }
-            
-            net->addReaction(r);
-        }
-        
-        #if SAGITTARIUS_DEBUG_LEVEL >= 3
-        net->dump(std::cout, 0);
-        #endif
-        
-        return net;
+        ImportData d;
+        getImportData(mod, NULL, d);
+        return networkFromImport(d);
     }
 
 }
@@ -43,6 +43,7 @@
 #include "graphfab/layout/curve.h"
 #include "graphfab/layout/box.h"
 #include "graphfab/math/transform.h"
+#include "graphfab/network/arena.h"
 
 //-- C++ code --
 #ifdef __cplusplus
@@ -56,6 +57,11 @@
 #include <iostream>
 #include <typeinfo>
 #include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
+#include <deque>
+#include <functional>
 
 using namespace libsbml;
 
@@ -68,6 +74,363 @@ namespace Graphfab {
     } NetworkEltType;
     
     std::string eltTypeToStr(const NetworkEltType t);
+
+    class LayoutWorkspace;
+    class Network;
+    class EditJournal;
+
+    /** @brief Back-reference from an element to the network that owns it
+     *  @details Not carried over when an element is copied, so a copy
+     *  starts out unowned until it is added to a network.
+     */
+    struct NetworkOwnerRef {
+        NetworkOwnerRef() : net(NULL) {}
+        NetworkOwnerRef(const NetworkOwnerRef&) : net(NULL) {}
+        NetworkOwnerRef& operator=(const NetworkOwnerRef&) { return *this; }
+
+        Network* net;
+    };
+
+    /** @brief Interned strings of a network
+     *  @details Holds one copy of each distinct id, name or glyph used by the
+     *  elements of a network. Copies are never dropped, so pointers returned
+     *  by @ref intern stay valid for the lifetime of the table.
+     */
+    class SymbolTable {
+        public:
+            SymbolTable() {}
+
+            /// The copy of @a s in the table (added if missing)
+            const std::string* intern(const std::string& s) { return &*strs_.insert(s).first; }
+
+            /// The copy of @a s in the table, or NULL if there is none
+            const std::string* find(const std::string& s) const {
+                std::unordered_set<std::string>::const_iterator i = strs_.find(s);
+                return i != strs_.end() ? &*i : NULL;
+            }
+
+            /// Number of distinct strings
+            uint64 size() const { return strs_.size(); }
+
+            /// Make room for @a n strings
+            void reserve(uint64 n) { strs_.reserve(n); }
+
+        protected:
+            // node-based, so entries do not move when the set grows
+            std::unordered_set<std::string> strs_;
+
+        private:
+            SymbolTable(const SymbolTable&);
+            SymbolTable& operator=(const SymbolTable&);
+    };
+
+    /** @brief Id, name or glyph of an element
+     *  @details Refers to the copy in the @ref SymbolTable of the owning network,
+     *  so elements with equal strings share storage and comparing two symbols of
+     *  the same network is a pointer comparison. While the element is not part of
+     *  a network the symbol holds a copy of its own. Copies carry the value over
+     *  but start out unbound, like @ref NetworkOwnerRef.
+     */
+    class Symbol {
+        public:
+            Symbol() : s_(&none()), t_(NULL) {}
+
+            Symbol(const Symbol& other) : s_(&none()), t_(NULL) { assign(other.str()); }
+
+            Symbol& operator=(const Symbol& other) {
+                if(this != &other)
+                    assign(other.str());
+                return *this;
+            }
+
+            Symbol& operator=(const std::string& v) { assign(v); return *this; }
+
+            ~Symbol() { release(); }
+
+            const std::string& str() const { return *s_; }
+
+            /// Set the value (interned in the table the symbol is bound to, if any)
+            void assign(const std::string& v);
+
+            /// Move the value into @a t, or into storage of its own if @a t is NULL
+            void bind(SymbolTable* t);
+
+            /** @brief Refer to @a v in @a t if it is there, otherwise hold a copy
+             *  @details Lookup keys built this way do not add to the table.
+             */
+            void find(SymbolTable* t, const std::string& v);
+
+            SymbolTable* getTable() const { return t_; }
+
+            bool operator==(const Symbol& other) const {
+                if(s_ == other.s_)
+                    return true;
+                if(t_ && t_ == other.t_)
+                    return false;
+                return *s_ == *other.s_;
+            }
+
+            bool operator!=(const Symbol& other) const { return !(*this == other); }
+
+        protected:
+            static const std::string& none();
+
+            /// Free the value if the symbol holds a copy of its own
+            void release();
+
+            const std::string* s_;
+            SymbolTable* t_;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const Symbol& s) {
+        return os << s.str();
+    }
+
+    class NetworkElement;
+    class GeometryStore;
+
+    /** @brief Geometric state of one element
+     *  @details A slot in the @ref GeometryStore of the owning network, or in
+     *  the shared store for detached elements (@ref GeometryStore::detached)
+     *  while the element is not part of a network. Copies carry the values
+     *  over but start out detached.
+     */
+    class ElementGeometry {
+        public:
+            ElementGeometry();
+
+            ElementGeometry(const ElementGeometry& other);
+
+            ElementGeometry& operator=(const ElementGeometry& other);
+
+            ~ElementGeometry();
+
+            Point& p();
+            const Point& p() const;
+
+            Point& v();
+            const Point& v() const;
+
+            Box& ext();
+            const Box& ext() const;
+
+            Real& r();
+            Real r() const;
+
+            int& lock();
+            int lock() const;
+
+        protected:
+            GeometryStore* store_;
+            uint64 slot_;
+
+            friend class GeometryStore;
+    };
+
+    /** @brief Chunked array whose elements never move
+     *  @details Grows by whole chunks so references handed out earlier
+     *  (e.g. curve anchors) stay valid.
+     */
+    template <class T>
+    class GeometryColumn {
+        public:
+            enum { CHUNK_BITS = 10, CHUNK = 1 << CHUNK_BITS };
+
+            GeometryColumn() {}
+
+            ~GeometryColumn() {
+                for(typename std::vector<T*>::iterator i=chunks_.begin(); i!=chunks_.end(); ++i)
+                    delete [] *i;
+            }
+
+            T& operator[](uint64 k) { return chunks_[k >> CHUNK_BITS][k & (CHUNK-1)]; }
+            const T& operator[](uint64 k) const { return chunks_[k >> CHUNK_BITS][k & (CHUNK-1)]; }
+
+            /// Make room for at least @a n entries
+            void reserve(uint64 n) {
+                while((uint64)chunks_.size()*CHUNK < n)
+                    chunks_.push_back(new T[CHUNK]);
+            }
+
+            /// Size the chunk table for @a n entries up front, so adding chunks never moves it
+            void reserveTable(uint64 n) {
+                chunks_.reserve((n + CHUNK - 1) >> CHUNK_BITS);
+            }
+
+            T* chunk(uint64 c) { return chunks_[c]; }
+            const T* chunk(uint64 c) const { return chunks_[c]; }
+
+        protected:
+            std::vector<T*> chunks_;
+
+        private:
+            GeometryColumn(const GeometryColumn&);
+            GeometryColumn& operator=(const GeometryColumn&);
+    };
+
+    /** @brief Geometric state of all elements of a network (structure of arrays)
+     *  @details Positions, velocities, extents, radii, lock flags and type tags
+     *  of the species, reactions and compartments in a network, one slot per
+     *  element. Slots are handed out in the order elements are added and reused
+     *  after removal. The network-wide geometry passes are linear sweeps over
+     *  these arrays; compartment state beyond the shared fields stays in the
+     *  compartment objects.
+     */
+    class GeometryStore {
+        public:
+            GeometryStore() : size_(0), max_(0) {}
+
+            /** @brief Store for the geometry of elements not in any network
+             *  @details Shared by all threads: slots are handed out and returned
+             *  under a lock, and the chunk tables are sized up front for @a max_
+             *  slots so that growing never moves them while another thread uses
+             *  its own slots.
+             *  @throws std::bad_alloc (when a slot is taken) if too many elements
+             *  are detached at once
+             */
+            static GeometryStore& detached();
+
+            /// Move the geometry of @a e from the detached store into a slot of this store
+            void attach(NetworkElement* e, ElementGeometry& g, NetworkEltType type);
+
+            /// Move the geometry back into the detached store and free the slot
+            void detach(ElementGeometry& g);
+
+            /// One past the highest slot ever used
+            uint64 size() const { return size_; }
+
+            /// Make room for @a n slots
+            void reserve(uint64 n);
+
+            NetworkElement* getElt(uint64 k) { return elt_[k]; }
+            const NetworkElement* getElt(uint64 k) const { return elt_[k]; }
+
+            /// Slot of @a e; false if @a e is not in this store
+            bool findSlot(const NetworkElement* e, uint64& k) const;
+
+            /// Slot whose centroid is stored at @a p; false if @a p does not point into this store
+            bool findCentroidSlot(const Point* p, uint64& k) const;
+
+            // Sweeps (compartments are skipped where noted):
+
+            /// Zero the velocities of species and reactions
+            void resetVelocities();
+
+            /// Scale velocities of species and reactions to magnitude at most sqrt(@a cap2)
+            void capVelocities(Real cap2);
+
+            /// Move unlocked species and reactions along their velocity
+            void advance(Real scale);
+
+            /// Recompute extents and radii (all types)
+            void recalcExtents();
+
+            /// Union of the (local) extents of all elements; false if empty
+            bool boundingBox(Box& b) const;
+
+            /// Sum of the (local) centroids of all elements; returns their number
+            uint64 sumCentroids(Point& s) const;
+
+            /// Sum of squared deviations of the centroids from @a m
+            Point sumSquaredDeviations(const Point& m) const;
+
+            // Per-type rules, shared with the element classes:
+
+            static void recalcSpeciesExtents(const Point& p, Box& ext, Real& r) {
+                Point del(0.5*ext.width(), 0.5*ext.height());
+                ext = Box(p - del, p + del);
+                r = ext.maxDim()*0.5;
+            }
+
+            static void recalcReactionExtents(const Point& p, Box& ext, Real& r) {
+                r = 10.;
+                ext = Box(p - Point(r,r), p + Point(r,r));
+            }
+
+            static void recalcCompartmentExtents(Point& p, const Box& ext, Real& r) {
+                r = ext.maxDim()*0.5;
+                p = (ext.getMin() + ext.getMax())*0.5;
+            }
+
+            static Box reactionLocalExtents(const Point& p) {
+                return Box(p - Point(5, 5), p + Point(5, 5));
+            }
+
+            static void advanceElement(Point& p, const Point& v, Real scale) {
+                if (v.mag2() > 1e-6)
+                    p = p + v.normed()*scale;
+            }
+
+        protected:
+            /// Store with at most @a max slots (see @ref detached)
+            explicit GeometryStore(uint64 max);
+
+            /// Take a free slot / give it back (locked for the detached store)
+            uint64 acquire();
+            void release(uint64 k);
+
+            /// Number of chunks in use and the number of slots used in chunk @a c
+            uint64 numChunks() const;
+            uint64 chunkSize(uint64 c) const;
+
+            GeometryColumn<Point> p_, v_;
+            GeometryColumn<Box> ext_;
+            GeometryColumn<Real> r_;
+            GeometryColumn<int> lock_;
+            GeometryColumn<NetworkEltType> type_;
+            /// Element in each slot (NULL if free)
+            GeometryColumn<NetworkElement*> elt_;
+
+            uint64 size_;
+            std::vector<uint64> free_;
+            /// Slot limit, 0 for none (also marks the shared detached store)
+            uint64 max_;
+
+            friend class ElementGeometry;
+
+        private:
+            GeometryStore(const GeometryStore&);
+            GeometryStore& operator=(const GeometryStore&);
+    };
+
+    inline Point& ElementGeometry::p() { return store_->p_[slot_]; }
+    inline const Point& ElementGeometry::p() const { return store_->p_[slot_]; }
+
+    inline Point& ElementGeometry::v() { return store_->v_[slot_]; }
+    inline const Point& ElementGeometry::v() const { return store_->v_[slot_]; }
+
+    inline Box& ElementGeometry::ext() { return store_->ext_[slot_]; }
+    inline const Box& ElementGeometry::ext() const { return store_->ext_[slot_]; }
+
+    inline Real& ElementGeometry::r() { return store_->r_[slot_]; }
+    inline Real ElementGeometry::r() const { return store_->r_[slot_]; }
+
+    inline int& ElementGeometry::lock() { return store_->lock_[slot_]; }
+    inline int ElementGeometry::lock() const { return store_->lock_[slot_]; }
+
+    /** @brief Maps the elements of a network onto their copies in another
+     *  @details Flat table indexed by the geometry slot of the source element,
+     *  so each lookup is one array access. Used by @ref Network::clone to
+     *  re-point species references, compartment membership and curves.
+     */
+    class ElementRemap {
+        public:
+            ElementRemap(const GeometryStore& from)
+                : from_(from), to_(from.size(), (NetworkElement*)NULL) {}
+
+            /// Record @a copy as the image of @a e
+            void set(const NetworkElement* e, NetworkElement* copy);
+
+            /// Image of @a e (NULL for NULL); throws if @a e is not in the source network
+            NetworkElement* operator()(const NetworkElement* e) const;
+
+            /// Centroid of the image of the element whose centroid is stored at @a p (NULL if none)
+            Point* centroid(const Point* p) const;
+
+        protected:
+            const GeometryStore& from_;
+            std::vector<NetworkElement*> to_;
+    };
     
     void dumpEltType(std::ostream& os, const NetworkEltType t, uint32 ind);
     
@@ -247,7 +610,7 @@ namespace Graphfab {
     
     /** @brief An element that can be connected to other elements in the network
      */
-    class NetworkElement {
+    class NetworkElement : public ArenaAllocated {
         public:
 
             enum COORD_SYSTEM {
@@ -256,7 +619,9 @@ namespace Graphfab {
             };
             
             NetworkElement()
-                : _pset(0), _v(0,0), _deg(0), _ldeg(0), _lock(0), networkEltBytePattern_(0x1199) {}
+                : _pset(0), _deg(0), _ldeg(0), networkEltBytePattern_(0x1199) {}
+
+            virtual ~NetworkElement() {}
             
             /// Get the type
             NetworkEltType getType() const { return _type; }
@@ -298,7 +663,7 @@ namespace Graphfab {
             /// Get the centroid of the node
             virtual Point getCentroid(COORD_SYSTEM coord = COORD_SYSTEM_LOCAL) const;
             
-//             SAGITTARIUS_DEPRECATED(Point getGlobalCentroid() const) { return tf_*_p; }
+//             SAGITTARIUS_DEPRECATED(Point getGlobalCentroid() const) { return tf_*_p(); }
             
             /// Extents functions that all elements must support
             Point getMin(COORD_SYSTEM coord = COORD_SYSTEM_LOCAL) const { return getExtents(coord).getMin(); }
@@ -314,8 +679,8 @@ namespace Graphfab {
             Real getHeight() const { AT(getMaxY() >= getMinY()); return getMaxY() - getMinY(); }
             
             /// With/height derived from extents
-            Real getGlobalWidth() const { AT(getMaxX() >= getMinX()); return (getMaxX() - getMinX())*tf_.scaleFactor(); }
-            Real getGlobalHeight() const { AT(getMaxY() >= getMinY()); return (getMaxY() - getMinY())*tf_.scaleFactor(); }
+            Real getGlobalWidth() const { AT(getMaxX() >= getMinX()); return (getMaxX() - getMinX())*view_.tf().scaleFactor(); }
+            Real getGlobalHeight() const { AT(getMaxY() >= getMinY()); return (getMaxY() - getMinY())*view_.tf().scaleFactor(); }
             
             /** @brief Get bounding box
              */
@@ -324,7 +689,7 @@ namespace Graphfab {
                 case COORD_SYSTEM_LOCAL:
                   return getLocalExtents();
                 case COORD_SYSTEM_GLOBAL:
-                  return tf_*getLocalExtents();
+                  return view_.tf()*getLocalExtents();
                 default:
                   AN(0, "Unknown coord system");
                   return getLocalExtents();
@@ -334,40 +699,43 @@ namespace Graphfab {
             /** @brief Get bounding box w/o transform
              */
             virtual Box getLocalExtents() const {
-              return _ext;
+              return _ext();
             }
-//             virtual SAGITTARIUS_DEPRECATED(Box getGlobalExtents() const) { return tf_*_ext; }
+//             virtual SAGITTARIUS_DEPRECATED(Box getGlobalExtents() const) { return tf_*_ext(); }
             
             /// Set the extents of the compartment
-            void setExtents(const Box& b) { _ext = b; recalcCentroid(); }
+            void setExtents(const Box& b);
             
             Box getBoundingBox() const { return getExtents(); }
 //             Box getBoundingBox() const { return Box(); }
             
             virtual void applyTransform(const Affine2d& t) {
-                _ext = xformBox(_ext, t);
-                _p = xformPoint(_p, t);
+                _ext() = xformBox(_ext(), t);
+                _p() = xformPoint(_p(), t);
             }
 
             virtual void applyDisplacement(const Point& d) {
-                _ext.displace(d);
-                _p += d;
+                _ext().displace(d);
+                _p() += d;
             }
             
             /// Calculate the centroid based on the extents
-            void recalcCentroid() { _p = (_ext.getMin() + _ext.getMax())*0.5; }
+            void recalcCentroid() { _p() = (_ext().getMin() + _ext().getMax())*0.5; }
             
             /// Recalculate the extents
             virtual void recalcExtents() = 0;
+
+            /// Intern the id, name & glyph in @a t (or hold copies of their own if NULL)
+            virtual void bindSymbols(SymbolTable* t) = 0;
             
             /// Lock
-            void lock() { _lock = 1; }
+            void lock() { _lock() = 1; }
             
             /// Unlock
-            void unlock() { _lock = 0; }
+            void unlock() { _lock() = 0; }
 
             // Is the node locked?
-            bool isLocked() const { return _lock; }
+            bool isLocked() const { return _lock(); }
             
             NetworkEltShape getShape() const { return _shape; }
             
@@ -375,7 +743,7 @@ namespace Graphfab {
             virtual bool isContainer() const = 0;
             
             /// Get the radius (approx. for non-round)
-            Real radius() const { return _r; }
+            Real radius() const { return _r(); }
             
             /// Get the distance to another element
             Real distance(const NetworkElement& e) const;
@@ -398,16 +766,14 @@ namespace Graphfab {
             /// Dump info about forces
             virtual void dumpForces(std::ostream& os, uint32 ind) const = 0;
             
-            virtual Affine2d getTransform() const { return tf_; }
-            
-            virtual void setTransform(const Affine2d& tf, bool recurse = true) { tf_ = tf; }
+            /// View transform of the owning network (identity if not in a network)
+            Affine2d getTransform() const { return view_.tf(); }
             
-            virtual Affine2d getInverseTransform() const { return itf_; }
-            
-            virtual void setInverseTransform(const Affine2d& itf, bool recurse = true) { itf_ = itf; }
+            Affine2d getInverseTransform() const { return view_.itf(); }
             
             /// Centroid
-            Point _p;
+            Point& _p() { return geo_.p(); }
+            const Point& _p() const { return geo_.p(); }
             /// Degree
             uint64 _deg;
             /// Local degree (unique connections for each aliased copy)
@@ -416,26 +782,77 @@ namespace Graphfab {
             /// True if centroid was set externally
             int _pset;
             /// Change in centroid (computed by layout algorithm)
-            Point _v;
+            Point& _v() { return geo_.v(); }
+            const Point& _v() const { return geo_.v(); }
             /// Extents (should be updated by derived classes)
-            Box _ext;
+            Box& _ext() { return geo_.ext(); }
+            const Box& _ext() const { return geo_.ext(); }
             /// Radius
-            Real _r;
+            Real& _r() { return geo_.r(); }
+            Real _r() const { return geo_.r(); }
             /// Shape
             NetworkEltShape _shape;
             /// Type
             NetworkEltType _type;
             /// Locked?
-            int _lock;
-            /// Transform
-            Affine2d tf_;
-            /// Inverse transform
-            Affine2d itf_;
+            int& _lock() { return geo_.lock(); }
+            int _lock() const { return geo_.lock(); }
+            /// Position, velocity, extents etc. (stored in the owning network)
+            ElementGeometry geo_;
+            /// View transform (shared with the rest of the owning network)
+            ViewTransformRef view_;
             
             long networkEltBytePattern_;
+
+            /// Owning network (notified when the id or glyph changes)
+            NetworkOwnerRef owner_;
+
+            /// Journal of the owning network if it is recording edits, else NULL
+            EditJournal* getRecordingJournal() const;
+
+            // packs & restores layout state directly
+            friend class LayoutWorkspace;
+            friend class Network;
+            friend class GeometryStore;
+            friend class EditJournal;
     };
 
+    typedef enum {
+        RXN_ROLE_SUBSTRATE,
+        RXN_ROLE_PRODUCT,
+        RXN_ROLE_SIDESUBSTRATE,
+        RXN_ROLE_SIDEPRODUCT,
+        RXN_ROLE_MODIFIER,
+        RXN_ROLE_ACTIVATOR,
+        RXN_ROLE_INHIBITOR,
+    } RxnRoleType;
+
     class Network;
+    class Reaction;
+
+    /** @brief Reactions a node takes part in, one entry per species reference
+     *  @details Maintained by @ref Reaction while the reaction belongs to a
+     *  network. Not carried over when a node is copied.
+     */
+    class NodeIncidence {
+        public:
+            typedef std::pair<Reaction*, RxnRoleType> Entry;
+            typedef std::vector<Entry> EntryVec;
+
+            NodeIncidence() {}
+            NodeIncidence(const NodeIncidence&) {}
+            NodeIncidence& operator=(const NodeIncidence&) { return *this; }
+
+            void attach(Reaction* r, RxnRoleType role) { entries.push_back(Entry(r, role)); }
+
+            /// Remove one entry for @a r with @a role
+            void detach(Reaction* r, RxnRoleType role);
+
+            /// Remove all entries for @a r
+            void detachAll(Reaction* r);
+
+            EntryVec entries;
+    };
 
     /** @brief Node in a network
      */
@@ -447,9 +864,12 @@ namespace Graphfab {
                     _shape = ELT_SHAPE_RECT;
                     _comp = NULL;
                     _type = NET_ELT_TYPE_SPEC;
-                    _ext = Box(0,0,40,20);
+                    _ext() = Box(0,0,40,20);
                     bytepattern = 0xc455;
+                    _isAlias = false;
+                    i_ = 0;
                     isub_ = -1;
+                    exsub_ = false;
                 }
             
             // Model:
@@ -471,6 +891,8 @@ namespace Graphfab {
             
             /// Set the species' reaction glyph (layout element)
             void setGlyph(const std::string& id);
+
+            void bindSymbols(SymbolTable* t) { _name.bind(t); _id.bind(t); _gly.bind(t); }
             
             // Alias info:
             
@@ -486,7 +908,7 @@ namespace Graphfab {
             bool isCommonInstance(const Node* other) const;
             
             /// Specify if this node is an alias or not
-            void setAlias(bool b) { _isAlias = b; }
+            void setAlias(bool b);
 
             int alias(Network* net);
 
@@ -498,7 +920,7 @@ namespace Graphfab {
 
             void setSubgraphIndex(int v) { isub_ = v; }
 
-            bool isSetSubgraphIndex() { return isub_ < 0; }
+            bool isSetSubgraphIndex() const { return isub_ >= 0; }
 
             void clearSubgraphIndex() { isub_ = -1; }
 
@@ -507,6 +929,16 @@ namespace Graphfab {
             bool setExcludeFromSubgraphEnum() { return exsub_ = true; }
 
             void clearExcludeFromSubgraphEnum() { exsub_ = false; }
+
+            // Incidence:
+
+            typedef NodeIncidence::EntryVec::const_iterator IncidenceIt;
+
+            /// Reactions (with roles) this node takes part in, one entry per species reference
+            IncidenceIt IncidenceBegin() const { return inc_.entries.begin(); }
+            IncidenceIt IncidenceEnd() const { return inc_.entries.end(); }
+
+            uint64 getNumIncidences() const { return inc_.entries.size(); }
             
             // Coordinates/dimensions:
             
@@ -516,12 +948,7 @@ namespace Graphfab {
             Point getLowerRightCorner() const;
             
             void recalcExtents() {
-                Real width = _ext.width();
-                Real height = _ext.height();
-                Point del(0.5*width, 0.5*height);
-                
-                _ext = Box(_p - del, _p + del);
-                _r = _ext.maxDim()*0.5;
+                GeometryStore::recalcSpeciesExtents(_p(), _ext(), _r());
             }
             
             /// Set width
@@ -536,7 +963,7 @@ namespace Graphfab {
             /// Set height
             void affectGlobalHeight(Real h);
             
-            void set_i(size_t i) { i_ = i; } 
+            void set_i(size_t i);
             size_t get_i() const { return i_; }
             
             // Layout:
@@ -558,9 +985,9 @@ namespace Graphfab {
             long bytepattern;
         protected:
             // model info:
-            std::string _name, _id;
+            Symbol _name, _id;
             /// Reaction glyph
-            std::string _gly;
+            Symbol _gly;
             // aliasing:
             uint32 _numUses;
             bool _isAlias;
@@ -572,6 +999,11 @@ namespace Graphfab {
             size_t i_;
             int isub_;
             bool exsub_;
+            // reactions referencing this node
+            NodeIncidence inc_;
+
+            friend class Reaction;
+            friend class Network;
     };
     
     /// Does runtime type checking
@@ -586,19 +1018,15 @@ namespace Graphfab {
 //         return x;
     }
     
-    typedef enum {
-        RXN_ROLE_SUBSTRATE,
-        RXN_ROLE_PRODUCT,
-        RXN_ROLE_SIDESUBSTRATE,
-        RXN_ROLE_SIDEPRODUCT,
-        RXN_ROLE_MODIFIER,
-        RXN_ROLE_ACTIVATOR,
-        RXN_ROLE_INHIBITOR,
-    } RxnRoleType;
-
     class RxnCurveFactory {
         public:
-            static RxnBezier* CreateCurve(RxnRoleType role);
+            static RxnBezier* CreateCurve(RxnRoleType role, ElementArena* arena = NULL);
+
+            /// Type of curve created for @a role
+            static RxnCurveType CurveType(RxnRoleType role);
+
+            /// Copy of @a c (same type, anchors and control points)
+            static RxnBezier* CloneCurve(const RxnBezier* c, ElementArena* arena = NULL);
     };
     
     /** @brief Represents a single reaction
@@ -650,12 +1078,14 @@ namespace Graphfab {
             // Model:
             
             /// Get ID
-            const std::string& getId() const { return _id; }
+            const std::string& getId() const { return _id.str(); }
             
             /// Set ID
-            void setId(const std::string& id) { _id = id; }
+            void setId(const std::string& id);
 
             void setName(const std::string& name) { name_ = name; }
+
+            void bindSymbols(SymbolTable* t) { _id.bind(t); name_.bind(t); }
             
             // Species:
             
@@ -664,6 +1094,12 @@ namespace Graphfab {
             
             /// Include species in reaction (weak ref)
             void addSpeciesRef(Node* n, RxnRoleType role);
+
+            /// Insert a species reference at position @a k
+            void insertSpeciesRef(uint64 k, Node* n, RxnRoleType role);
+
+            /// Remove the species reference at position @a k
+            void removeSpeciesRef(uint64 k);
             
             /// Remove the node if it is part of the reaction (do nothing otherwise)
             void removeNode(Node* n);
@@ -716,15 +1152,38 @@ namespace Graphfab {
             void forceRecalcCentroid();
             
             /** @brief Rebuild the curves
-             * @details WARNING: This invalidates any curve iterators
+             * @details Existing curves are re-anchored in place where the curve
+             * type still matches the species role; only the others are reallocated.
+             * WARNING: This invalidates any curve iterators
              */
             void rebuildCurves();
+
+            /** @brief First half of @ref rebuildCurves: create, re-anchor or delete
+             * curves to match the species, without computing control points
+             */
+            void syncCurves();
+
+            /// Call @ref syncCurves if the participating species changed since the curves were built
+            void refreshCurveStructure();
             
             /**
              * @brief Only recalculates control points, does not rebuild curves
              * @details Second half of rebuildCurves
              */
             void recalcCurveCPs();
+
+            /** @brief Bring the curves up to date
+             * @details Rebuilds the curves if the participating species changed,
+             * otherwise recalculates the control points only if the reaction or
+             * one of its species moved or was resized since they were last computed.
+             */
+            void refreshCurves();
+
+            /// True if the reaction or a species moved or was resized since the control points were computed
+            bool curveInputsChanged() const;
+
+            /// True if there is one curve per species, with matching role & anchors
+            bool curvesMatchSpecies() const;
             
             /** @brief Recenter at the mean centroid of connected nodes
              */
@@ -736,12 +1195,11 @@ namespace Graphfab {
             
             /// Get the radius (approx. for non-round)
             void recalcExtents() {
-                _r = 10.;
-                _ext = Box(_p - Point(_r,_r), _p + Point(_r,_r));
+                GeometryStore::recalcReactionExtents(_p(), _ext(), _r());
             }
 
             virtual Box getLocalExtents() const {
-              return Box(getCentroid() - Point(5, 5), getCentroid() + Point(5, 5));
+              return GeometryStore::reactionLocalExtents(getCentroid());
             }
             
             virtual void applyTransform(const Affine2d& t) {
@@ -751,19 +1209,8 @@ namespace Graphfab {
                 }
             }
             
-            virtual void setTransform(const Affine2d& tf, bool recurse = true) {
-                tf_ = tf;
-                for(CurveIt i = CurvesBegin(); i != CurvesEnd(); ++i) {
-                    (*i)->setTransform(tf);
-                }
-            }
-            
-            virtual void setInverseTransform(const Affine2d& itf, bool recurse = true) {
-                itf_ = itf;
-                for(CurveIt i = CurvesBegin(); i != CurvesEnd(); ++i) {
-                    (*i)->setInverseTransform(itf);
-                }
-            }
+            /// Use the view transform @a v for the reaction and its curves
+            void bindView(const ViewTransform* v);
             
             // IO
             void dump(std::ostream& os, uint32 ind);
@@ -776,15 +1223,27 @@ namespace Graphfab {
             void clearDirtyFlag() { _cdirty = false; }
 
             /// Returns weak ref
-            RxnBezier* addCurve(RxnRoleType role) {
-                _curv.push_back(RxnCurveFactory::CreateCurve(role));
-                _curv.back()->setTransform(itf_);
-                _curv.back()->setInverseTransform(itf_);
-                return _curv.back();
-            }
+            RxnBezier* addCurve(RxnRoleType role);
 
             /// Delete the curves
             void deleteCurves();
+
+            /// Destroy the curves through @a arena (see @ref ElementArena::dispose)
+            void disposeCurves(ElementArena* arena);
+
+            /// Re-point curve ends anchored at @a from (the old centroid storage) to the centroid
+            void moveCurveAnchors(const Point* from);
+
+            /** @brief Finish a copy made for @ref Network::clone
+             * @details Maps the species through @a m and replaces the curves
+             * (still those of the original) with copies allocated from @a arena.
+             * The curve anchors are mapped separately by @ref remapCurveAnchors
+             * once the copies have been added to their network.
+             */
+            void remapCopy(const ElementRemap& m, ElementArena* arena);
+
+            /// Map the curve anchors through @a m (see @ref remapCopy)
+            void remapCurveAnchors(const ElementRemap& m);
             
         protected:
             // Methods:
@@ -797,6 +1256,9 @@ namespace Graphfab {
 
             /// Numeric centroid computation, no other side effects
             void doCentroidCalc();
+
+            /// Fill @a key with the geometry the control points depend on
+            void getCurveInputs(std::vector<Point>& key) const;
             
             void curveGuard() {
                 if(_cdirty && _spec.size()) {
@@ -807,11 +1269,8 @@ namespace Graphfab {
             
             // Variables:
             // model:
-            std::string _id;
-            std::string name_;
-            // dims:
-            /// Force (translates to velocity, not accel, due to layout algo.)
-            Point _v;
+            Symbol _id;
+            Symbol name_;
             /// Reactants (weak ref)
             //NodeVec _rct;
             /// Products (weak ref)
@@ -824,6 +1283,8 @@ namespace Graphfab {
             CurveVec _curv;
             /// Do curves need to be rebuilt?
             bool _cdirty;
+            /// Geometry the control points were last computed from (see @ref curveInputsChanged)
+            std::vector<Point> cpkey_;
             
             long bytepattern;
     };
@@ -852,6 +1313,8 @@ namespace Graphfab {
             
             /// Element container (weak refs)
             typedef std::vector<Graphfab::NetworkElement*> EltVec;
+            /// Position of each element in the container
+            typedef std::unordered_map<const Graphfab::NetworkElement*, uint64> EltPosMap;
             
             typedef EltVec::iterator EltIt;
             typedef EltVec::const_iterator ConstEltIt;
@@ -875,19 +1338,21 @@ namespace Graphfab {
                 }
             
             /// Get the compartment's id
-            const std::string& getId() const { return _id; }
+            const std::string& getId() const { return _id.str(); }
             
             /// Set the compartment's id
-            void setId(const std::string& id) { _id = id; }
+            void setId(const std::string& id);
 
             /// Set the compartment's name
             void setName(const std::string& name) { name_ = name; }
             
             /// Get the compartment's glyph (layout element)
-            const std::string& getGlyph() const { return _gly; }
+            const std::string& getGlyph() const { return _gly.str(); }
             
             /// Set the compartment's glyph (layout element)
-            void setGlyph(const std::string& glyph) { _gly = glyph; }
+            void setGlyph(const std::string& glyph);
+
+            void bindSymbols(SymbolTable* t) { _id.bind(t); name_.bind(t); _gly.bind(t); }
             
             void setCentroid(const Point& p) {
                 AN(0, "setCentroid should not be called on a compt");
@@ -895,19 +1360,29 @@ namespace Graphfab {
             
             /// Approximate size; used by distance algorithms etc.
             void recalcExtents() {
-                _r = _ext.maxDim()*0.5;
-                _p = (_ext.getMin() + _ext.getMax())*0.5;
+                GeometryStore::recalcCompartmentExtents(_p(), _ext(), _r());
             }
             
             // Elements
             
-            /// Add an element to the compartment
+            /// Add an element to the compartment (no effect if already present)
             void addElt(NetworkElement* e);
+
+            /// Make room for @a n elements
+            void reserveElts(uint64 n) {
+                _elt.reserve(n);
+                eltpos_.reserve(n);
+            }
             
             bool containsElt(const NetworkElement* e) const;
             
-            /// Remove an element from the compartment (does not call destructor)
+            /** @brief Remove an element from the compartment (does not call destructor)
+             * @details Constant time: the last element takes the place of the removed one
+             */
             void removeElt(NetworkElement* e);
+
+            /// Map the elements of a copy made for @ref Network::clone through @a m
+            void remapCopy(const ElementRemap& m);
             
             /// Manually size the compartment
             void setRestExtents(const Box& ext);
@@ -921,8 +1396,8 @@ namespace Graphfab {
             /// Rest area
             Real restArea() const { return _ra; }
             
-            void setMin(const Point& p) { _ext.setMin(p); }
-            void setMax(const Point& p) { _ext.setMax(p); }
+            void setMin(const Point& p);
+            void setMax(const Point& p);
 
             virtual Point getCentroid(COORD_SYSTEM coord = COORD_SYSTEM_LOCAL) const { return getExtents(coord).getCenter(); }
             
@@ -945,6 +1420,11 @@ namespace Graphfab {
              * @param[in] t The falloff
              */
             void doInternalForce(NetworkElement* e, const Real f, const Real t);
+
+            /** @brief Same as @ref doInternalForce but for an element with extents @a e
+             * @return The force on the element (the caller applies it)
+             */
+            Point internalForce(const Box& e, const Real f, const Real t);
             
             /// Apply contact force for all internal elements
             void doInternalForceAll(const Real f, const Real t);
@@ -972,13 +1452,18 @@ namespace Graphfab {
             
         protected:
             /// ID
-            std::string _id;
+            Symbol _id;
             /// name
-            std::string name_;
+            Symbol name_;
             /// glyph
-            std::string _gly;
+            Symbol _gly;
+            /// Rebuild @ref eltpos_ after @ref _elt was changed directly
+            void reindexElts();
+
             /// Elements
             EltVec _elt;
+            /// Index into @ref _elt for membership tests & removal
+            EltPosMap eltpos_;
             /// Rest area
             Real _ra;
             /// Young's modulus
@@ -993,6 +1478,395 @@ namespace Graphfab {
             uint64_t bytepattern;
     };
 
+    /** @brief Lookup table from an id or glyph to the first element carrying it
+     *  @details Gives the same answer as a front-to-back search of the element
+     *  container. Each key counts the elements carrying it and is erased when
+     *  the last of them goes. Elements are appended to the container, so adding
+     *  one never displaces an existing entry. When the first element with a
+     *  shared key is removed or renamed, or an element is renamed onto a key
+     *  already in use, the entry is marked stale and resolved by a single scan
+     *  the next time it is looked up. Only duplicated keys can go stale, which
+     *  keeps bulk renames (e.g. assigning glyphs after import) linear.
+     */
+    template <class T, const std::string& (T::*Key)() const>
+    class NetworkIndex {
+        public:
+            typedef std::vector<T*> Container;
+
+            void clear() {
+                map_.clear();
+            }
+
+            /// Make room for @a n keys
+            void reserve(uint64 n) { map_.reserve(n); }
+
+            /// Call after appending @a e to the container
+            void add(T* e) {
+                insert(e, (e->*Key)(), false);
+            }
+
+            /// Call after removing @a e from the container (or changing its key from @a key)
+            void remove(T* e, const std::string& key) {
+                typename Map::iterator i = map_.find(key);
+                if(i == map_.end())
+                    return;
+                if(--i->second.n == 0)
+                    map_.erase(i);
+                else if(i->second.first == e)
+                    i->second.first = NULL;
+            }
+
+            /// Call after the key of @a e changed from @a before
+            void rekey(T* e, const std::string& before) {
+                const std::string& after = (e->*Key)();
+                if(before == after)
+                    return;
+                remove(e, before);
+                // e may precede the current entry
+                insert(e, after, true);
+            }
+
+            T* find(const std::string& key, const Container& elts) const {
+                typename Map::iterator i = map_.find(key);
+                if(i == map_.end())
+                    return NULL;
+                if(!i->second.first) {
+                    for(typename Container::const_iterator j=elts.begin(); j!=elts.end(); ++j)
+                        if(((*j)->*Key)() == key) {
+                            i->second.first = *j;
+                            break;
+                        }
+                }
+                return i->second.first;
+            }
+
+        protected:
+            struct Entry {
+                /// First element with the key, or NULL if stale
+                T* first;
+                /// Number of elements with the key
+                uint64 n;
+            };
+            typedef std::unordered_map<std::string, Entry> Map;
+
+            void insert(T* e, const std::string& key, bool anywhere) {
+                std::pair<typename Map::iterator, bool> r = map_.insert(std::make_pair(key, Entry()));
+                Entry& x = r.first->second;
+                if(r.second) {
+                    x.first = e;
+                    x.n = 1;
+                } else {
+                    ++x.n;
+                    if(anywhere)
+                        x.first = NULL;
+                }
+            }
+
+            mutable Map map_;
+    };
+
+    /** @brief Species grouped with their instances
+     *  @details Nodes sharing an id are instances (alias glyphs) of one species.
+     *  Instances keep the order in which they joined their group. Groups are
+     *  appended as they are created; removing the last instance of a species
+     *  moves the newest group into its slot, so removals stay O(1).
+     */
+    class AliasGroupIndex {
+        public:
+            typedef std::vector<Node*> Instances;
+
+            void clear() {
+                groups_.clear();
+                slot_.clear();
+            }
+
+            /// Make room for @a n species
+            void reserve(uint64 n) {
+                groups_.reserve(n);
+                slot_.reserve(n);
+            }
+
+            /// Call after adding @a n to the network
+            void add(Node* n);
+
+            /// Call after removing @a n from the network (or changing its id from @a id)
+            void remove(Node* n, const std::string& id);
+
+            uint64 getNumGroups() const { return groups_.size(); }
+
+            const Instances& getGroup(uint64 k) const { return groups_.at(k); }
+
+            /// Instances of the species with id @a id (NULL if none)
+            const Instances* find(const std::string& id) const;
+
+        protected:
+            typedef std::unordered_map<std::string, uint64> SlotMap;
+
+            std::vector<Instances> groups_;
+            SlotMap slot_;
+    };
+
+    /** @brief Disjoint-set forest over 0..n-1
+     *  @details Path halving; the lower of two roots becomes the root of the
+     *  merged set.
+     */
+    class DisjointSets {
+        public:
+            void reset(uint64 n) {
+                parent_.resize(n);
+                for(uint64 k=0; k<n; ++k)
+                    parent_[k] = k;
+            }
+
+            uint64 find(uint64 k) {
+                while(parent_[k] != k)
+                    k = parent_[k] = parent_[parent_[k]];
+                return k;
+            }
+
+            void unite(uint64 a, uint64 b) {
+                a = find(a);
+                b = find(b);
+                if(a < b)
+                    parent_[b] = a;
+                else
+                    parent_[a] = b;
+            }
+
+        protected:
+            std::vector<uint64> parent_;
+    };
+
+    /** @brief Flat snapshot of node-reaction incidence (CSR layout)
+     *  @details Nodes and reactions are numbered by their position in the
+     *  network. Entries [@ref nodeBegin(k), @ref nodeEnd(k)) list the reactions
+     *  of node @a k in network order, one per species reference; entries
+     *  [@ref rxnBegin(j), @ref rxnEnd(j)) list the species of reaction @a j in
+     *  reference order. Species that are not part of the network are skipped.
+     *  Obtain one with @ref Network::getIncidence.
+     */
+    class NetworkIncidence {
+        public:
+            void build(const Network& net);
+
+            uint64 getNumNodes() const { return nodeoff_.size() - 1; }
+            uint64 getNumRxns() const { return rxnoff_.size() - 1; }
+
+            uint64 nodeBegin(uint64 k) const { return nodeoff_[k]; }
+            uint64 nodeEnd(uint64 k) const { return nodeoff_[k+1]; }
+            /// Reaction index of entry @a p
+            uint64 nodeRxn(uint64 p) const { return noderxn_[p]; }
+            RxnRoleType nodeRole(uint64 p) const { return noderole_[p]; }
+
+            uint64 rxnBegin(uint64 j) const { return rxnoff_[j]; }
+            uint64 rxnEnd(uint64 j) const { return rxnoff_[j+1]; }
+            /// Node index of entry @a p
+            uint64 rxnNode(uint64 p) const { return rxnnode_[p]; }
+            RxnRoleType rxnRole(uint64 p) const { return rxnrole_[p]; }
+
+            /// Get the index of @a n; returns false if it is not in the network
+            bool findNode(const Node* n, uint64& k) const;
+
+            /** @brief Label the connected subgraphs
+             *  @details Nodes sharing a reaction are in the same subgraph, numbered in
+             *  order of their first node. Nodes with a nonzero entry in @a exclude (by
+             *  index, if given) are labeled -1 and do not connect their reactions.
+             *  Linear in the number of nodes and species references.
+             *  @param[out] label Subgraph of each node
+             *  @param[out] size Number of nodes in each subgraph
+             *  @return The number of subgraphs
+             */
+            int labelSubgraphs(std::vector<int>& label, std::vector<uint64>& size, const std::vector<char>* exclude = NULL) const;
+
+        protected:
+            std::vector<uint64> nodeoff_, noderxn_;
+            std::vector<RxnRoleType> noderole_;
+            std::vector<uint64> rxnoff_, rxnnode_;
+            std::vector<RxnRoleType> rxnrole_;
+            std::unordered_map<const Node*, uint64> nodepos_;
+    };
+
+    /** @brief Undo/redo history of edits to a network
+     *  @details While enabled, records moves and resizes of elements, added and
+     *  removed nodes and reactions, new species references and changes to the
+     *  alias flag of nodes as small deltas (no copies of the model). Undo and
+     *  redo take time proportional to the size of the edit. Consecutive moves or
+     *  resizes of the same elements are merged into one step until @ref seal is
+     *  called or another kind of edit is recorded; edits between @ref beginGroup
+     *  and @ref endGroup are undone together. When the history exceeds the memory
+     *  limit the oldest steps are dropped.
+     *
+     *  Nodes and reactions removed while recording belong to the journal: they
+     *  are deleted once no remaining step can restore them (when the history
+     *  is trimmed, a new edit drops the undone steps, on @ref clear, or when the
+     *  network goes away), so do not delete them yourself. Restored elements go
+     *  to the end of the network's containers.
+     */
+    class EditJournal {
+        public:
+            /// Position & size of an element
+            struct Geometry {
+                Point p;
+                Box ext;
+                Real r;
+            };
+
+            /// Records the geometry of an element before and after a change made while in scope
+            class GeometryScope {
+                public:
+                    /// @a j may be NULL (nothing recorded)
+                    GeometryScope(EditJournal* j, NetworkElement* e);
+                    ~GeometryScope();
+
+                protected:
+                    EditJournal* j_;
+                    NetworkElement* e_;
+                    Geometry before_;
+            };
+
+            /// Groups the edits made while in scope (see @ref beginGroup)
+            class GroupScope {
+                public:
+                    GroupScope(EditJournal& j) : j_(j) { j_.beginGroup(); }
+                    ~GroupScope() { j_.endGroup(); }
+
+                protected:
+                    EditJournal& j_;
+            };
+
+            EditJournal(Network* net)
+                : net_(net), enabled_(false), replaying_(false), sealed_(true),
+                  depth_(0), open_(0), lastgroup_(0), base_(0), bytes_(0), limit_(16 << 20) {}
+
+            /// Start or stop recording (stopping also clears the history)
+            void setEnabled(bool enabled);
+
+            bool isEnabled() const { return enabled_; }
+
+            /// True if edits made now are recorded (enabled and not undoing/redoing)
+            bool isRecording() const { return enabled_ && !replaying_; }
+
+            /// Drop the whole history (and delete the elements only it could restore)
+            void clear();
+
+            /// True if @a e was removed from the network and is kept for undo/redo
+            bool holds(NetworkElement* e) const { return hidden_.count(e) != 0; }
+
+            /// Approximate memory used by the history (bytes)
+            uint64 getMemoryUsage() const { return bytes_; }
+
+            /// Drop the oldest steps when the history would use more than @a bytes
+            void setMemoryLimit(uint64 bytes);
+
+            uint64 getMemoryLimit() const { return limit_; }
+
+            /// Undo the edits made until the matching @ref endGroup as one step (may nest)
+            void beginGroup();
+
+            void endGroup();
+
+            /// Stop merging further moves & resizes into the last step
+            void seal() {
+                sealed_ = true;
+                coalesce_.clear();
+            }
+
+            bool canUndo() const { return !undo_.empty(); }
+
+            bool canRedo() const { return !redo_.empty(); }
+
+            /// Revert the last step; returns false if there is none
+            bool undo();
+
+            /// Reapply the last undone step; returns false if there is none
+            bool redo();
+
+            // Recording (called by the network & its elements):
+
+            void recordGeometry(NetworkElement* e, const Geometry& before);
+            void recordNode(Node* n, bool added);
+            void recordReaction(Reaction* r, bool added);
+            /// Species reference @a k of @a r was inserted
+            void recordConnect(Reaction* r, uint64 k);
+            void recordAlias(Node* n, bool before);
+
+            static Geometry getGeometry(const NetworkElement* e);
+
+        protected:
+            typedef enum {
+                EDIT_GEOMETRY,
+                EDIT_ADD_NODE,
+                EDIT_REMOVE_NODE,
+                EDIT_ADD_RXN,
+                EDIT_REMOVE_RXN,
+                EDIT_CONNECT,
+                EDIT_ALIAS
+            } EditType;
+
+            /// Species reference of a removed node: position @a k in reaction @a r
+            struct SpeciesRef {
+                Reaction* r;
+                uint64 k;
+                RxnRoleType role;
+            };
+
+            struct Edit {
+                EditType type;
+                uint64 group;
+                NetworkElement* e;
+                /// Reaction of a species reference / compartment of a removed node
+                NetworkElement* other;
+                /// Position of a species reference / alias flag before the edit
+                uint64 k;
+                RxnRoleType role;
+                Geometry before, after;
+                std::vector<SpeciesRef> refs;
+            };
+
+            typedef std::deque<Edit> EditQueue;
+
+            void push(Edit& x);
+            void apply(Edit& x);
+            void revert(Edit& x);
+            void trim();
+            /// Called for each step dropped from the history
+            void discard(const Edit& x);
+            /// Count the references of a step to elements
+            void ref(NetworkElement* e);
+            void unref(NetworkElement* e);
+            /// Mark an element as removed from / back in the network
+            void hide(NetworkElement* e) { hidden_.insert(e); }
+            void unhide(NetworkElement* e) { hidden_.erase(e); }
+            static void release(NetworkElement* e);
+            uint64 cost(const Edit& x) const;
+
+            /// Save the connections & compartment of a node about to be removed
+            void saveNode(Edit& x);
+            void hideNode(Edit& x);
+            void restoreNode(Edit& x);
+
+            static void setGeometry(NetworkElement* e, const Geometry& g);
+
+            Network* net_;
+            bool enabled_, replaying_;
+            /// Whether moves may still merge into the last step
+            bool sealed_;
+            uint64 depth_, open_, lastgroup_;
+            EditQueue undo_, redo_;
+            /// Position (offset by base_) in undo_ of the moves merged into the last step
+            std::unordered_map<const NetworkElement*, uint64> coalesce_;
+            /// Number of steps referring to each element
+            std::unordered_map<const NetworkElement*, uint64> refs_;
+            /// Removed nodes & reactions owned by the journal
+            std::unordered_set<NetworkElement*> hidden_;
+            uint64 base_;
+            uint64 bytes_, limit_;
+
+        private:
+            EditJournal(const EditJournal&);
+            EditJournal& operator=(const EditJournal&);
+    };
+
     /** @brief Network topology
      */
     class Network : public Compartment {
@@ -1018,15 +1892,49 @@ namespace Graphfab {
             
             // Constructors:
             
-            Network() {
+            Network()
+                : journal_(this) {
                 bytepattern = 0x3355;
                 layoutspecified_ = false;
+                structver_ = 1;
+                incver_ = 0;
+                subver_ = 0;
+                idnext_ = 1;
+                arena_ = new ElementArena();
+                view_.bind(&viewtf_);
+            }
+
+            ~Network() {
+                hierarchRelease();
+                // elements removed earlier keep the arena alive until they are deleted
+                arena_->detach();
             }
             
             // Methods:
             
-            /// Destructor
+            /** @brief Destroy every element of the network, leaving it empty
+             *  @details Elements kept only for undo/redo are deleted one by one; the
+             *  nodes, reactions, compartments and curves in the network are destroyed
+             *  in place and their storage goes back with the arena's slabs. Elements
+             *  removed from the network beforehand are not affected. Also done by the
+             *  destructor.
+             */
             void hierarchRelease();
+
+            /** @brief Arena for the elements and curves of this network
+             *  @details Use as <tt>new (net.getArena()) Node()</tt>. Blocks may be
+             *  freed with @c delete; elements removed from the network may also be
+             *  deleted after the network itself is gone.
+             */
+            ElementArena* getArena() { return arena_; }
+
+            /// Strings shared by the elements of this network
+            SymbolTable& getSymbols() { return symbols_; }
+            const SymbolTable& getSymbols() const { return symbols_; }
+
+            /// Undo/redo history (disabled by default)
+            EditJournal& getJournal() { return journal_; }
+            const EditJournal& getJournal() const { return journal_; }
             
             // Nodes:
             
@@ -1047,12 +1955,16 @@ namespace Graphfab {
             Node* findNodeById(const std::string& id);
             const Node* findNodeById(const std::string& id) const;
             
-            /// Generated unique ID for creating new nodes
+            /** @brief Generated unique ID for creating new nodes
+             *  @details Ids have the form Node_k. Numbers are handed out by a counter
+             *  and reused once the node carrying them is removed or renamed; each
+             *  candidate is checked against the id table, so this is O(1) amortized.
+             */
             std::string getUniqueId() const;
 
             std::string getUniqueGlyphId(const Node& src) const;
             
-            /// Generated unique index for creating new nodes
+            /// Generated unique index for creating new nodes (the smallest index not held by a node)
             std::size_t getUniqueIndex() const;
             
             /// Find the node by specified reaction glyph (from layout package)
@@ -1060,13 +1972,24 @@ namespace Graphfab {
             
             Node* getNodeAt(const size_t i) { return _nodes.at(i); }
 
+            /// Get the first instance of the @a n-th species (see @ref getNumUniqueNodes)
             Node* getUniqueNodeAt(const size_t n);
 
+            /// Number of nodes sharing the id of @a u
             size_t getNumInstances(const Node* u);
 
             /// Get a node in an alias group by instance index
             Node* getInstance(const Node* u, const size_t n);
             
+            /// Update the lookup tables after the id of a contained element changed from @a before
+            void eltIdChanged(NetworkElement* e, const std::string& before);
+
+            /// Update the lookup tables after the glyph of a contained element changed from @a before
+            void eltGlyphChanged(NetworkElement* e, const std::string& before);
+
+            /// Update the index allocator after a contained node's index changed from @a before
+            void nodeIndexChanged(std::size_t before, std::size_t after);
+            
             bool containsNode(const Node* n) const;
 
             bool containsReaction(const Reaction* r) const;
@@ -1079,17 +2002,39 @@ namespace Graphfab {
 
             AttachedCurveList getAttachedCurves(const Node* n);
 
-            int getNumSubgraphs();
+            /// Incidence snapshot of the current structure (rebuilt lazily after changes)
+            const NetworkIncidence& getIncidence() const;
 
-            /// Enumerates all the subgraphs of the network and assigns each a unique index
-            void enumerateSubgraphs();
+            /// Called whenever nodes, reactions or species references change
+            void structureChanged() { ++structver_; }
 
-            /// Assigns the index to all nodes in the subgraph containing @ref x
-            void propagateSubgraphIndex(Node* x, int isub);
+            /// Enumerate the subgraphs and return their number
+            int getNumSubgraphs();
+
+            /** @brief Enumerates all the subgraphs of the network and assigns each a unique index
+             *  @details Nodes connected through a reaction share a subgraph. Nodes marked
+             *  with @ref Node::setExcludeFromSubgraphEnum are skipped and do not connect
+             *  their neighbors. See @ref NetworkIncidence::labelSubgraphs.
+             *  @return The number of subgraphs
+             */
+            int enumerateSubgraphs();
 
             void clearSubgraphInfo();
 
             void clearExcludeFromSubgraphEnum();
+
+            /** @brief Number of connected subgraphs of the whole network
+             *  @details Same numbering as @ref enumerateSubgraphs with no nodes
+             *  excluded, but cached until the structure changes and without
+             *  touching the subgraph index of any node.
+             */
+            int getNumConnectedSubgraphs() const;
+
+            /// Number of nodes in connected subgraph @a isub
+            uint64 getConnectedSubgraphSize(int isub) const;
+
+            /// Connected subgraph of @a n, or -1 if it is not in the network
+            int getConnectedSubgraph(const Node* n) const;
             
             /// Find the reaction by specified ID. Returns NULL if no such reaction exists
             Reaction* findReactionById(const std::string& id);
@@ -1100,11 +2045,11 @@ namespace Graphfab {
             void resetUsageInfo();
             
             /// Get the network's id
-            const std::string& getId() const { return _id; }
+            const std::string& getId() const { return _id.str(); }
 
             void setId(const std::string& id) { _id = id; }
 
-            bool isSetId() const { return _id.size(); }
+            bool isSetId() const { return _id.str().size(); }
             
             bool isLayoutSpecified() const { return layoutspecified_; }
             
@@ -1123,7 +2068,11 @@ namespace Graphfab {
             // Compartments:
             
             /// Add a compartment
-            void addCompartment(Compartment* c) { _comp.push_back(c); addElt(c); }
+            void addCompartment(Compartment* c);
+
+            /** Remove a compartment; its contents stay in the network
+                (does not free memory) */
+            void removeCompartment(Compartment* c);
             
             /** @brief Find a compartment by id
              * @param[in] id Id of compartment elt
@@ -1152,6 +2101,7 @@ namespace Graphfab {
             /// Returns # of species
             uint64 getTotalNumNodes() const { return _nodes.size(); }
 
+            /// Returns # of distinct species (alias instances count once)
             uint64 getNumUniqueNodes() const;
 
             Box getBoundingBox() const;
@@ -1160,9 +2110,11 @@ namespace Graphfab {
             
             void applyTransform(const Affine2d& t);
             
-            void setTransform(const Affine2d& t, bool recurse = true);
+            /// Set the view transform (shared by all elements, so constant time)
+            void setTransform(const Affine2d& t) { viewtf_.tf = t; }
             
-            void setInverseTransform(const Affine2d& it, bool recurse = true);
+            /// Set the inverse view transform
+            void setInverseTransform(const Affine2d& it) { viewtf_.itf = it; }
 
             void applyDisplacement(const Point& d);
             
@@ -1176,8 +2128,14 @@ namespace Graphfab {
             void rebuildCurves();
 
             /** @brief Recalc the CPs for all curves
+             * @details Reactions are processed in parallel when built with
+             * OpenMP; each reaction only writes its own curves, so the result
+             * does not depend on the number of threads.
              */
             void recalcCurveCPs();
+
+            /// Recalc the CPs, rebuilding only curves whose species have changed
+            void refreshCurves();
             
             /// Reposition the junctions at the mean centroid of connected nodes
             void recenterJunctions();
@@ -1266,10 +2224,52 @@ namespace Graphfab {
             ConstCompIt CompsBegin() const { return _comp.begin(); }
             ConstCompIt CompsEnd() const { return _comp.end(); }
             
+            /** @brief Deep copy of the network
+             * @details Copies every element into the arena of the new network,
+             * keeping the element order, and maps species references, compartment
+             * membership and curve anchors onto the copies through a flat table
+             * indexed by geometry slot. Positions, extents, locks, curve control
+             * points and ids carry over unchanged, so laying out the copy gives the
+             * same result as laying out the original. Caller owns the result and
+             * should release it with @c delete.
+             */
+            Network* clone() const;
+
+            /** @brief Fill an empty network from flat arrays
+             * @details Adds @a ncomp compartments, @a nspec species and @a nrxn reactions
+             * with the given ids (names are set to the ids), then connects species
+             * @a refspec[k] to reaction @a refrxn[k] with role @a refrole[k]. Species
+             * @a k goes into compartment @a speccomp[k], or none if it is -1 or
+             * @a speccomp is NULL. The input is validated in one pass before anything
+             * is added (ids must be unique per type, indices in range), storage is
+             * reserved up front and the curves of each reaction are built once, so the
+             * whole call is linear in the size of the input. The result is the same
+             * as adding the elements one at a time through the C API.
+             * @throws InvalidParameterException if the network is not empty or the input is invalid
+             */
+            void build(uint64 nspec, const char* const* specids, const int64* speccomp,
+                       uint64 ncomp, const char* const* compids,
+                       uint64 nrxn, const char* const* rxnids,
+                       uint64 nref, const uint64* refrxn, const uint64* refspec, const RxnRoleType* refrole);
+
+            /** @brief Make room for @a ncomp compartments, @a nspec nodes (aliases
+             * included) and @a nrxn reactions
+             * @details Reserves the element containers, geometry store and lookup
+             * tables so that adding that many elements does not reallocate.
+             */
+            void reserve(uint64 ncomp, uint64 nspec, uint64 nrxn);
+
             bool doByteCheck() const { if(bytepattern == 0x3355) return true; else return false; }
         protected:
             
             void removeReactionsForNode(Node* n);
+
+            /// Index bookkeeping for @ref getUniqueIndex
+            void claimIndex(std::size_t k);
+            void releaseIndex(std::size_t k);
+
+            /// Make the number in a generated id available again
+            void releaseGeneratedId(const std::string& id);
             
             /// Nodes (strong reference)
             NodeVec _nodes;
@@ -1281,8 +2281,52 @@ namespace Graphfab {
             long bytepattern;
             bool layoutspecified_;
 
-            /// Number of subgraphs
-            int nsub_;
+            /// Structure version and the snapshot built for it
+            uint64 structver_;
+            mutable uint64 incver_;
+            mutable NetworkIncidence inc_;
+
+            /// Id and glyph lookup tables
+            NetworkIndex<Node, &Node::getId> nodeids_;
+            NetworkIndex<Node, &Node::getGlyph> nodeglyphs_;
+            NetworkIndex<Graphfab::Reaction, &Graphfab::Reaction::getId> rxnids_;
+            NetworkIndex<Graphfab::Compartment, &Graphfab::Compartment::getId> compids_;
+            NetworkIndex<Graphfab::Compartment, &Graphfab::Compartment::getGlyph> compglyphs_;
+
+            /// Instances of each species
+            AliasGroupIndex aliasgroups_;
+
+            typedef std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t> > FreeList;
+
+            /// Number of nodes holding each index
+            std::vector<uint64> idxuse_;
+            /// Unused indices below idxuse_.size() (may hold stale entries)
+            mutable FreeList idxfree_;
+            /// Next counter for generated ids and numbers released for reuse
+            mutable std::size_t idnext_;
+            mutable FreeList idfree_;
+
+            /// Connected subgraph of each node (by position) and their sizes, for structure version subver_
+            mutable uint64 subver_;
+            mutable std::vector<int> sublabel_;
+            mutable std::vector<uint64> subsize_;
+            void updateConnectedSubgraphs() const;
+
+            /// Owns the storage of elements and curves allocated for this network
+            ElementArena* arena_;
+
+            /// Geometry of the elements (see @ref GeometryStore)
+            GeometryStore geom_;
+            /// View transform shared by the elements (see @ref fitToWindow)
+            ViewTransform viewtf_;
+            /// Ids, names and glyphs of the elements
+            SymbolTable symbols_;
+            /// Undo/redo history
+            EditJournal journal_;
+
+        private:
+            Network(const Network&);
+            Network& operator=(const Network&);
     };
     
     /// Does runtime type checking
@@ -1308,6 +2352,18 @@ namespace Graphfab {
      * @details Useful when layout information isn't present
     */
     Network* networkFromModel(const Model& mod);
+
+    /** @brief Whether a compartment of a model is drawn
+     * @details False for default compartments (SBO:0000410 or a reserved id),
+     * which @ref networkFromModel discards.
+    */
+    bool isVisualCompartment(const ::Compartment& comp);
+
+    /// Same as above for a compartment with id @a id and SBO term @a sbo (-1 if none)
+    bool isVisualCompartment(const std::string& id, int sbo);
+
+    /// Convert a species reference glyph role (throws if undefined)
+    RxnRoleType SBMLRole2GraphfabRole(::SpeciesReferenceRole_t role);
     
     /** @brief Gets the number of non-locked nodes
      */
@@ -0,0 +1,398 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/patch.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Graphfab {
+
+    /// The role a model reference has (layouts refine substrates, products & modifiers)
+    static RxnRoleType getModelRole(RxnRoleType role) {
+        switch(role) {
+            case RXN_ROLE_SIDESUBSTRATE:
+                return RXN_ROLE_SUBSTRATE;
+            case RXN_ROLE_SIDEPRODUCT:
+                return RXN_ROLE_PRODUCT;
+            case RXN_ROLE_ACTIVATOR:
+            case RXN_ROLE_INHIBITOR:
+                return RXN_ROLE_MODIFIER;
+            default:
+                return role;
+        }
+    }
+
+    /// Key of a species reference in a multiset
+    static std::string getRefKey(const std::string& species, RxnRoleType role) {
+        std::string key(species);
+        key += ' ';
+        key += (char)('0' + (int)role);
+        return key;
+    }
+
+    template <class Refs>
+    static void getSpeciesRefs(const ::Reaction& rxn, Refs& refs) {
+        typename Refs::value_type ref;
+        for(unsigned int i=0; i<rxn.getNumReactants(); ++i) {
+            ref.species = rxn.getReactant(i)->getSpecies();
+            ref.role = RXN_ROLE_SUBSTRATE;
+            refs.push_back(ref);
+        }
+        for(unsigned int i=0; i<rxn.getNumProducts(); ++i) {
+            ref.species = rxn.getProduct(i)->getSpecies();
+            ref.role = RXN_ROLE_PRODUCT;
+            refs.push_back(ref);
+        }
+        for(unsigned int i=0; i<rxn.getNumModifiers(); ++i) {
+            ref.species = rxn.getModifier(i)->getSpecies();
+            ref.role = RXN_ROLE_MODIFIER;
+            refs.push_back(ref);
+        }
+    }
+
+    // CLASS NetworkPatch:
+
+    NetworkPatch::NetworkPatch(Network& net, const Model& mod)
+        : net_(net), setid_(false) {
+        if(mod.isSetId() && mod.getId() != net.getId()) {
+            id_ = mod.getId();
+            setid_ = true;
+        }
+
+        // compartments are drawn if they are not a default one & hold species
+        std::unordered_set<std::string> visual, drawn;
+        for(unsigned int i=0; i<mod.getNumCompartments(); ++i) {
+            const ::Compartment* comp = mod.getCompartment(i);
+            if(isVisualCompartment(*comp))
+                visual.insert(comp->getId());
+        }
+        for(unsigned int i=0; i<mod.getNumSpecies(); ++i) {
+            const std::string& comp = mod.getSpecies(i)->getCompartment();
+            if(visual.count(comp))
+                drawn.insert(comp);
+        }
+        for(unsigned int i=0; i<mod.getNumCompartments(); ++i) {
+            const std::string& id = mod.getCompartment(i)->getId();
+            if(drawn.count(id) && !net.findCompById(id))
+                addcomp_.push_back(id);
+        }
+
+        // current compartment of each element
+        typedef std::unordered_map<const NetworkElement*, std::string> ContainerMap;
+        ContainerMap container;
+        for(Network::CompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i) {
+            Graphfab::Compartment* c = *i;
+            if(!drawn.count(c->getId()))
+                delcomp_.push_back(c);
+            for(Graphfab::Compartment::EltIt j=c->EltsBegin(); j!=c->EltsEnd(); ++j)
+                container[*j] = c->getId();
+        }
+
+        // species
+        std::unordered_set<std::string> species;
+        species.reserve(mod.getNumSpecies());
+        for(unsigned int i=0; i<mod.getNumSpecies(); ++i) {
+            const Species* s = mod.getSpecies(i);
+            AN(s, "Failed to get species");
+            species.insert(s->getId());
+
+            std::string comp = drawn.count(s->getCompartment()) ? s->getCompartment() : std::string();
+            Node* n = net.findNodeById(s->getId());
+            if(!n) {
+                NodeAdd a;
+                a.id = s->getId();
+                a.name = s->getName();
+                a.comp = comp;
+                addnode_.push_back(a);
+                continue;
+            }
+            if(n->getName() != s->getName())
+                renamenode_.push_back(std::make_pair(s->getId(), s->getName()));
+            ContainerMap::const_iterator c = container.find(n);
+            if((c == container.end() ? std::string() : c->second) != comp) {
+                NodeMove m;
+                m.id = s->getId();
+                m.comp = comp;
+                movenode_.push_back(m);
+            }
+        }
+        for(uint64 k=0; k<net.getNumUniqueNodes(); ++k) {
+            const std::string& id = net.getUniqueNodeAt(k)->getId();
+            if(!species.count(id))
+                delnode_.push_back(id);
+        }
+
+        // reactions
+        std::unordered_set<std::string> rxns;
+        rxns.reserve(mod.getNumReactions());
+        for(unsigned int i=0; i<mod.getNumReactions(); ++i) {
+            const ::Reaction* rxn = mod.getReaction(i);
+            AN(rxn, "Failed to get reaction");
+            rxns.insert(rxn->getId());
+
+            std::string comp = drawn.count(rxn->getCompartment()) ? rxn->getCompartment() : std::string();
+            Graphfab::Reaction* r = net.findReactionById(rxn->getId());
+            if(!r) {
+                RxnAdd a;
+                a.id = rxn->getId();
+                a.comp = comp;
+                getSpeciesRefs(*rxn, a.refs);
+                addrxn_.push_back(a);
+                continue;
+            }
+            ContainerMap::const_iterator c = container.find(r);
+            if((c == container.end() ? std::string() : c->second) != comp) {
+                RxnMove m;
+                m.r = r;
+                m.comp = comp;
+                moverxn_.push_back(m);
+            }
+            diffReaction(r, *rxn);
+        }
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i)
+            if(!rxns.count((*i)->getId()))
+                delrxn_.push_back(*i);
+    }
+
+    void NetworkPatch::diffReaction(Graphfab::Reaction* r, const ::Reaction& rxn) {
+        std::vector<SpeciesRef> refs;
+        getSpeciesRefs(rxn, refs);
+
+        // match current references against the model's as multisets
+        typedef std::unordered_map<std::string, uint64> RefCount;
+        RefCount want;
+        for(std::vector<SpeciesRef>::const_iterator i=refs.begin(); i!=refs.end(); ++i)
+            ++want[getRefKey(i->species, i->role)];
+
+        std::vector<uint64> unmatched;
+        uint64 k = 0;
+        for(Graphfab::Reaction::NodeIt i=r->NodesBegin(); i!=r->NodesEnd(); ++i, ++k) {
+            RefCount::iterator w = want.find(getRefKey(i->first->getId(), getModelRole(i->second)));
+            if(w != want.end() && w->second)
+                --w->second;
+            else
+                unmatched.push_back(k);
+        }
+        if(unmatched.empty() && k == refs.size())
+            return;
+
+        // unmatched references by species, so a new role reuses the old reference
+        typedef std::unordered_map<std::string, std::vector<uint64> > RefPosMap;
+        RefPosMap bysp;
+        for(std::vector<uint64>::const_iterator i=unmatched.begin(); i!=unmatched.end(); ++i)
+            bysp[(r->NodesBegin() + *i)->first->getId()].push_back(*i);
+
+        RxnEdit x;
+        x.r = r;
+        std::unordered_set<uint64> reused;
+        for(std::vector<SpeciesRef>::const_iterator i=refs.begin(); i!=refs.end(); ++i) {
+            RefCount::iterator w = want.find(getRefKey(i->species, i->role));
+            if(!w->second)
+                continue;
+            --w->second;
+            RefPosMap::iterator p = bysp.find(i->species);
+            if(p != bysp.end() && !p->second.empty()) {
+                x.roles.push_back(std::make_pair(p->second.front(), i->role));
+                reused.insert(p->second.front());
+                p->second.erase(p->second.begin());
+            } else
+                x.added.push_back(*i);
+        }
+        for(std::vector<uint64>::const_iterator i=unmatched.begin(); i!=unmatched.end(); ++i)
+            if(!reused.count(*i))
+                x.removed.push_back(*i);
+        std::sort(x.roles.begin(), x.roles.end());
+        editrxn_.push_back(x);
+    }
+
+    uint64 NetworkPatch::getNumChanges() const {
+        uint64 n = (setid_ ? 1 : 0) + addcomp_.size() + delcomp_.size() +
+            addnode_.size() + delnode_.size() + movenode_.size() + renamenode_.size() +
+            addrxn_.size() + delrxn_.size() + moverxn_.size();
+        for(std::vector<RxnEdit>::const_iterator i=editrxn_.begin(); i!=editrxn_.end(); ++i)
+            n += i->roles.size() + i->removed.size() + i->added.size();
+        return n;
+    }
+
+    void NetworkPatch::moveElt(NetworkElement* e, const std::string& comp) {
+        if(Graphfab::Compartment* c = net_.findContainingCompartment(e))
+            c->removeElt(e);
+        Graphfab::Compartment* c = comp.empty() ? NULL : net_.findCompById(comp);
+        if(c)
+            c->addElt(e);
+        if(e->getType() == NET_ELT_TYPE_SPEC)
+            static_cast<Node*>(e)->_comp = c;
+    }
+
+    void NetworkPatch::apply() {
+        // compartment changes cannot be replayed by the journal
+        EditJournal& journal = net_.getJournal();
+        bool journaling = journal.isEnabled();
+        journal.setEnabled(false);
+
+        if(setid_)
+            net_.setId(id_);
+
+        std::vector<Graphfab::Compartment*> newcomps;
+        for(std::vector<std::string>::const_iterator i=addcomp_.begin(); i!=addcomp_.end(); ++i) {
+            Graphfab::Compartment* c = new (net_.getArena()) Graphfab::Compartment();
+            c->setId(*i);
+            net_.addCompartment(c);
+            newcomps.push_back(c);
+        }
+
+        std::vector<Node*> newnodes;
+        for(std::vector<NodeAdd>::const_iterator i=addnode_.begin(); i!=addnode_.end(); ++i) {
+            Node* n = new (net_.getArena()) Node();
+            n->setName(i->name);
+            n->setId(i->id);
+            n->numUses() = 1;
+            n->setAlias(false);
+            n->set_i(net_.getUniqueIndex());
+            net_.addNode(n);
+            moveElt(n, i->comp);
+            newnodes.push_back(n);
+        }
+
+        // changes apply to every instance of a species
+        for(std::vector<NodeMove>::const_iterator i=movenode_.begin(); i!=movenode_.end(); ++i) {
+            Node* u = net_.findNodeById(i->id);
+            for(uint64 k=0; k<net_.getNumInstances(u); ++k)
+                moveElt(net_.getInstance(u, k), i->comp);
+        }
+        for(std::vector< std::pair<std::string, std::string> >::const_iterator i=renamenode_.begin(); i!=renamenode_.end(); ++i) {
+            Node* u = net_.findNodeById(i->first);
+            for(uint64 k=0; k<net_.getNumInstances(u); ++k)
+                net_.getInstance(u, k)->setName(i->second);
+        }
+
+        for(std::vector<Graphfab::Reaction*>::const_iterator i=delrxn_.begin(); i!=delrxn_.end(); ++i) {
+            if(Graphfab::Compartment* c = net_.findContainingCompartment(*i))
+                c->removeElt(*i);
+            net_.removeReaction(*i);
+            (*i)->hierarchRelease();
+            delete *i;
+        }
+        for(std::vector<RxnMove>::const_iterator i=moverxn_.begin(); i!=moverxn_.end(); ++i)
+            moveElt(i->r, i->comp);
+
+        for(std::vector<RxnEdit>::const_iterator i=editrxn_.begin(); i!=editrxn_.end(); ++i) {
+            Graphfab::Reaction* r = i->r;
+            // keep the node of a reference whose role changed (it may be an alias)
+            for(std::vector< std::pair<uint64, RxnRoleType> >::const_iterator j=i->roles.begin(); j!=i->roles.end(); ++j) {
+                Node* n = (r->NodesBegin() + j->first)->first;
+                r->removeSpeciesRef(j->first);
+                r->insertSpeciesRef(j->first, n, j->second);
+            }
+            for(std::vector<uint64>::const_reverse_iterator j=i->removed.rbegin(); j!=i->removed.rend(); ++j)
+                r->removeSpeciesRef(*j);
+            for(std::vector<SpeciesRef>::const_iterator j=i->added.begin(); j!=i->added.end(); ++j) {
+                Node* n = net_.findNodeById(j->species);
+                AN(n, "Invalid species reference");
+                r->addSpeciesRef(n, j->role);
+            }
+            r->rebuildCurves();
+        }
+
+        std::vector<Graphfab::Reaction*> newrxns;
+        for(std::vector<RxnAdd>::const_iterator i=addrxn_.begin(); i!=addrxn_.end(); ++i) {
+            Graphfab::Reaction* r = new (net_.getArena()) Graphfab::Reaction();
+            r->setId(i->id);
+            for(std::vector<SpeciesRef>::const_iterator j=i->refs.begin(); j!=i->refs.end(); ++j) {
+                Node* n = net_.findNodeById(j->species);
+                AN(n, "Invalid species reference");
+                r->addSpeciesRef(n, j->role);
+            }
+            net_.addReaction(r);
+            moveElt(r, i->comp);
+            newrxns.push_back(r);
+        }
+
+        for(std::vector<std::string>::const_iterator i=delnode_.begin(); i!=delnode_.end(); ++i) {
+            Node* u = net_.findNodeById(*i);
+            std::vector<Node*> instances;
+            for(uint64 k=0; k<net_.getNumInstances(u); ++k)
+                instances.push_back(net_.getInstance(u, k));
+            for(std::vector<Node*>::iterator k=instances.begin(); k!=instances.end(); ++k) {
+                net_.removeNode(*k);
+                delete *k;
+            }
+        }
+        for(std::vector<Graphfab::Compartment*>::const_iterator i=delcomp_.begin(); i!=delcomp_.end(); ++i) {
+            net_.removeCompartment(*i);
+            delete *i;
+        }
+
+        // place new elements next to what they are attached to
+        for(std::vector<Graphfab::Compartment*>::iterator i=newcomps.begin(); i!=newcomps.end(); ++i)
+            (*i)->autoSize();
+        std::unordered_set<const Node*> placed(newnodes.begin(), newnodes.end());
+        for(std::vector<Node*>::iterator i=newnodes.begin(); i!=newnodes.end(); ++i) {
+            Node* n = *i;
+            if(n->_comp) {
+                n->setCentroid(n->_comp->getCentroid());
+                continue;
+            }
+            Point p(0., 0.);
+            uint64 count = 0;
+            Network::AttachedRxnList rxns = net_.getConnectedReactions(n);
+            for(Network::AttachedRxnList::iterator j=rxns.begin(); j!=rxns.end(); ++j)
+                for(Graphfab::Reaction::NodeIt k=(*j)->NodesBegin(); k!=(*j)->NodesEnd(); ++k)
+                    if(!placed.count(k->first)) {
+                        p += k->first->getCentroid();
+                        ++count;
+                    }
+            if(count)
+                n->setCentroid(p*(1./count));
+        }
+        for(std::vector<Graphfab::Reaction*>::iterator i=newrxns.begin(); i!=newrxns.end(); ++i)
+            (*i)->forceRecalcCentroid();
+
+        for(std::vector<RxnEdit>::const_iterator i=editrxn_.begin(); i!=editrxn_.end(); ++i)
+            i->r->recalcCurveCPs();
+        for(std::vector<Graphfab::Reaction*>::iterator i=newrxns.begin(); i!=newrxns.end(); ++i)
+            (*i)->recalcCurveCPs();
+
+        journal.setEnabled(journaling);
+    }
+
+    uint64 patchNetworkFromModel(Network& net, const Model& mod) {
+        NetworkPatch patch(net, mod);
+        uint64 n = patch.getNumChanges();
+        if(n)
+            patch.apply();
+        return n;
+    }
+
+}
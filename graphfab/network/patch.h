@@ -0,0 +1,153 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file patch.h
+ * @brief Bring an existing network in line with an updated model
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_NETWORK_PATCH_H_
+#define __SBNW_NETWORK_PATCH_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/network.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <string>
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief Structural difference between a network and an updated model
+     * @details Species, reactions and compartments are matched by SBML id.
+     * The patch lists only what differs: elements to add or remove, species
+     * references to add, remove or change the role of, and species or
+     * reactions that moved to another compartment. Applying it edits the
+     * network in place, so unchanged elements keep their positions, glyphs,
+     * aliases and curves, and the cost is proportional to the number of
+     * changes. Compartments are filtered like @ref networkFromModel does
+     * (default compartments and compartments without species are not drawn).
+     * Roles assigned by a layout (side substrates, activators ...) count as
+     * the model role they refine.
+     */
+    class _GraphfabExport NetworkPatch {
+        public:
+            /// Compute the changes that turn @a net into the network of @a mod
+            NetworkPatch(Network& net, const Model& mod);
+
+            /// True if the network already matches the model
+            bool empty() const { return getNumChanges() == 0; }
+
+            /// Number of added, removed or modified elements & species references
+            uint64 getNumChanges() const;
+
+            /** @brief Apply to the network the patch was computed against
+             * @details Must be called before the network is otherwise modified.
+             * New species are placed at the centroid of their compartment, or of
+             * the species they share reactions with; new reactions at the
+             * centroid of their species. Removed elements are deleted. The edit
+             * journal of the network is cleared since the patch is not recorded.
+             */
+            void apply();
+
+        protected:
+            /// A species reference by species id
+            struct SpeciesRef {
+                std::string species;
+                RxnRoleType role;
+            };
+
+            struct NodeAdd {
+                std::string id, name, comp;
+            };
+
+            struct NodeMove {
+                std::string id, comp;
+            };
+
+            struct RxnAdd {
+                std::string id, comp;
+                std::vector<SpeciesRef> refs;
+            };
+
+            struct RxnMove {
+                Graphfab::Reaction* r;
+                std::string comp;
+            };
+
+            /// Role changes, removals & additions of the references of one reaction
+            struct RxnEdit {
+                Graphfab::Reaction* r;
+                /// (position, new role), ascending
+                std::vector< std::pair<uint64, RxnRoleType> > roles;
+                /// Positions, ascending
+                std::vector<uint64> removed;
+                std::vector<SpeciesRef> added;
+            };
+
+            void diffReaction(Graphfab::Reaction* r, const ::Reaction& rxn);
+
+            /// Move @a e into the compartment with id @a comp (none if empty)
+            void moveElt(NetworkElement* e, const std::string& comp);
+
+            Network& net_;
+            bool setid_;
+            std::string id_;
+
+            std::vector<std::string> addcomp_;
+            std::vector<Graphfab::Compartment*> delcomp_;
+
+            std::vector<NodeAdd> addnode_;
+            std::vector<std::string> delnode_;
+            std::vector<NodeMove> movenode_;
+            /// (species id, new name)
+            std::vector< std::pair<std::string, std::string> > renamenode_;
+
+            std::vector<RxnAdd> addrxn_;
+            std::vector<Graphfab::Reaction*> delrxn_;
+            std::vector<RxnMove> moverxn_;
+            std::vector<RxnEdit> editrxn_;
+    };
+
+    /** @brief Update @a net in place to match @a mod
+     * @details Same as computing a @ref NetworkPatch and applying it.
+     * @returns The number of changes
+     */
+    _GraphfabExport uint64 patchNetworkFromModel(Network& net, const Model& mod);
+
+}
+
+#endif
+
+#endif
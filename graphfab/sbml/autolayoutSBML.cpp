@@ -32,12 +32,63 @@
 #include "graphfab/core/SagittariusCore.h"
 #include "graphfab/sbml/autolayoutSBML.h"
 #include "graphfab/diag/error.h"
+#include "graphfab/io/file.h"
 
 #include "sbml/SBMLTypes.h"
 #include <sstream>
+#include <string.h>
 
 using namespace libsbml;
 
+namespace {
+
+    /** @brief Parses a document without copying it
+     * @details readSBMLFromString takes a std::string, which duplicates the
+     * whole file. It only prepends an XML declaration when there is none, so
+     * documents that have one go straight to the parser.
+     */
+    class InPlaceSBMLReader : public SBMLReader {
+        public:
+            SBMLDocument* readInPlace(const char* content) {
+                if(strncmp(content, "<?xml version=", 14))
+                    return readSBMLFromString(content);
+                return readInternal(content, false);
+            }
+    };
+
+    /// Wrap a parsed document; NULL if it has errors (warnings are fine)
+    gf_SBMLModel* wrapSBMLDocument(SBMLDocument* doc) {
+        AN(doc, "Failed to parse SBML"); //not libSBML's documented way of failing, but just in case...
+        
+        if(doc->getNumErrors()) {
+            #if SAGITTARIUS_DEBUG_LEVEL >= 2
+            fprintf(stderr, "Failed to parse SBML\n");
+            for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
+                std::cerr << "Error " << i << ": " <<doc->getError(i)->getMessage() << "\n";
+            }
+            std::stringstream ss;
+            ss << "Failed to parse SBML\n";
+            for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
+                ss << "Error " << i << ": " <<doc->getError(i)->getMessage() << "\n";
+            }
+            gf_setError(ss.str().c_str());
+            #endif
+            // if all are warnings, continue - else abort
+            for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
+              if (!doc->getError(i)->isWarning()) {
+                delete doc;
+                return NULL;
+              }
+            }
+        }
+        
+        gf_SBMLModel* r=(gf_SBMLModel*)malloc(sizeof(gf_SBMLModel));
+        r->pdoc = doc;
+        return r;
+    }
+
+}
+
 void gf_freeSBMLModel(gf_SBMLModel* lo) {
     if(!lo)
         AN(0, "Not a valid layout pointer"); //null
@@ -47,86 +98,25 @@ void gf_freeSBMLModel(gf_SBMLModel* lo) {
 }
 
 extern "C" gf_SBMLModel* gf_loadSBMLbuf(const char* buf) {
-    gf_SBMLModel* r=(gf_SBMLModel*)malloc(sizeof(gf_SBMLModel));
     SBMLReader reader;
-    SBMLDocument* doc = reader.readSBMLFromString(buf);
-    
-    AN(doc, "Failed to parse SBML"); //not libSBML's documented way of failing, but just in case...
-    
-    if(doc->getNumErrors()) {
-        #if SAGITTARIUS_DEBUG_LEVEL >= 2
-        fprintf(stderr, "Failed to parse SBML\n");
-        for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
-            std::cerr << "Error " << i << ": " <<doc->getError(i)->getMessage() << "\n";
-        }
-        std::stringstream ss;
-        ss << "Failed to parse SBML\n";
-        for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
-            ss << "Error " << i << ": " <<doc->getError(i)->getMessage() << "\n";
-        }
-        gf_setError(ss.str().c_str());
-        #endif
-        // if all are warnings, continue - else abort
-        for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
-          if (!doc->getError(i)->isWarning())
-            return NULL;
-        }
-    }
-    
-    r->pdoc = doc;
-    return r;
+    return wrapSBMLDocument(reader.readSBMLFromString(buf));
 }
 
 extern "C" gf_SBMLModel* gf_loadSBMLfile(const char* path) {
-  char* buf;
-  size_t size=0;
-  FILE* file=NULL;
-  size_t bytes_read;
-
   try {
-
-    file = fopen(path, "rb");
-    if(!file)
+    Graphfab::FileContents contents;
+    if(!contents.load(path))
       SBNW_THROW(Graphfab::InternalCheckFailureException, "Failed to open file", "gf_loadSBMLfile");
 
-    //get t3h s!z3
-    fseek(file, 0, SEEK_END);
-    size = ftell(file);
-    rewind(file);
-    #if SAGITTARIUS_DEBUG_LEVEL >= 2
-  //     fprintf(stderr, "File size is %lu\n", size);
-    #endif
-    assert(size > 0);
-
-    //allocated buffer
-    if (sizeof(char) != 1)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "char must be one byte wide", "gf_loadSBMLfile");
-    buf=(char*)malloc(size+1); //one extra byte for null char
-    if (!buf)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "Failed to allocate buffer", "gf_loadSBMLfile");
-    //read the whole file at once
-    bytes_read = fread(buf, 1, size, file);
-    if (bytes_read != size)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "Failed to read whole file (wrong size specified?)", "gf_loadSBMLfile");
-    //trip EOF indicator
-    fgetc(file);
-    if (!feof(file))
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "EOF Expected", "gf_loadSBMLfile");
-    buf[size] = '\0'; //terminating null char
-
-    /*close*/
-    fclose(file);
-
-    gf_SBMLModel* mod = gf_loadSBMLbuf(buf);
-
-    free(buf);
-
-    return mod;
+    InPlaceSBMLReader reader;
+    SBMLDocument* doc = reader.readInPlace(contents.getData());
+    // the document no longer refers to the text
+    contents.release();
+
+    return wrapSBMLDocument(doc);
 
   } catch (const Graphfab::Exception& e) {
     gf_setError( e.getReport().c_str() );
     return NULL;
   }
 }
-
-
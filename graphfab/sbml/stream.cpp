@@ -0,0 +1,447 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/sbml/stream.h"
+#include "graphfab/diag/error.h"
+#include "graphfab/io/xml.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Graphfab {
+
+    namespace {
+
+        /// Where an element sits in the document
+        typedef enum {
+            SBML_DOC,
+            SBML_SBML,
+            SBML_MODEL,
+            SBML_ANNOTATION,
+            SBML_COMPS,
+            SBML_SPECIES,
+            SBML_RXNS,
+            SBML_RXN,
+            SBML_REFS,
+            SBML_LAYOUTS,
+            SBML_LAYOUT,
+            SBML_COMPGLYPHS,
+            SBML_SPECGLYPHS,
+            SBML_RXNGLYPHS,
+            SBML_GLYPH,
+            SBML_RXNGLYPH,
+            SBML_SRGLYPHS,
+            SBML_SRGLYPH,
+            SBML_BBOX,
+            SBML_CURVE,
+            SBML_SEGMENTS,
+            SBML_SEGMENT,
+            // not interesting, nor is anything inside
+            SBML_SKIP
+        } SBMLState;
+
+        std::string str(const XMLString* s) {
+            return s ? s->str() : std::string();
+        }
+
+        Real num(const XMLString* s) {
+            if(!s)
+                return 0;
+            char buf[64];
+            size_t n = std::min(s->n, sizeof(buf) - 1);
+            memcpy(buf, s->p, n);
+            buf[n] = '\0';
+            return strtod(buf, NULL);
+        }
+
+        /// SBO term as an integer, or -1 if not set
+        int sbo(const XMLString* s) {
+            if(!s || s->n != 11 || strncmp(s->p, "SBO:", 4))
+                return -1;
+            int r = 0;
+            for(size_t k=4; k<11; ++k) {
+                if(s->p[k] < '0' || s->p[k] > '9')
+                    return -1;
+                r = 10*r + (s->p[k] - '0');
+            }
+            return r;
+        }
+
+        bool role(const XMLString* s, RxnRoleType& r) {
+            if(!s)
+                return false;
+            if(*s == "substrate")
+                r = RXN_ROLE_SUBSTRATE;
+            else if(*s == "product")
+                r = RXN_ROLE_PRODUCT;
+            else if(*s == "sidesubstrate")
+                r = RXN_ROLE_SIDESUBSTRATE;
+            else if(*s == "sideproduct")
+                r = RXN_ROLE_SIDEPRODUCT;
+            else if(*s == "modifier")
+                r = RXN_ROLE_MODIFIER;
+            else if(*s == "activator")
+                r = RXN_ROLE_ACTIVATOR;
+            else if(*s == "inhibitor")
+                r = RXN_ROLE_INHIBITOR;
+            else
+                // libSBML refuses to convert "undefined"; leave it to report the error
+                return false;
+            return true;
+        }
+
+        bool refOrder(const ImportData::SpecRef& a, const ImportData::SpecRef& b) {
+            return a.role < b.role;
+        }
+
+        /** @brief Collects @ref ImportData while the reader walks the document
+         * @details Tracks the path to the current element as a stack of
+         * states. Subtrees that do not matter are skipped by depth alone.
+         */
+        class SBMLImportHandler : public XMLSaxHandler {
+            public:
+                SBMLImportHandler(ImportData& d)
+                  : d_(d), skip_(0), unsupported_(false), hasmodel_(false), nlayouts_(0),
+                    refrole_(RXN_ROLE_SUBSTRATE), seg_(NULL), nsegs_(0) {
+                    for(int k=0; k<4; ++k)
+                        box_[k] = NULL;
+                }
+
+                virtual bool startElement(const XMLString& name, const XMLAttributes& a) {
+                    if(skip_) {
+                        ++skip_;
+                        return true;
+                    }
+                    SBMLState s = enter(stack_.empty() ? SBML_DOC : stack_.back(), name.local(), a);
+                    if(unsupported_)
+                        return false;
+                    if(s == SBML_SKIP)
+                        skip_ = 1;
+                    else
+                        stack_.push_back(s);
+                    return true;
+                }
+
+                virtual bool endElement(const XMLString&) {
+                    if(skip_) {
+                        --skip_;
+                        return true;
+                    }
+                    if(stack_.back() == SBML_RXN)
+                        // reactants, then products, then modifiers, as libSBML lists them
+                        std::stable_sort(d_.rxns.back().refs.begin(), d_.rxns.back().refs.end(), refOrder);
+                    stack_.pop_back();
+                    return true;
+                }
+
+                bool isUnsupported() const { return unsupported_; }
+
+                bool hasModel() const { return hasmodel_; }
+
+                uint64 getNumLayouts() const { return nlayouts_; }
+
+            protected:
+                SBMLState unsupported() {
+                    unsupported_ = true;
+                    return SBML_SKIP;
+                }
+
+                /// State of a child @a tag of an element in state @a parent
+                SBMLState enter(SBMLState parent, const XMLString& tag, const XMLAttributes& a) {
+                    switch(parent) {
+                        case SBML_DOC:
+                            if(!(tag == "sbml"))
+                                return unsupported();
+                            d_.level = (uint64)num(a.find("level"));
+                            d_.version = (uint64)num(a.find("version"));
+                            if(d_.level < 2 || d_.level > 3)
+                                return unsupported();
+                            return SBML_SBML;
+
+                        case SBML_SBML:
+                            if(tag == "model" && !hasmodel_) {
+                                hasmodel_ = true;
+                                d_.id = str(a.find("id"));
+                                d_.hasid = !d_.id.empty();
+                                return SBML_MODEL;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_MODEL:
+                            if(tag == "listOfCompartments")
+                                return SBML_COMPS;
+                            if(tag == "listOfSpecies")
+                                return SBML_SPECIES;
+                            if(tag == "listOfReactions")
+                                return SBML_RXNS;
+                            // level 2 keeps layouts in the annotation, level 3 in the layout package
+                            if(d_.level == 2 && tag == "annotation")
+                                return SBML_ANNOTATION;
+                            if(d_.level == 3 && tag == "listOfLayouts")
+                                return SBML_LAYOUTS;
+                            return SBML_SKIP;
+
+                        case SBML_ANNOTATION:
+                            return tag == "listOfLayouts" ? SBML_LAYOUTS : SBML_SKIP;
+
+                        case SBML_COMPS:
+                            if(tag == "compartment") {
+                                ImportData::Comp c;
+                                c.id = str(a.find("id"));
+                                c.sbo = sbo(a.find("sboTerm"));
+                                d_.comps.push_back(c);
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_SPECIES:
+                            if(tag == "species") {
+                                d_.species.push_back(ImportData::Spec());
+                                ImportData::Spec& s = d_.species.back();
+                                s.id = str(a.find("id"));
+                                s.name = str(a.find("name"));
+                                s.comp = str(a.find("compartment"));
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_RXNS:
+                            if(tag == "reaction") {
+                                d_.rxns.push_back(ImportData::Rxn());
+                                d_.rxns.back().id = str(a.find("id"));
+                                d_.rxns.back().comp = str(a.find("compartment"));
+                                return SBML_RXN;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_RXN:
+                            if(tag == "listOfReactants")
+                                refrole_ = RXN_ROLE_SUBSTRATE;
+                            else if(tag == "listOfProducts")
+                                refrole_ = RXN_ROLE_PRODUCT;
+                            else if(tag == "listOfModifiers")
+                                refrole_ = RXN_ROLE_MODIFIER;
+                            else
+                                return SBML_SKIP;
+                            return SBML_REFS;
+
+                        case SBML_REFS:
+                            if(tag == "speciesReference" || tag == "modifierSpeciesReference") {
+                                ImportData::SpecRef r;
+                                r.species = str(a.find("species"));
+                                r.role = refrole_;
+                                d_.rxns.back().refs.push_back(r);
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_LAYOUTS:
+                            // only the first layout is used
+                            if(tag == "layout" && !nlayouts_++) {
+                                d_.haslayout = true;
+                                d_.width = d_.height = 0;
+                                return SBML_LAYOUT;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_LAYOUT:
+                            if(tag == "dimensions") {
+                                d_.width = num(a.find("width"));
+                                d_.height = num(a.find("height"));
+                            } else if(tag == "listOfCompartmentGlyphs")
+                                return SBML_COMPGLYPHS;
+                            else if(tag == "listOfSpeciesGlyphs")
+                                return SBML_SPECGLYPHS;
+                            else if(tag == "listOfReactionGlyphs")
+                                return SBML_RXNGLYPHS;
+                            return SBML_SKIP;
+
+                        case SBML_COMPGLYPHS:
+                            if(tag == "compartmentGlyph") {
+                                d_.compglyphs.push_back(newGlyph(a, "compartment"));
+                                setBox(d_.compglyphs.back());
+                                return SBML_GLYPH;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_SPECGLYPHS:
+                            if(tag == "speciesGlyph") {
+                                d_.specglyphs.push_back(newGlyph(a, "species"));
+                                setBox(d_.specglyphs.back());
+                                return SBML_GLYPH;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_RXNGLYPHS:
+                            if(tag == "reactionGlyph") {
+                                d_.rxnglyphs.push_back(ImportData::RxnGlyph());
+                                ImportData::RxnGlyph& g = d_.rxnglyphs.back();
+                                g.id = str(a.find("id"));
+                                g.rxn = str(a.find("reaction"));
+                                g.x = g.y = g.w = g.h = 0;
+                                setBox(g);
+                                return SBML_RXNGLYPH;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_GLYPH:
+                            return tag == "boundingBox" ? SBML_BBOX : SBML_SKIP;
+
+                        case SBML_RXNGLYPH:
+                            if(tag == "boundingBox")
+                                return SBML_BBOX;
+                            if(tag == "curve") {
+                                seg_ = &d_.rxnglyphs.back().curve;
+                                return SBML_CURVE;
+                            }
+                            if(tag == "listOfSpeciesReferenceGlyphs")
+                                return SBML_SRGLYPHS;
+                            return SBML_SKIP;
+
+                        case SBML_SRGLYPHS:
+                            if(tag == "speciesReferenceGlyph") {
+                                ImportData::SpecRefGlyph r;
+                                r.glyph = str(a.find("speciesGlyph"));
+                                r.ref = str(a.find("speciesReference"));
+                                if(!role(a.find("role"), r.role))
+                                    return unsupported();
+                                d_.rxnglyphs.back().refs.push_back(r);
+                                return SBML_SRGLYPH;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_SRGLYPH:
+                            if(tag == "curve") {
+                                seg_ = &d_.rxnglyphs.back().refs.back().curve;
+                                return SBML_CURVE;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_BBOX:
+                            if(tag == "position") {
+                                *box_[0] = num(a.find("x"));
+                                *box_[1] = num(a.find("y"));
+                            } else if(tag == "dimensions") {
+                                *box_[2] = num(a.find("width"));
+                                *box_[3] = num(a.find("height"));
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_CURVE:
+                            if(tag == "listOfCurveSegments") {
+                                nsegs_ = 0;
+                                return SBML_SEGMENTS;
+                            }
+                            return SBML_SKIP;
+
+                        case SBML_SEGMENTS: {
+                            if(!(tag == "curveSegment"))
+                                return SBML_SKIP;
+                            // libSBML takes a segment without a type for a line
+                            const XMLString* type = a.find("type");
+                            bool bezier = type && *type == "CubicBezier";
+                            if(type && !bezier && !(*type == "LineSegment"))
+                                return unsupported();
+                            // only the first segment is used
+                            if(nsegs_++) {
+                                cur_ = &dummy_;
+                                *cur_ = ImportData::Segment();
+                            } else
+                                cur_ = seg_;
+                            cur_->set = true;
+                            cur_->bezier = bezier;
+                            return SBML_SEGMENT;
+                        }
+
+                        case SBML_SEGMENT:
+                            if(tag == "start")
+                                cur_->s = point(a);
+                            else if(tag == "end")
+                                cur_->e = point(a);
+                            else if(cur_->bezier && tag == "basePoint1")
+                                cur_->b1 = point(a);
+                            else if(cur_->bezier && tag == "basePoint2")
+                                cur_->b2 = point(a);
+                            return SBML_SKIP;
+
+                        default:
+                            return SBML_SKIP;
+                    }
+                }
+
+                ImportData::Glyph newGlyph(const XMLAttributes& a, const char* target) {
+                    ImportData::Glyph g;
+                    g.id = str(a.find("id"));
+                    g.target = str(a.find(target));
+                    g.x = g.y = g.w = g.h = 0;
+                    return g;
+                }
+
+                /// The glyph whose bounding box is read next (stays put until the next glyph)
+                template <class G>
+                void setBox(G& g) {
+                    box_[0] = &g.x;
+                    box_[1] = &g.y;
+                    box_[2] = &g.w;
+                    box_[3] = &g.h;
+                }
+
+                Point point(const XMLAttributes& a) {
+                    return Point(num(a.find("x")), num(a.find("y")));
+                }
+
+                ImportData& d_;
+                std::vector<SBMLState> stack_;
+                uint64 skip_;
+                bool unsupported_;
+                bool hasmodel_;
+                uint64 nlayouts_;
+                RxnRoleType refrole_;
+                Real* box_[4];
+                /// Segment of the current curve, segment being read
+                ImportData::Segment* seg_;
+                ImportData::Segment* cur_;
+                ImportData::Segment dummy_;
+                uint64 nsegs_;
+        };
+
+    }
+
+    bool readImportData(const char* text, ImportData& d) {
+        SBMLImportHandler h(d);
+        XMLSaxReader reader;
+        if(!reader.parse(text, h) || h.isUnsupported() || !h.hasModel())
+            return false;
+        if(h.getNumLayouts() > 1)
+            gf_emitWarn("Warning: multiple layouts. Using first");
+        return true;
+    }
+
+}
@@ -0,0 +1,67 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file stream.h
+ * @brief Reading SBML without libSBML
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_SBML_STREAM_H_
+#define __SBNW_SBML_STREAM_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/network/import.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+namespace Graphfab {
+
+    /** @brief Read the parts of an SBML document a network is built from
+     * @details Streams through the text once, collecting compartments,
+     * species, reactions and the first layout without building a libSBML
+     * document. Everything else is skipped unread. The document is not
+     * validated.
+     * @param[in] text The null-terminated SBML text
+     * @param[out] d The model contents
+     * @return False if the document uses something only libSBML can
+     * interpret (level 1, undefined glyph roles, unknown curve segments,
+     * DOCTYPEs or other encodings) or is not well formed; @a d is then
+     * incomplete and the libSBML path should be used instead
+     */
+    _GraphfabExport bool readImportData(const char* text, ImportData& d);
+
+}
+
+#endif
+
+#endif
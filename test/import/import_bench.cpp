@@ -0,0 +1,185 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+// Times building a network from model contents. Usage:
+//   import_bench [model.xml] [number of species]
+// The model (default testcases/testbigmodel.xml) is loaded with
+// gf_loadLayoutfile; the synthetic models have the given number of species
+// (default 50000), about as many reactions and a layout in which a fifth of
+// the species have an alias.
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sstream>
+#include <chrono>
+
+#include "graphfab/interface/layout.h"
+#include "graphfab/network/import.h"
+
+using namespace Graphfab;
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string name(const char* prefix, size_t i) {
+  std::stringstream ss;
+  ss << prefix << i;
+  return ss.str();
+}
+
+static ImportData::Segment line(Real x0, Real y0, Real x1, Real y1) {
+  ImportData::Segment s;
+  s.set = true;
+  s.s = Graphfab::Point(x0, y0);
+  s.e = Graphfab::Point(x1, y1);
+  return s;
+}
+
+static void makeModel(size_t nspec, size_t ncomp, bool layout, ImportData& d) {
+  d.hasid = true;
+  d.id = "synthetic";
+  d.level = 3;
+  d.version = 1;
+
+  d.comps.resize(ncomp);
+  for (size_t i=0; i<ncomp; ++i)
+    d.comps[i].id = name("C", i), d.comps[i].sbo = -1;
+
+  d.species.resize(nspec);
+  for (size_t i=0; i<nspec; ++i) {
+    d.species[i].id = name("S", i);
+    d.species[i].name = d.species[i].id;
+    d.species[i].comp = ncomp ? d.comps[i % ncomp].id : "";
+  }
+
+  // A + B -> C, every third one with a modifier
+  d.rxns.resize(nspec);
+  for (size_t i=0; i<nspec; ++i) {
+    ImportData::Rxn& r = d.rxns[i];
+    r.id = name("J", i);
+    r.comp = ncomp ? d.comps[i % ncomp].id : "";
+    r.refs.resize(i % 3 ? 3 : 4);
+    r.refs[0].species = d.species[i].id, r.refs[0].role = RXN_ROLE_SUBSTRATE;
+    r.refs[1].species = d.species[(i*7+1) % nspec].id, r.refs[1].role = RXN_ROLE_SUBSTRATE;
+    r.refs[2].species = d.species[(i*13+5) % nspec].id, r.refs[2].role = RXN_ROLE_PRODUCT;
+    if (!(i % 3))
+      r.refs[3].species = d.species[(i*31+2) % nspec].id, r.refs[3].role = RXN_ROLE_MODIFIER;
+  }
+
+  d.haslayout = layout;
+  if (!layout)
+    return;
+  d.width = d.height = 10000;
+
+  d.compglyphs.resize(ncomp);
+  for (size_t i=0; i<ncomp; ++i) {
+    ImportData::Glyph& g = d.compglyphs[i];
+    g.id = name("CG", i);
+    g.target = d.comps[i].id;
+    g.x = g.y = 0;
+    g.w = g.h = 10000;
+  }
+
+  // one glyph per species, a second one for every fifth species
+  for (size_t i=0; i<nspec; ++i) {
+    for (size_t k=0; k < (i % 5 ? 1u : 2u); ++k) {
+      ImportData::Glyph g;
+      g.id = name(k ? "SGa" : "SG", i);
+      g.target = d.species[i].id;
+      g.x = (Real)(i % 100) * 100;
+      g.y = (Real)(i / 100) * 20 + k*10;
+      g.w = 40;
+      g.h = 20;
+      d.specglyphs.push_back(g);
+    }
+  }
+
+  d.rxnglyphs.resize(nspec);
+  for (size_t i=0; i<nspec; ++i) {
+    const ImportData::Rxn& r = d.rxns[i];
+    ImportData::RxnGlyph& g = d.rxnglyphs[i];
+    g.id = name("RG", i);
+    g.rxn = r.id;
+    g.x = g.y = g.w = g.h = 0;
+    g.curve = line(0, 0, (Real)(i % 100) * 100 + 50, (Real)(i / 100) * 20);
+    g.refs.resize(r.refs.size());
+    for (size_t j=0; j<r.refs.size(); ++j) {
+      ImportData::SpecRefGlyph& s = g.refs[j];
+      size_t spec = (size_t)atol(r.refs[j].species.c_str() + 1);
+      // the substrate of every fifth reaction is drawn with the species' alias
+      s.glyph = name(j == 0 && !(spec % 5) ? "SGa" : "SG", spec);
+      s.ref = r.refs[j].species;
+      s.role = r.refs[j].role;
+      s.curve = line(g.curve.e.x, g.curve.e.y, (Real)j, (Real)j);
+    }
+  }
+}
+
+static void benchSynthetic(size_t nspec, size_t ncomp, bool layout) {
+  ImportData d;
+  makeModel(nspec, ncomp, layout, d);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Network* net = networkFromImport(d);
+  double t = seconds(start);
+
+  printf("synthetic %lu species, %lu compartments, %s: %lu nodes, %lu reactions in %.3f s\n",
+    (unsigned long)nspec, (unsigned long)ncomp, layout ? "with layout" : "no layout",
+    (unsigned long)net->getTotalNumNodes(), (unsigned long)net->getTotalNumRxns(), t);
+  delete net;
+}
+
+int main(int argc, char* argv[]) {
+  const char* path = argc > 1 ? argv[1] : "testcases/testbigmodel.xml";
+  size_t nspec = argc > 2 ? (size_t)atol(argv[2]) : 50000;
+
+  {
+    const int reps = 100;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i=0; i<reps; ++i) {
+      gf_layoutInfo* l = gf_loadLayoutfile(path);
+      if (!l) {
+        fprintf(stderr, "Could not load %s\n", path);
+        return 1;
+      }
+      gf_freeLayoutInfoHierarch(l);
+    }
+    printf("%s: %.3f ms per load\n", path, seconds(start) / reps * 1000);
+  }
+
+  benchSynthetic(nspec, 0, false);
+  benchSynthetic(nspec, 0, true);
+  benchSynthetic(nspec, 10, true);
+  benchSynthetic(nspec, 1000, true);
+
+  return 0;
+}
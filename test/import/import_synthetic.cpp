@@ -0,0 +1,269 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+//== BEGINNING OF CODE ===============================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stdlib.h>
+#include <sstream>
+
+#include "graphfab/network/import.h"
+#include "gtest/gtest.h"
+
+using namespace Graphfab;
+
+static const size_t kSpecies = 200;
+
+static std::string name(const char* prefix, size_t i) {
+  std::stringstream ss;
+  ss << prefix << i;
+  return ss.str();
+}
+
+// species glyph (k = 1 for the alias) and reaction centre
+static Graphfab::Point glyphPos(size_t i, size_t k) {
+  return Graphfab::Point((Real)(i % 20) * 100, (Real)(i / 20) * 50 + k*25);
+}
+
+static Graphfab::Point rxnPos(size_t i) {
+  return Graphfab::Point((Real)(i % 20) * 100 + 50, (Real)(i / 20) * 50);
+}
+
+static ImportData::Segment line(Graphfab::Point s, Graphfab::Point e) {
+  ImportData::Segment c;
+  c.set = true;
+  c.s = s;
+  c.e = e;
+  return c;
+}
+
+// same shape as the import benchmark: A + B -> C, every third reaction with
+// a modifier, and a second glyph for every fifth species used by the
+// reactions it is the first substrate of
+static void makeModel(size_t nspec, size_t ncomp, bool layout, ImportData& d) {
+  d.hasid = true;
+  d.id = "synthetic";
+
+  d.comps.resize(ncomp);
+  for (size_t i=0; i<ncomp; ++i)
+    d.comps[i].id = name("C", i), d.comps[i].sbo = -1;
+  // has no species, so it is left out
+  if (ncomp) {
+    ImportData::Comp empty;
+    empty.id = "Cempty";
+    empty.sbo = -1;
+    d.comps.push_back(empty);
+  }
+
+  d.species.resize(nspec);
+  for (size_t i=0; i<nspec; ++i) {
+    d.species[i].id = name("S", i);
+    d.species[i].name = name("Species ", i);
+    d.species[i].comp = ncomp ? d.comps[i % ncomp].id : "";
+  }
+
+  d.rxns.resize(nspec);
+  for (size_t i=0; i<nspec; ++i) {
+    ImportData::Rxn& r = d.rxns[i];
+    r.id = name("J", i);
+    r.comp = ncomp ? d.comps[i % ncomp].id : "";
+    r.refs.resize(i % 3 ? 3 : 4);
+    r.refs[0].species = d.species[i].id, r.refs[0].role = RXN_ROLE_SUBSTRATE;
+    r.refs[1].species = d.species[(i*7+1) % nspec].id, r.refs[1].role = RXN_ROLE_SUBSTRATE;
+    r.refs[2].species = d.species[(i*13+5) % nspec].id, r.refs[2].role = RXN_ROLE_PRODUCT;
+    if (!(i % 3))
+      r.refs[3].species = d.species[(i*31+2) % nspec].id, r.refs[3].role = RXN_ROLE_MODIFIER;
+  }
+
+  d.haslayout = layout;
+  if (!layout)
+    return;
+
+  for (size_t i=0; i<ncomp; ++i) {
+    ImportData::Glyph g;
+    g.id = name("CG", i);
+    g.target = d.comps[i].id;
+    g.x = g.y = 0;
+    g.w = g.h = 2000;
+    d.compglyphs.push_back(g);
+  }
+
+  for (size_t i=0; i<nspec; ++i) {
+    for (size_t k=0; k < (i % 5 ? 1u : 2u); ++k) {
+      ImportData::Glyph g;
+      g.id = name(k ? "SGa" : "SG", i);
+      g.target = d.species[i].id;
+      g.x = glyphPos(i, k).x - 20;
+      g.y = glyphPos(i, k).y - 10;
+      g.w = 40;
+      g.h = 20;
+      d.specglyphs.push_back(g);
+    }
+  }
+
+  d.rxnglyphs.resize(nspec);
+  for (size_t i=0; i<nspec; ++i) {
+    const ImportData::Rxn& r = d.rxns[i];
+    ImportData::RxnGlyph& g = d.rxnglyphs[i];
+    g.id = name("RG", i);
+    g.rxn = r.id;
+    g.x = g.y = g.w = g.h = 0;
+    g.curve = line(Graphfab::Point(0, 0), rxnPos(i));
+    g.refs.resize(r.refs.size());
+    for (size_t j=0; j<r.refs.size(); ++j) {
+      ImportData::SpecRefGlyph& s = g.refs[j];
+      size_t spec = (size_t)atol(r.refs[j].species.c_str() + 1);
+      s.glyph = name(j == 0 && !(spec % 5) ? "SGa" : "SG", spec);
+      s.ref = r.refs[j].species;
+      s.role = r.refs[j].role;
+      s.curve = line(rxnPos(i), glyphPos(spec, j == 0 && !(spec % 5)));
+    }
+  }
+}
+
+static size_t numAliased(size_t nspec) {
+  return (nspec + 4) / 5;
+}
+
+static void checkModel(const ImportData& d, Network* net, size_t ncomp) {
+  // id lookups & containing compartments
+  ASSERT_EQ(ncomp, net->getTotalNumComps());
+  ASSERT_EQ(d.rxns.size(), net->getTotalNumRxns());
+  for (size_t i=0; i<d.species.size(); ++i) {
+    Node* n = net->findNodeById(d.species[i].id);
+    ASSERT_TRUE(n != NULL) << d.species[i].id;
+    EXPECT_EQ(d.species[i].name, n->getName());
+    Graphfab::Compartment* c = net->findContainingCompartment(n);
+    if (ncomp) {
+      ASSERT_TRUE(c != NULL) << d.species[i].id;
+      EXPECT_EQ(d.species[i].comp, c->getId());
+    } else
+      EXPECT_TRUE(c == NULL);
+  }
+
+  // references in model order, with their roles
+  for (size_t i=0; i<d.rxns.size(); ++i) {
+    const ImportData::Rxn& x = d.rxns[i];
+    Graphfab::Reaction* r = net->findReactionById(x.id);
+    ASSERT_TRUE(r != NULL) << x.id;
+    ASSERT_EQ(x.refs.size(), (size_t)(r->NodesEnd() - r->NodesBegin())) << x.id;
+    for (size_t j=0; j<x.refs.size(); ++j) {
+      EXPECT_EQ(x.refs[j].species, (r->NodesBegin() + j)->first->getId()) << x.id;
+      EXPECT_EQ(x.refs[j].role, (r->NodesBegin() + j)->second) << x.id;
+    }
+    Graphfab::Compartment* c = net->findContainingCompartment(r);
+    if (ncomp) {
+      ASSERT_TRUE(c != NULL) << x.id;
+      EXPECT_EQ(x.comp, c->getId());
+    }
+  }
+}
+
+TEST(import_synthetic, model_only) {
+  for (size_t ncomp=0; ncomp<=10; ncomp+=10) {
+    ImportData d;
+    makeModel(kSpecies, ncomp, false, d);
+    Network* net = networkFromImport(d);
+    EXPECT_EQ("synthetic", net->getId());
+    EXPECT_EQ(kSpecies, net->getTotalNumNodes());
+    checkModel(d, net, ncomp);
+    EXPECT_FALSE(net->isLayoutSpecified());
+    delete net;
+  }
+}
+
+TEST(import_synthetic, layout) {
+  for (size_t ncomp=0; ncomp<=10; ncomp+=10) {
+    ImportData d;
+    makeModel(kSpecies, ncomp, true, d);
+    Network* net = networkFromImport(d);
+    EXPECT_EQ(kSpecies + numAliased(kSpecies), net->getTotalNumNodes());
+    checkModel(d, net, ncomp);
+    EXPECT_TRUE(net->isLayoutSpecified());
+
+    // one node per glyph, at the glyph's centre; the first glyph of a species is its node
+    for (size_t i=0; i<kSpecies; ++i) {
+      for (size_t k=0; k < (i % 5 ? 1u : 2u); ++k) {
+        Node* n = net->findNodeByGlyph(name(k ? "SGa" : "SG", i));
+        ASSERT_TRUE(n != NULL);
+        EXPECT_EQ(d.species[i].id, n->getId());
+        EXPECT_EQ(i % 5 == 0, n->isAlias());
+        EXPECT_DOUBLE_EQ(glyphPos(i, k).x, n->getCentroid().x);
+        EXPECT_DOUBLE_EQ(glyphPos(i, k).y, n->getCentroid().y);
+        EXPECT_DOUBLE_EQ(40., n->getWidth());
+        EXPECT_DOUBLE_EQ(20., n->getHeight());
+        if (!k)
+          EXPECT_EQ(net->findNodeById(d.species[i].id), n);
+      }
+    }
+
+    // references point at the nodes of their glyphs, one curve per reference
+    for (size_t i=0; i<kSpecies; ++i) {
+      const ImportData::RxnGlyph& g = d.rxnglyphs[i];
+      Graphfab::Reaction* r = net->findReactionById(g.rxn);
+      EXPECT_DOUBLE_EQ(rxnPos(i).x, r->getCentroid().x);
+      EXPECT_DOUBLE_EQ(rxnPos(i).y, r->getCentroid().y);
+      ASSERT_EQ(g.refs.size(), r->getNumCurves());
+      for (size_t j=0; j<g.refs.size(); ++j) {
+        Node* n = net->findNodeByGlyph(g.refs[j].glyph);
+        EXPECT_EQ(n, (r->NodesBegin() + j)->first) << g.rxn;
+        RxnBezier* c = r->getCurve(j);
+        EXPECT_EQ(n, g.refs[j].role == RXN_ROLE_PRODUCT ? c->ne : c->ns) << g.rxn;
+      }
+    }
+    delete net;
+  }
+}
+
+TEST(import_synthetic, unresolved_ids_throw) {
+  {
+    ImportData d;
+    makeModel(20, 1, false, d);
+    d.rxns[3].refs[1].species = "nosuchspecies";
+    EXPECT_THROW(networkFromImport(d), InvalidParameterException);
+  }
+  {
+    ImportData d;
+    makeModel(20, 1, true, d);
+    d.specglyphs[4].target = "nosuchspecies";
+    EXPECT_THROW(networkFromImport(d), InvalidParameterException);
+  }
+  {
+    ImportData d;
+    makeModel(20, 1, true, d);
+    d.rxnglyphs[2].rxn = "nosuchreaction";
+    EXPECT_THROW(networkFromImport(d), InvalidParameterException);
+  }
+  {
+    ImportData d;
+    makeModel(20, 1, true, d);
+    d.rxnglyphs[2].refs[0].glyph = "nosuchglyph";
+    EXPECT_THROW(networkFromImport(d), InvalidParameterException);
+  }
+}
@@ -0,0 +1,250 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+//== BEGINNING OF CODE ===============================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "graphfab/interface/layout.h"
+#include "graphfab/network/network.h"
+#include "graphfab/sbml/autolayoutSBML.h"
+#include "graphfab/sbml/stream.h"
+#include "gtest/gtest.h"
+
+using Graphfab::Network;
+using Graphfab::Node;
+
+// everything under testcases/
+static const char* kModels[] = {
+  "AntimonyPowerLaw.xml",
+  "BorisEJB.xml",
+  "ConservedCycles.xml",
+  "Equilib.xml",
+  "EquilibRaw.xml",
+  "EquilibRaw_wlayout.xml",
+  "GlycolysisOriginal.xml",
+  "testbigmodel.xml",
+  "official/example1.xml",
+  "official/example2.xml",
+  "official/example3.xml",
+  "official/example4.xml",
+  "official/example5.xml",
+  "official/example6.xml",
+  "internal/EquilibRaw_wlayout-DrawNetwork-vs2010.xml",
+  "internal/bounding_box.xml",
+  "internal/example2.xml",
+  "internal/twocompsys-ex-with-layout-written.xml",
+  "internal/twocompsys-ex.xml",
+  NULL
+};
+
+static std::string testcase(const char* name) {
+  return std::string(SBNW_TESTCASES_DIR "/") + name;
+}
+
+static std::string readFile(const std::string& path) {
+  std::ifstream f(path.c_str());
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+// a copy of @a text with the first @a from replaced by @a to
+static std::string replace(const std::string& text, const std::string& from, const std::string& to) {
+  std::string r(text);
+  size_t k = r.find(from);
+  EXPECT_NE(std::string::npos, k) << from;
+  if (k != std::string::npos)
+    r.replace(k, from.size(), to);
+  return r;
+}
+
+// what the libSBML path alone makes of a document
+static gf_layoutInfo* loadReference(gf_SBMLModel* mod) {
+  if (!mod)
+    return NULL;
+  gf_layoutInfo* l = NULL;
+  try {
+    l = gf_processLayout(mod);
+  } catch (const Graphfab::Exception&) {
+  }
+  gf_freeSBMLModel(mod);
+  return l;
+}
+
+static void expectNear(const Graphfab::Point& a, const Graphfab::Point& b, const std::string& what) {
+  EXPECT_NEAR(a.x, b.x, 1e-9) << what;
+  EXPECT_NEAR(a.y, b.y, 1e-9) << what;
+}
+
+static std::string compId(Network* net, const Graphfab::NetworkElement* e) {
+  Graphfab::Compartment* c = net->findContainingCompartment(e);
+  return c ? c->getId() : std::string("(none)");
+}
+
+// same elements in the same order, with the same ids, compartments, positions & curves
+static void expectSameLayout(gf_layoutInfo* a, gf_layoutInfo* b) {
+  ASSERT_EQ(a == NULL, b == NULL);
+  if (!a)
+    return;
+  EXPECT_EQ(a->level, b->level);
+  EXPECT_EQ(a->version, b->version);
+  gf_canvas ca = gf_getCanvas(a), cb = gf_getCanvas(b);
+  EXPECT_EQ(gf_canvGetWidth(&ca), gf_canvGetWidth(&cb));
+  EXPECT_EQ(gf_canvGetHeight(&ca), gf_canvGetHeight(&cb));
+
+  Network* x = (Network*)a->net;
+  Network* y = (Network*)b->net;
+  EXPECT_EQ(x->getId(), y->getId());
+  EXPECT_EQ(x->isLayoutSpecified(), y->isLayoutSpecified());
+
+  ASSERT_EQ(x->getTotalNumComps(), y->getTotalNumComps());
+  for (Network::CompIt i=x->CompsBegin(), j=y->CompsBegin(); i!=x->CompsEnd(); ++i, ++j) {
+    EXPECT_EQ((*i)->getId(), (*j)->getId());
+    EXPECT_EQ((*i)->getGlyph(), (*j)->getGlyph());
+    expectNear((*i)->getMin(), (*j)->getMin(), (*i)->getId());
+    expectNear((*i)->getMax(), (*j)->getMax(), (*i)->getId());
+  }
+
+  ASSERT_EQ(x->getTotalNumNodes(), y->getTotalNumNodes());
+  for (Network::NodeIt i=x->NodesBegin(), j=y->NodesBegin(); i!=x->NodesEnd(); ++i, ++j) {
+    const std::string& id = (*i)->getGlyph();
+    EXPECT_EQ((*i)->getId(), (*j)->getId());
+    EXPECT_EQ((*i)->getName(), (*j)->getName()) << id;
+    EXPECT_EQ((*i)->getGlyph(), (*j)->getGlyph());
+    EXPECT_EQ((*i)->isAlias(), (*j)->isAlias()) << id;
+    EXPECT_EQ(compId(x, *i), compId(y, *j)) << id;
+    expectNear((*i)->getCentroid(), (*j)->getCentroid(), id);
+    EXPECT_NEAR((*i)->getWidth(), (*j)->getWidth(), 1e-9) << id;
+    EXPECT_NEAR((*i)->getHeight(), (*j)->getHeight(), 1e-9) << id;
+  }
+
+  ASSERT_EQ(x->getTotalNumRxns(), y->getTotalNumRxns());
+  for (Network::RxnIt i=x->RxnsBegin(), j=y->RxnsBegin(); i!=x->RxnsEnd(); ++i, ++j) {
+    Graphfab::Reaction* r = *i;
+    Graphfab::Reaction* s = *j;
+    const std::string& id = r->getId();
+    EXPECT_EQ(id, s->getId());
+    EXPECT_EQ(compId(x, r), compId(y, s)) << id;
+    expectNear(r->getCentroid(), s->getCentroid(), id);
+
+    ASSERT_EQ(r->NodesEnd() - r->NodesBegin(), s->NodesEnd() - s->NodesBegin()) << id;
+    for (Graphfab::Reaction::NodeIt p=r->NodesBegin(), q=s->NodesBegin(); p!=r->NodesEnd(); ++p, ++q) {
+      EXPECT_EQ(p->first->getGlyph(), q->first->getGlyph()) << id;
+      EXPECT_EQ(p->second, q->second) << id;
+    }
+
+    ASSERT_EQ(r->getNumCurves(), s->getNumCurves()) << id;
+    for (size_t k=0; k<r->getNumCurves(); ++k) {
+      Graphfab::RxnBezier* c = r->getCurve(k);
+      Graphfab::RxnBezier* d = s->getCurve(k);
+      EXPECT_EQ(c->getRole(), d->getRole()) << id;
+      expectNear(c->s, d->s, id);
+      expectNear(c->c1, d->c1, id);
+      expectNear(c->c2, d->c2, id);
+      expectNear(c->e, d->e, id);
+    }
+  }
+}
+
+static void freeLayout(gf_layoutInfo* l) {
+  if (l)
+    gf_freeLayoutInfoHierarch(l);
+}
+
+TEST(import_stream, matches_libsbml) {
+  for (const char** name=kModels; *name; ++name) {
+    SCOPED_TRACE(*name);
+    std::string path = testcase(*name);
+    gf_layoutInfo* l = gf_loadLayoutfile(path.c_str());
+    gf_layoutInfo* ref = loadReference(gf_loadSBMLfile(path.c_str()));
+    // the streaming reader does not validate, so it may read what libSBML rejects
+    if (ref)
+      expectSameLayout(l, ref);
+    freeLayout(l);
+    freeLayout(ref);
+  }
+}
+
+TEST(import_stream, matches_libsbml_from_buffer) {
+  for (const char** name=kModels; *name; ++name) {
+    SCOPED_TRACE(*name);
+    std::string text = readFile(testcase(*name));
+    gf_layoutInfo* l = gf_loadLayoutbuf(text.c_str());
+    gf_layoutInfo* ref = loadReference(gf_loadSBMLbuf(text.c_str()));
+    // the streaming reader does not validate, so it may read what libSBML rejects
+    if (ref)
+      expectSameLayout(l, ref);
+    freeLayout(l);
+    freeLayout(ref);
+  }
+}
+
+// documents the streaming reader leaves to libSBML, made from a model it reads itself
+TEST(import_stream, fallback) {
+  const std::string base = readFile(testcase("official/example1.xml"));
+  Graphfab::ImportData d;
+  ASSERT_TRUE(Graphfab::readImportData(base.c_str(), d));
+
+  const char* xmldecl = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+  std::string cases[] = {
+    // level 1
+    replace(base, "level=\"2\" version=\"1\"", "level=\"1\" version=\"2\""),
+    replace(base, xmldecl, std::string(xmldecl) + "\n<!DOCTYPE sbml>"),
+    replace(base, "encoding=\"UTF-8\"", "encoding=\"ISO-8859-1\""),
+    replace(base, "<model id=\"TestModel\">", "<model id=\"TestModel\" name=\"&nosuch;\">"),
+    replace(base, "role=\"product\"", "role=\"undefined\""),
+    replace(base, "xsi:type=\"LineSegment\"", "xsi:type=\"Arc\""),
+    // malformed
+    replace(base, "</listOfSpeciesGlyphs>", ""),
+    base.substr(0, base.size() / 2),
+  };
+  for (size_t k=0; k<sizeof(cases)/sizeof(cases[0]); ++k) {
+    SCOPED_TRACE(k);
+    Graphfab::ImportData e;
+    EXPECT_FALSE(Graphfab::readImportData(cases[k].c_str(), e));
+
+    gf_layoutInfo* l = gf_loadLayoutbuf(cases[k].c_str());
+    gf_layoutInfo* ref = loadReference(gf_loadSBMLbuf(cases[k].c_str()));
+    expectSameLayout(l, ref);
+    freeLayout(l);
+    freeLayout(ref);
+  }
+}
+
+TEST(import_stream, malformed_xml_fails) {
+  const std::string base = readFile(testcase("official/example1.xml"));
+  std::string text = replace(base, "</model>", "");
+  EXPECT_TRUE(gf_loadLayoutbuf(text.c_str()) == NULL);
+  text = base.substr(0, base.size() / 2);
+  EXPECT_TRUE(gf_loadLayoutbuf(text.c_str()) == NULL);
+}
@@ -0,0 +1,124 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#include "graphfab/interface/layout.h"
+#include "graphfab/layout/fr.h"
+#include "gtest/gtest.h"
+
+#if __cplusplus >= 201103L
+# define SBNW_TEST_NOTHROW noexcept
+#else
+# define SBNW_TEST_NOTHROW throw()
+#endif
+
+// count every C++ heap allocation while enabled
+static bool count_allocs = false;
+static unsigned long num_allocs = 0;
+
+void* operator new(size_t size) {
+  if (count_allocs)
+    ++num_allocs;
+  void* p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) SBNW_TEST_NOTHROW {
+  free(p);
+}
+
+void operator delete[](void* p) SBNW_TEST_NOTHROW {
+  free(p);
+}
+
+static unsigned long countLayoutAllocs(fr_options opt, gf_layoutInfo* l, gf_layoutWorkspace* ws) {
+  num_allocs = 0;
+  count_allocs = true;
+  gf_doLayoutAlgorithmWorkspace(opt, l, ws);
+  count_allocs = false;
+  return num_allocs;
+}
+
+static gf_node addNode(gf_network* nw, int i) {
+  char id[32];
+  sprintf(id, "S%d", i);
+  return gf_nw_newNode(nw, id, id, NULL);
+}
+
+static void addReaction(gf_network* nw, int i, gf_node* s, gf_node* p) {
+  char id[32];
+  sprintf(id, "J%d", i);
+  gf_reaction r = gf_nw_newReaction(nw, id, id);
+  gf_nw_connectNode(nw, s, &r, GF_ROLE_SUBSTRATE);
+  gf_nw_connectNode(nw, p, &r, GF_ROLE_PRODUCT);
+}
+
+TEST(layout_workspace, steady_state_no_alloc) {
+  gf_layoutInfo l = gf_layoutInfo_new(3, 1, 1024, 1024);
+  gf_network nw = gf_getNetwork(&l);
+
+  const int n = 30;
+  gf_node nodes[n+1];
+  for (int i=0; i<n; ++i)
+    nodes[i] = addNode(&nw, i);
+  for (int i=0; i<n; ++i)
+    addReaction(&nw, i, &nodes[i], &nodes[(i*7+3) % n]);
+
+  fr_options opt;
+  gf_getLayoutOptDefaults(&opt);
+  opt.prerandomize = 1;
+
+  gf_layoutWorkspace ws = gf_layoutWorkspace_new();
+
+  // first call sizes the buffers & builds the curves
+  gf_doLayoutAlgorithmWorkspace(opt, &l, &ws);
+
+  EXPECT_EQ(0ul, countLayoutAllocs(opt, &l, &ws));
+  EXPECT_EQ(0ul, countLayoutAllocs(opt, &l, &ws));
+
+  // grow the network: one warm-up call, then steady state again
+  nodes[n] = addNode(&nw, n);
+  addReaction(&nw, n, &nodes[n], &nodes[0]);
+  gf_doLayoutAlgorithmWorkspace(opt, &l, &ws);
+
+  EXPECT_EQ(0ul, countLayoutAllocs(opt, &l, &ws));
+
+  gf_releaseLayoutWorkspace(&ws);
+}
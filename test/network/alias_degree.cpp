@@ -0,0 +1,214 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+//== BEGINNING OF CODE ===============================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <map>
+#include <string>
+
+#include "graphfab/interface/layout.h"
+#include "graphfab/network/network.h"
+#include "gtest/gtest.h"
+
+using Graphfab::Network;
+using Graphfab::Node;
+
+static Network* getNet(gf_layoutInfo* l) {
+  return (Network*)l->net;
+}
+
+typedef std::map<std::string, gf_node> NodeMap;
+
+static void addNodes(gf_network* nw, NodeMap& nodes, const char* ids) {
+  for (const char* p=ids; *p; ++p) {
+    std::string id(1, *p);
+    nodes[id] = gf_nw_newNode(nw, id.c_str(), id.c_str(), NULL);
+  }
+}
+
+// substrates & products are given as strings of one-letter ids
+static void addReaction(gf_network* nw, NodeMap& nodes, const char* id, const char* s, const char* p) {
+  gf_reaction r = gf_nw_newReaction(nw, id, id);
+  for (; *s; ++s)
+    gf_nw_connectNode(nw, &nodes[std::string(1, *s)], &r, GF_ROLE_SUBSTRATE);
+  for (; *p; ++p)
+    gf_nw_connectNode(nw, &nodes[std::string(1, *p)], &r, GF_ROLE_PRODUCT);
+}
+
+// number of alias nodes standing in for species @a id
+static int countAliases(Network* net, const std::string& id) {
+  int n = 0;
+  for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i)
+    if ((*i)->isAlias() && (*i)->getId() == id)
+      ++n;
+  return n;
+}
+
+// the original (non-alias) node for species @a id
+static Node* original(Network* net, const std::string& id) {
+  for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i)
+    if (!(*i)->isAlias() && (*i)->getId() == id)
+      return *i;
+  return NULL;
+}
+
+// hub H feeds A..D, which are also joined in a chain without it
+static gf_layoutInfo makeHub() {
+  gf_layoutInfo l = gf_layoutInfo_new(3, 1, 1024, 1024);
+  gf_network nw = gf_getNetwork(&l);
+  NodeMap nodes;
+  addNodes(&nw, nodes, "HABCD");
+  addReaction(&nw, nodes, "J0", "H", "A");
+  addReaction(&nw, nodes, "J1", "H", "B");
+  addReaction(&nw, nodes, "J2", "H", "C");
+  addReaction(&nw, nodes, "J3", "H", "D");
+  addReaction(&nw, nodes, "J4", "A", "B");
+  addReaction(&nw, nodes, "J5", "B", "C");
+  addReaction(&nw, nodes, "J6", "C", "D");
+  return l;
+}
+
+// X is the only link between the clusters {A,B} and {C,D}
+static gf_layoutInfo makeBridge() {
+  gf_layoutInfo l = gf_layoutInfo_new(3, 1, 1024, 1024);
+  gf_network nw = gf_getNetwork(&l);
+  NodeMap nodes;
+  addNodes(&nw, nodes, "XABCD");
+  addReaction(&nw, nodes, "J0", "A", "B");
+  addReaction(&nw, nodes, "J1", "A", "X");
+  addReaction(&nw, nodes, "J2", "B", "X");
+  addReaction(&nw, nodes, "J3", "C", "D");
+  addReaction(&nw, nodes, "J4", "X", "C");
+  addReaction(&nw, nodes, "J5", "X", "D");
+  return l;
+}
+
+TEST(network_alias_degree, hub_keeps_one_reaction) {
+  gf_layoutInfo l = makeHub();
+  Network* net = getNet(&l);
+  int nsub = net->getNumConnectedSubgraphs();
+  ASSERT_EQ(1, nsub);
+
+  gf_aliasNodebyDegree(&l, 4);
+
+  // every edge of the hub but the last moves to an alias
+  EXPECT_EQ(3, countAliases(net, "H"));
+  Node* h = original(net, "H");
+  ASSERT_TRUE(h != NULL);
+  EXPECT_EQ(1u, h->degree());
+  EXPECT_EQ(1u, net->getConnectedReactions(h).size());
+  for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i)
+    if ((*i)->isAlias())
+      EXPECT_EQ(1u, (*i)->degree());
+  for (const char* p="ABCD"; *p; ++p)
+    EXPECT_EQ(0, countAliases(net, std::string(1, *p)));
+  EXPECT_EQ(8u, net->getTotalNumNodes());
+  EXPECT_EQ(nsub, net->getNumConnectedSubgraphs());
+}
+
+TEST(network_alias_degree, bridge_is_not_cut) {
+  gf_layoutInfo l = makeBridge();
+  Network* net = getNet(&l);
+  int nsub = net->getNumConnectedSubgraphs();
+  ASSERT_EQ(1, nsub);
+
+  gf_aliasNodebyDegree(&l, 4);
+
+  // one edge into each cluster may go, the other has to hold the clusters together
+  EXPECT_EQ(2, countAliases(net, "X"));
+  Node* x = original(net, "X");
+  ASSERT_TRUE(x != NULL);
+  EXPECT_EQ(2u, x->degree());
+  EXPECT_EQ(1, net->findReactionById("J1")->hasSpecies(x) + net->findReactionById("J2")->hasSpecies(x));
+  EXPECT_EQ(1, net->findReactionById("J4")->hasSpecies(x) + net->findReactionById("J5")->hasSpecies(x));
+  EXPECT_EQ(nsub, net->getNumConnectedSubgraphs());
+}
+
+TEST(network_alias_degree, pure_bridge_untouched) {
+  gf_layoutInfo l = gf_layoutInfo_new(3, 1, 1024, 1024);
+  gf_network nw = gf_getNetwork(&l);
+  NodeMap nodes;
+  addNodes(&nw, nodes, "AXB");
+  addReaction(&nw, nodes, "J0", "A", "X");
+  addReaction(&nw, nodes, "J1", "X", "B");
+  Network* net = getNet(&l);
+
+  gf_aliasNodebyDegree(&l, 2);
+
+  EXPECT_EQ(0, countAliases(net, "X"));
+  EXPECT_EQ(3u, net->getTotalNumNodes());
+  EXPECT_EQ(1, net->getNumConnectedSubgraphs());
+}
+
+TEST(network_alias_degree, threshold) {
+  // H has degree 4, G degree 3, every other species degree 2
+  gf_layoutInfo l = gf_layoutInfo_new(3, 1, 1024, 1024);
+  gf_network nw = gf_getNetwork(&l);
+  NodeMap nodes;
+  addNodes(&nw, nodes, "HABCDGEFI");
+  addReaction(&nw, nodes, "J0", "H", "A");
+  addReaction(&nw, nodes, "J1", "H", "B");
+  addReaction(&nw, nodes, "J2", "H", "C");
+  addReaction(&nw, nodes, "J3", "H", "D");
+  addReaction(&nw, nodes, "J4", "AB", "CD");
+  addReaction(&nw, nodes, "J5", "G", "E");
+  addReaction(&nw, nodes, "J6", "G", "F");
+  addReaction(&nw, nodes, "J7", "G", "I");
+  addReaction(&nw, nodes, "J8", "EF", "I");
+  Network* net = getNet(&l);
+  int nsub = net->getNumConnectedSubgraphs();
+  ASSERT_EQ(2, nsub);
+
+  gf_aliasNodebyDegree(&l, 5);
+  EXPECT_EQ(9u, net->getTotalNumNodes());
+
+  gf_aliasNodebyDegree(&l, 4);
+  EXPECT_EQ(3, countAliases(net, "H"));
+  EXPECT_EQ(0, countAliases(net, "G"));
+  EXPECT_EQ(nsub, net->getNumConnectedSubgraphs());
+
+  // aliases & the reduced hub are not picked up again
+  gf_aliasNodebyDegree(&l, 3);
+  EXPECT_EQ(3, countAliases(net, "H"));
+  EXPECT_EQ(2, countAliases(net, "G"));
+  for (const char* p="ABCDEFI"; *p; ++p)
+    EXPECT_EQ(0, countAliases(net, std::string(1, *p)));
+  EXPECT_EQ(14u, net->getTotalNumNodes());
+  EXPECT_EQ(nsub, net->getNumConnectedSubgraphs());
+}
+
+TEST(network_alias_degree, placed_nodes_skipped) {
+  gf_layoutInfo l = makeHub();
+  Network* net = getNet(&l);
+  original(net, "H")->setCentroid(100., 100.);
+  gf_aliasNodebyDegree(&l, 4);
+  EXPECT_EQ(0, countAliases(net, "H"));
+  EXPECT_EQ(5u, net->getTotalNumNodes());
+}
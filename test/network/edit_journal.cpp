@@ -0,0 +1,236 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+//== BEGINNING OF CODE ===============================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stdio.h>
+#include <vector>
+
+#include "graphfab/interface/layout.h"
+#include "graphfab/network/network.h"
+#include "gtest/gtest.h"
+
+using Graphfab::EditJournal;
+using Graphfab::Network;
+using Graphfab::Node;
+
+typedef std::vector< std::pair<Node*, Graphfab::RxnRoleType> > RefList;
+
+// A + B -> C (J0), B -> C (J1), C -> A (J2), all in compartment "c"
+struct Fixture {
+  gf_layoutInfo l;
+  gf_network nw;
+  gf_compartment c;
+  gf_node a, b, cc;
+  Network* net;
+};
+
+static void addReaction(Fixture& f, const char* id, gf_node* s1, gf_node* s2, gf_node* p) {
+  gf_reaction r = gf_nw_newReaction(&f.nw, id, id);
+  gf_nw_connectNode(&f.nw, s1, &r, GF_ROLE_SUBSTRATE);
+  if (s2)
+    gf_nw_connectNode(&f.nw, s2, &r, GF_ROLE_SUBSTRATE);
+  gf_nw_connectNode(&f.nw, p, &r, GF_ROLE_PRODUCT);
+}
+
+static void makeNetwork(Fixture& f) {
+  f.l = gf_layoutInfo_new(3, 1, 1024, 1024);
+  f.nw = gf_getNetwork(&f.l);
+  f.net = (Network*)f.nw.n;
+  f.c = gf_nw_newCompartment(&f.nw, "c", "c");
+  f.a = gf_nw_newNode(&f.nw, "A", "A", &f.c);
+  f.b = gf_nw_newNode(&f.nw, "B", "B", &f.c);
+  f.cc = gf_nw_newNode(&f.nw, "C", "C", &f.c);
+  addReaction(f, "J0", &f.a, &f.b, &f.cc);
+  addReaction(f, "J1", &f.b, NULL, &f.cc);
+  addReaction(f, "J2", &f.cc, NULL, &f.a);
+
+  ((Node*)f.a.n)->setCentroid(100., 100.);
+  ((Node*)f.b.n)->setCentroid(300., 100.);
+  ((Node*)f.cc.n)->setCentroid(200., 300.);
+  f.net->recalcCurveCPs();
+
+  // record from here on
+  f.net->getJournal().setEnabled(true);
+}
+
+static RefList refs(Network* net, const char* id) {
+  Graphfab::Reaction* r = net->findReactionById(id);
+  return RefList(r->NodesBegin(), r->NodesEnd());
+}
+
+static void expectAt(const Node* n, double x, double y) {
+  EXPECT_DOUBLE_EQ(x, n->getCentroid().x);
+  EXPECT_DOUBLE_EQ(y, n->getCentroid().y);
+}
+
+static uint64_t countAliases(Network* net) {
+  uint64_t n = 0;
+  for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i)
+    if ((*i)->isAlias())
+      ++n;
+  return n;
+}
+
+TEST(network_journal, consecutive_moves_coalesce) {
+  Fixture f;
+  makeNetwork(f);
+  Node* a = (Node*)f.a.n;
+
+  // one drag: every move merges into the same step
+  for (int i=1; i<=10; ++i)
+    a->setCentroid(100. + 10.*i, 100.);
+  expectAt(a, 200., 100.);
+  ASSERT_TRUE(gf_nw_canUndo(&f.nw));
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  expectAt(a, 100., 100.);
+  EXPECT_FALSE(gf_nw_canUndo(&f.nw));
+  EXPECT_EQ(1, gf_nw_redo(&f.nw));
+  expectAt(a, 200., 100.);
+
+  // sealing ends the drag, so the next move is a step of its own
+  gf_nw_sealEdit(&f.nw);
+  a->setCentroid(250., 100.);
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  expectAt(a, 200., 100.);
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  expectAt(a, 100., 100.);
+  EXPECT_FALSE(gf_nw_canUndo(&f.nw));
+}
+
+TEST(network_journal, alias_is_one_step) {
+  Fixture f;
+  makeNetwork(f);
+  Node* b = (Node*)f.b.n;
+  int nsub = f.net->getNumConnectedSubgraphs();
+
+  ASSERT_EQ(0, gf_node_alias(&f.b, &f.nw));
+  EXPECT_FALSE(f.net->containsNode(b));
+  EXPECT_EQ(4u, gf_nw_getNumNodes(&f.nw));
+  EXPECT_EQ(2u, countAliases(f.net));
+  EXPECT_EQ(nsub, f.net->getNumConnectedSubgraphs());
+
+  // a single undo puts the original back and drops every alias
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  EXPECT_FALSE(gf_nw_canUndo(&f.nw));
+  EXPECT_TRUE(f.net->containsNode(b));
+  EXPECT_EQ(3u, gf_nw_getNumNodes(&f.nw));
+  EXPECT_EQ(0u, countAliases(f.net));
+  EXPECT_EQ(b, refs(f.net, "J0").at(1).first);
+  EXPECT_EQ(b, refs(f.net, "J1").at(0).first);
+
+  // and a single redo aliases it again
+  EXPECT_EQ(1, gf_nw_redo(&f.nw));
+  EXPECT_FALSE(gf_nw_canRedo(&f.nw));
+  EXPECT_FALSE(f.net->containsNode(b));
+  EXPECT_EQ(4u, gf_nw_getNumNodes(&f.nw));
+  EXPECT_EQ(2u, countAliases(f.net));
+}
+
+TEST(network_journal, remove_node_undo_redo) {
+  Fixture f;
+  makeNetwork(f);
+  Node* b = (Node*)f.b.n;
+  Graphfab::Compartment* c = (Graphfab::Compartment*)f.c.c;
+  RefList j0 = refs(f.net, "J0");
+  RefList j1 = refs(f.net, "J1");
+
+  ASSERT_EQ(0, gf_nw_removeNode(&f.nw, &f.b));
+  EXPECT_FALSE(f.net->containsNode(b));
+  EXPECT_TRUE(f.net->getJournal().holds(b));
+  EXPECT_EQ(2u, refs(f.net, "J0").size());
+  EXPECT_EQ(1u, refs(f.net, "J1").size());
+
+  // references come back at their old positions, with their roles
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  EXPECT_TRUE(f.net->containsNode(b));
+  EXPECT_TRUE(j0 == refs(f.net, "J0"));
+  EXPECT_TRUE(j1 == refs(f.net, "J1"));
+  EXPECT_EQ(c, f.net->findContainingCompartment(b));
+  EXPECT_TRUE(c->containsElt(b));
+
+  EXPECT_EQ(1, gf_nw_redo(&f.nw));
+  EXPECT_FALSE(f.net->containsNode(b));
+  EXPECT_FALSE(c->containsElt(b));
+  EXPECT_EQ(2u, refs(f.net, "J0").size());
+  EXPECT_EQ(1u, refs(f.net, "J1").size());
+
+  // once more, to check the saved references survive a redo
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  EXPECT_TRUE(j0 == refs(f.net, "J0"));
+  EXPECT_TRUE(j1 == refs(f.net, "J1"));
+  EXPECT_EQ(c, f.net->findContainingCompartment(b));
+}
+
+TEST(network_journal, trim_frees_dropped_elements) {
+  Fixture f;
+  makeNetwork(f);
+  EditJournal& j = f.net->getJournal();
+  Node* a = (Node*)f.a.n;
+  Node* b = (Node*)f.b.n;
+
+  ASSERT_EQ(0, gf_nw_removeNode(&f.nw, &f.a));
+  ASSERT_EQ(0, gf_nw_removeNode(&f.nw, &f.b));
+  EXPECT_TRUE(j.holds(a));
+  EXPECT_TRUE(j.holds(b));
+  EXPECT_GT(j.getMemoryUsage(), 0u);
+  uint64_t live = f.net->getArena()->getNumLive();
+
+  // too small for any step: the history empties & the removed nodes go
+  gf_nw_setJournalMemoryLimit(&f.nw, 1);
+  EXPECT_FALSE(gf_nw_canUndo(&f.nw));
+  EXPECT_EQ(0u, j.getMemoryUsage());
+  EXPECT_FALSE(j.holds(a));
+  EXPECT_FALSE(j.holds(b));
+  EXPECT_EQ(live - 2, f.net->getArena()->getNumLive());
+}
+
+TEST(network_journal, new_edit_discards_redo) {
+  Fixture f;
+  makeNetwork(f);
+  EditJournal& j = f.net->getJournal();
+  uint64_t live = f.net->getArena()->getNumLive();
+
+  gf_node d = gf_nw_newNode(&f.nw, "D", "D", NULL);
+  Node* dn = (Node*)d.n;
+  EXPECT_EQ(live + 1, f.net->getArena()->getNumLive());
+  EXPECT_EQ(1, gf_nw_undo(&f.nw));
+  EXPECT_FALSE(f.net->containsNode(dn));
+  // only the redo step can bring it back
+  EXPECT_TRUE(j.holds(dn));
+  EXPECT_TRUE(gf_nw_canRedo(&f.nw));
+
+  ((Node*)f.a.n)->setCentroid(150., 150.);
+  EXPECT_FALSE(gf_nw_canRedo(&f.nw));
+  EXPECT_EQ(0, gf_nw_redo(&f.nw));
+  EXPECT_FALSE(j.holds(dn));
+  EXPECT_EQ(live, f.net->getArena()->getNumLive());
+  EXPECT_EQ(3u, gf_nw_getNumNodes(&f.nw));
+}
@@ -0,0 +1,117 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+//== BEGINNING OF CODE ===============================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include "graphfab/interface/layout.h"
+#include "graphfab/network/network.h"
+#include "graphfab/sbml/autolayoutSBML.h"
+#include "gtest/gtest.h"
+
+#include <map>
+
+using Graphfab::Network;
+using Graphfab::Node;
+
+static const char* kModel = SBNW_TESTCASES_DIR "/testbigmodel.xml";
+
+static libsbml::Model* getModel(gf_SBMLModel* m) {
+  return ((libsbml::SBMLDocument*)m->pdoc)->getModel();
+}
+
+TEST(network_patch, unchanged_elements_keep_positions) {
+  gf_SBMLModel* mod = gf_loadSBMLfile(kModel);
+  ASSERT_TRUE(mod != NULL);
+  gf_layoutInfo* l = gf_processLayout(mod);
+  ASSERT_TRUE(l != NULL);
+  gf_randomizeLayout(l);
+  // the network was built from this model
+  EXPECT_EQ(0, gf_updateLayout(l, mod));
+
+  Network* net = (Network*)l->net;
+  std::map<const Node*, Graphfab::Point> nodepos;
+  for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i)
+    nodepos[*i] = (*i)->getCentroid();
+  std::map<const Graphfab::Reaction*, Graphfab::Point> rxnpos;
+  for (Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i)
+    rxnpos[*i] = (*i)->getCentroid();
+  const Graphfab::Reaction* removed = net->findReactionById("J19");
+  ASSERT_TRUE(removed != NULL);
+  rxnpos.erase(removed);
+
+  // edited copy: one reaction removed, one species and reaction added
+  gf_SBMLModel* edited = gf_loadSBMLfile(kModel);
+  ASSERT_TRUE(edited != NULL);
+  libsbml::Model* m = getModel(edited);
+  delete m->removeReaction("J19");
+  libsbml::Species* s = m->createSpecies();
+  s->setId("Node15");
+  s->setCompartment("compartment");
+  libsbml::Reaction* r = m->createReaction();
+  r->setId("J20");
+  r->createReactant()->setSpecies("Node0");
+  r->createProduct()->setSpecies("Node15");
+
+  EXPECT_EQ(3, gf_updateLayout(l, edited));
+
+  EXPECT_TRUE(net->findReactionById("J19") == NULL);
+  ASSERT_TRUE(net->findNodeById("Node15") != NULL);
+  ASSERT_TRUE(net->findReactionById("J20") != NULL);
+  EXPECT_EQ(nodepos.size() + 1, net->getTotalNumNodes());
+  EXPECT_EQ(rxnpos.size() + 1, net->getTotalNumRxns());
+
+  uint64 kept = 0;
+  for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i) {
+    std::map<const Node*, Graphfab::Point>::const_iterator k = nodepos.find(*i);
+    if (k == nodepos.end())
+      continue;
+    ++kept;
+    EXPECT_EQ(k->second.x, (*i)->getCentroid().x) << (*i)->getId();
+    EXPECT_EQ(k->second.y, (*i)->getCentroid().y) << (*i)->getId();
+  }
+  EXPECT_EQ(nodepos.size(), kept);
+
+  kept = 0;
+  for (Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+    std::map<const Graphfab::Reaction*, Graphfab::Point>::const_iterator k = rxnpos.find(*i);
+    if (k == rxnpos.end())
+      continue;
+    ++kept;
+    EXPECT_EQ(k->second.x, (*i)->getCentroid().x) << (*i)->getId();
+    EXPECT_EQ(k->second.y, (*i)->getCentroid().y) << (*i)->getId();
+  }
+  EXPECT_EQ(rxnpos.size(), kept);
+
+  // nothing left to do
+  EXPECT_EQ(0, gf_updateLayout(l, edited));
+
+  gf_freeSBMLModel(edited);
+  gf_freeModelAndLayout(mod, l);
+}